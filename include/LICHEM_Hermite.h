@@ -50,5 +50,105 @@ class HermGau
     double value(double,double,double); //Return the magnitude at (x,y,z)
 };
 
+class BoysTable
+{
+  //Class for tabulated Boys function values
+  public:
+    //Constructor
+    BoysTable();
+    //Destructor
+    ~BoysTable();
+    //Grid of values
+    int Npts; //Number of grid points
+    int Nord; //Number of orders at each point
+    vector<double> vals; //Values stored by point and then by order
+};
+
+class HermBasisSet
+{
+  //Class for a database of Hermite Gaussian basis sets
+  //NB: Element and basis names are stored as integer IDs, and each block of
+  //functions is shared by every atom which uses it
+  private:
+    map<string,int> elemIDs_; //IDs of the element names
+    map<string,int> basisIDs_; //IDs of the basis set names
+    map<pair<int,int>,int> blockIDs_; //Block for each basis and element
+    vector<string> elemNames_; //Name of each element ID
+    vector<int> blockElem_; //Element ID of each block
+    vector<vector<HermGau> > blocks_; //Basis functions in each block
+    vector<MPole> poles_; //Local frame multipoles of each block
+    vector<double> dispC6_; //C6 of each block (eV Ang^6)
+    vector<double> dispEps_; //Buffered 14-7 well depth of each block (eV)
+    vector<double> dispRmin_; //Buffered 14-7 minimum of each block (Ang)
+  public:
+    //Constructor
+    HermBasisSet();
+    //Destructor
+    ~HermBasisSet();
+    //Functions to manipulate the database
+    int elementID(string); //Return the ID of an element name
+    int basisID(string); //Return the ID of a basis set name
+    int findBlock(string,string); //Return the block of an element and basis
+    void readFile(string); //Add the basis sets in a data file
+    vector<HermGau>& block(int); //Return the functions in a block
+    MPole blockDM(int); //Calculate the multipoles of a block
+    MPole blockDMRef(int); //Reference multipoles of a block
+    MPole& blockPoles(int); //Return the cached multipoles of a block
+    double checkPoles(); //Compare the cached multipoles to the reference
+    void blockDisp(int,double&,double&,double&); //Return dispersion terms
+};
+
+class GEMBatch
+{
+  //Class for packed GEM densities
+  //NB: Functions with the same exponent and Hermite orders are grouped
+  public:
+    //Constructor
+    GEMBatch();
+    //Destructor
+    ~GEMBatch();
+    //Packed basis functions
+    int Nfuncs; //Number of basis functions
+    vector<int> atom; //Atom for each function
+    vector<double> mag; //Coefficients
+    vector<double> alpha; //Exponents (a.u.)
+    vector<double> x; //X positions (a.u.)
+    vector<double> y; //Y positions (a.u.)
+    vector<double> z; //Z positions (a.u.)
+    //Groups of functions
+    int Ngroups; //Number of groups
+    vector<int> groupStart; //First function in each group (Ngroups+1)
+    vector<int> groupX; //Hermite X order of each group
+    vector<int> groupY; //Hermite Y order of each group
+    vector<int> groupZ; //Hermite Z order of each group
+};
+
+class GEMNeighborList
+{
+  //Verlet neighbor list for GEM dispersion
+  //NB: Pairs within the cutoff plus a skin are stored, so the list is only
+  //rebuilt after a site moves more than half of the skin
+  public:
+    //Constructor
+    GEMNeighborList();
+    //Destructor
+    ~GEMNeighborList();
+    //Sites
+    int bead; //Bead used to build the list
+    int Nsites; //Number of sites
+    vector<int> site; //Atom of each site
+    vector<double> C6; //C6 of each site (eV Ang^6)
+    vector<double> eps; //Buffered 14-7 well depth of each site (eV)
+    vector<double> Rmin; //Buffered 14-7 minimum of each site (Ang)
+    vector<double> x0; //X positions when the list was built
+    vector<double> y0; //Y positions when the list was built
+    vector<double> z0; //Z positions when the list was built
+    double box[3]; //Box size when the list was built
+    //Neighbors
+    vector<int> start; //First neighbor of each site (Nsites+1)
+    vector<int> nbrs; //Neighboring sites with larger indices
+    int Nbuilds; //Number of times the list was built
+};
+
 #endif
 
@@ -58,6 +58,37 @@ class Coord
     double vecMag(); //Return the squared vector magnitude
 };
 
+class PBCBox
+{
+  //Periodic cell for minimum image displacements
+  //NB: The cell vectors are a = (ax,0,0), b = (bx,by,0), and
+  //c = (cx,cy,cz), which is the LAMMPS convention for triclinic cells
+  public:
+    //Constructor
+    PBCBox();
+    //Destructor
+    ~PBCBox();
+    //Cell vectors
+    double ax; //x component of a
+    double bx; //x component of b
+    double by; //y component of b
+    double cx; //x component of c
+    double cy; //y component of c
+    double cz; //z component of c
+    //Inverse widths of the cell (zero without PBC)
+    double invAx; //Inverse of ax
+    double invBy; //Inverse of by
+    double invCz; //Inverse of cz
+    bool triclinic; //Flag for a non-orthogonal cell
+    //Functions
+    void update(); //Rebuild the cell from the box size and angles
+    void minImage(double&,double&,double&); //Wrap a displacement
+    void scale(double); //Change the length units of the cell
+    double volume(); //Return the volume of the cell
+    void widths(double&,double&,double&); //Distances between cell faces
+    void fracCoords(double,double,double,double&,double&,double&);
+};
+
 class MPole
 {
   //Cartesian multipoles
@@ -91,6 +122,74 @@ class MPole
     double Qzz;
 };
 
+//Multipole local frame types
+enum MPFrameType
+{
+  FrameNone = 0, //No rotation (global frame)
+  FrameBisector, //Bisector
+  FrameZThenX, //Z-then-X
+  FrameZBisect, //Z-Bisect
+  Frame3Fold, //3-Fold
+  FrameZOnly, //Z-Only
+  NFrameTypes //Number of frame types
+};
+
+class MPFrameTable
+{
+  //Multipole local frames sorted by frame type (structure of arrays)
+  public:
+    //Constructor
+    MPFrameTable();
+    //Destructor
+    ~MPFrameTable();
+    //Table of frames
+    int Nframes; //Number of frames in the table
+    int Nblocks; //Number of blocks with a single frame type
+    vector<int> blockTyp; //Frame type of each block
+    vector<int> blockStart; //First frame of each block (Nblocks+1)
+    vector<int> atom0; //Atom with the multipole
+    vector<int> atom1; //Atom which defines the z axis
+    vector<int> atom2; //Atom which defines the x axis
+    vector<int> atom3; //Atom which defines the y axis
+};
+
+class TopologyTable
+{
+  //Bonded topology in compressed sparse row (CSR) format
+  //NB: Each list is sorted, and the 1-3 and 1-4 lists only contain atoms
+  //where the shortest path has two or three bonds
+  public:
+    //Constructor
+    TopologyTable();
+    //Destructor
+    ~TopologyTable();
+    //Graph of the atoms
+    int Nnodes; //Number of atoms in the graph
+    vector<int> start12; //First 1-2 neighbor of each atom (Nnodes+1)
+    vector<int> list12; //1-2 connected atoms
+    vector<int> start13; //First 1-3 neighbor of each atom (Nnodes+1)
+    vector<int> list13; //1-3 connected atoms
+    vector<int> start14; //First 1-4 neighbor of each atom (Nnodes+1)
+    vector<int> list14; //1-4 connected atoms
+};
+
+class FIREState
+{
+  //Step control of the FIRE optimizer for reaction paths
+  public:
+    //Constructor
+    FIREState();
+    //Destructor
+    ~FIREState();
+    //Step control
+    double dt; //Time step
+    double dtMax; //Largest time step
+    double alpha; //Velocity mixing parameter
+    int downhillCt; //Number of downhill steps
+    //Functions
+    void reset(double); //Start from the initial time step
+};
+
 class RedMPole
 {
   //Reduced multipole from sph. harm. and diagonalization
@@ -114,6 +213,23 @@ class RedMPole
     Vector3d vecZ; //Z direction in quadrupole frame
 };
 
+class IntCoord
+{
+  //A redundant internal coordinate for the QM optimizer
+  public:
+    //Constructor
+    IntCoord();
+    //Destructor
+    ~IntCoord();
+    //Definition of the coordinate (indices refer to the QM and PB atoms)
+    int type; //0: Cartesian, 1: Bond, 2: Angle, 3: Dihedral
+    int atom1; //First atom
+    int atom2; //Second atom (Cartesian direction: x=0,y=1,z=2)
+    int atom3; //Third atom
+    int atom4; //Fourth atom
+    double kGuess; //Force constant for the model Hessian
+};
+
 class OctCharges
 {
   //A grid of point-charges which replaces multipoles
@@ -148,6 +264,12 @@ class OctCharges
     double x6; //Position of charge 6
     double y6; //Position of charge 6
     double z6; //Position of charge 6
+    //Source of the grid (avoids rebuilding unchanged grids)
+    bool gridSet; //Flag for a saved source
+    double srcX; //Position of the atom
+    double srcY; //Position of the atom
+    double srcZ; //Position of the atom
+    double srcPoles[10]; //Global frame q, dipole, and quadrupole
 };
 
 #endif
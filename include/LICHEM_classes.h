@@ -29,7 +29,7 @@ class GEMDen
     int atom2_; //Atom which defines the x axis
     int atom3_; //Atom which defines the y axis (chiral only)
     //Basis functions and density
-    vector<HermGau> dens_; //GEM density
+    int block_; //Shared block of functions in the basis set database
   public:
     //Constructors
     GEMDen();
@@ -39,7 +39,10 @@ class GEMDen
     //Functions to manipulate GEM density
     void setBasis(string,string); //Sets the Hermite basis
     void setFrame(bool,string,int,int,int); //Sets the frame of reference
+    void getFrame(bool&,string&,int&,int&,int&); //Returns the frame
     MPole GEMDM(); //Function to generate multipoles from density
+    vector<HermGau>& basis(); //Return the density functions
+    int blockID(); //Return the shared block in the basis set database
 };
 
 //LICHEM particle data structures
@@ -55,6 +58,7 @@ class QMMMAtom
     double Ep; //Path-integral energies
     //Regions
     bool NEBActive; //Included in NEB tangent calculations
+    bool hessActive; //Displaced in finite-difference Hessians
     bool QMRegion; //QM, MM, pseudo-bond, or boundary-atom
     bool MMRegion; //QM, MM, pseudo-bond, or boundary-atom
     bool PBRegion; //QM, MM, pseudo-bond, or boundary-atom
@@ -89,6 +93,11 @@ class QMMMSettings
     //Input needed for QM wrappers
     string func; //QM method (functional, HF, etc)
     string basis; //Basis set for QM calculations
+    string GEMBasis; //Hermite basis set for GEM densities
+    string GEMBasisFile; //Data file with the Hermite basis sets
+    bool GEMCube; //Write the GEM density to a cube file
+    bool GEMDebug; //Print the GEM Coulomb energies
+    bool GEMDisp; //Add the GEM dispersion energy
     int RAM; //Ram for QM calculations
     bool memMB; //Is the RAM in mb or gb
     int charge; //QM total charge
@@ -99,6 +108,7 @@ class QMMMSettings
     bool useLREC; //Use a long-range correction
     double LRECCut; //Cutoff for the long-range correction
     int LRECPow; //Exponent for the LREC smoothing function
+    double embedTol; //Potential tolerance for compressing MM multipoles
     //Input needed for MM wrappers
     bool useMMCut; //Flag to turn the cutoff on or off
     double MMOptCut; //Electrostatic cutoff for MM optimzations (Ang)
@@ -121,14 +131,24 @@ class QMMMSettings
     double QMOptTol; //Criteria to end the optimization
     double stepScale; //Steepest descent step size (Ang)
     double maxStep; //Maximum size of the optimization step
+    int BFGSHist; //Number of stored L-BFGS updates
+    string convMetric; //RMS deviation metric: Matrix, Neighbor, or Kabsch
+    double convCut; //Cutoff for the neighbor RMS deviation metric
+    bool microIter; //Flag to relax the MM region after each QM step
+    double microDisp; //QM displacement which triggers an MM relaxation
     //Input needed for reaction paths
     double kSpring; //Elastic band spring constant
     int TSBead; //Current guess of the transition state
     bool climb; //Flag to turn on climbing image NEB
+    int maxBeads; //Largest number of beads for the growing string
     bool frznEnds; //Flag to freeze the NEB end points
     bool NEBFreq; //Flag to calculate TS frequencies after NEB
     bool printNormModes; //Print normal modes for pure QM calculations
     bool startPathChk; //Flag to initially use checkpoints from nearby beads
+    //Input needed for frequency calculations
+    bool FDHess; //Flag to calculate Hessians from finite differences
+    double FDStep; //Finite-difference displacement (Ang)
+    int FDJobs; //Number of concurrent finite-difference gradients
     //Storage of energies (NEB and PIMC)
     double EOld; //Temporary storage
     double EReact; //Reactant energy
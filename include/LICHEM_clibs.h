@@ -40,6 +40,7 @@
 #include <iomanip>
 #include <sstream>
 #include <string>
+#include <cstring>
 #include <complex>
 #include <cmath>
 #include <fstream>
@@ -37,6 +37,11 @@ namespace LICHEMGlobal
   double Lx = 10000.0; //Box length
   double Ly = 10000.0; //Box length
   double Lz = 10000.0; //Box length
+  double boxAlpha = 90.0; //Box angle between b and c (degrees)
+  double boxBeta = 90.0; //Box angle between a and c (degrees)
+  double boxGamma = 90.0; //Box angle between a and b (degrees)
+  map<int,vector<double> > savedFields; //Saved MM fields (x,y,z,q) by bead
+  bool embedPrinted = 0; //Flag to only print the MM embedding summary once
 
   //Flags for simulation options
   bool GEM = 0; //Flag for frozen density QMMM potential
@@ -54,7 +59,10 @@ namespace LICHEMGlobal
   bool OptSim = 0; //Flag for energy minimization with QM packages
   bool SteepSim = 0; //Flag for steepest descent minimization in LICHEM
   bool DFPSim = 0; //Flag for DFP minimization in LICHEM
+  bool BFGSSim = 0; //Flag for L-BFGS minimization in LICHEM
+  bool RICSim = 0; //Flag for internal coordinate minimization in LICHEM
   bool NEBSim = 0; //Flag for NEB path optimization in LICHEM
+  bool StringSim = 0; //Flag for string method path optimization in LICHEM
   bool PIMCSim = 0; //Flag for Monte Carlo
   bool FBNEBSim = 0; //Flag for force-bias NEB Monte Carlo
   bool FreqCalc = 0; //Flag for a frequency calculation
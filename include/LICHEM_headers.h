@@ -41,6 +41,24 @@ using namespace LICHEMGlobal;
 //Set up periodic table
 PeriodicTable chemTable;
 
+//Set up the multipole frame table
+MPFrameTable mpFrames;
+
+//Set up the periodic cell
+PBCBox pbcBox;
+
+//Set up the bonded topology
+TopologyTable topoTab;
+
+//Set up the Boys function grid
+BoysTable boysTab;
+
+//Set up the Hermite basis set database
+HermBasisSet hermBasisDB;
+
+//Set up the GEM dispersion neighbor lists for each bead
+vector<GEMNeighborList> gemNbrLists;
+
 //Function declarations (alphabetical)
 bool Angled(vector<QMMMAtom>&,int,int);
 
@@ -50,16 +68,37 @@ bool Bonded(vector<QMMMAtom>&,int,int);
 
 double BoysFunc(int,double);
 
+void BoysFuncAll(int,double,double*);
+
+void BoysFuncBatch(int,int,double*,double*);
+
+double BoysSeries(int,double);
+
+vector<IntCoord> BuildIntCoords(vector<QMMMAtom>&,int);
+
+void BuildMMField(vector<QMMMAtom>&,QMMMSettings&,int,vector<double>&);
+
+void BuildMPFrames(vector<QMMMAtom>&);
+
+void BuildTopology(vector<QMMMAtom>&);
+
 void BurstTraj(vector<QMMMAtom>&,QMMMSettings&);
 
 RedMPole Cart2SphHarm(MPole&);
 
 VectorXd CINEBTangent(VectorXd&,VectorXd&,QMMMSettings&,int);
 
+void ClearMMField(int);
+
 bool CheckFile(const string&);
 
+void CheckGEMPoles(int&,char**&);
+
 void CheckNEBTangent(VectorXd&);
 
+double ConvRMSDev(vector<QMMMAtom>&,vector<QMMMAtom>&,QMMMSettings&,int,
+                  bool);
+
 Coord CoordDist2(Coord&,Coord&);
 
 bool Dihedraled(vector<QMMMAtom>&,int,int);
@@ -71,7 +110,10 @@ void ExtractGlobalPoles(int& argc, char**& argv);
 void ExtractTINKpoles(vector<QMMMAtom>&,int);
 
 int FBNEBMCMove(vector<QMMMAtom>&,vector<VectorXd>&,QMMMSettings&,
-                VectorXd&);
+                VectorXd&,VectorXd&,VectorXd&,int&);
+
+double FBNEBSpring(vector<QMMMAtom>&,vector<QMMMAtom>&,VectorXd&,
+                   QMMMSettings&,int);
 
 void FetchQuotes(vector<string>&);
 
@@ -81,6 +123,8 @@ Coord FindQMCOM(vector<QMMMAtom>&,QMMMSettings&,int);
 
 void FindTINKERClasses(vector<QMMMAtom>&);
 
+string FindTINKERParams();
+
 void GaussianCharges(vector<QMMMAtom>&,QMMMSettings&,int);
 
 double GaussianEnergy(vector<QMMMAtom>&,QMMMSettings&,int);
@@ -95,20 +139,82 @@ double GaussianOpt(vector<QMMMAtom>&,QMMMSettings&,int);
 
 double GEMBuffC7(double,double,Coord&,Coord&,double);
 
+void GEMBuildNeighbors(vector<QMMMAtom>&,GEMNeighborList&,int);
+
 double GEMC6(double,Coord&,Coord&,double);
 
+double GEMChargeCoulomb(GEMBatch&,vector<double>&);
+
+double GEMChargeEnergy(vector<QMMMAtom>&,int);
+
+bool GEMCheckNeighbors(vector<QMMMAtom>&,GEMNeighborList&,int);
+
+double GEMCoulomb(GEMBatch&,GEMBatch&,bool);
+
+double GEMCoulombEnergy(vector<QMMMAtom>&,int);
+
+void GEMDensityPoints(GEMBatch&,int,double*,double*,double*,double*);
+
+double GEMDispEnergy(vector<QMMMAtom>&,GEMNeighborList&,int);
+
+double GEMEwaldPairs(int,int,int,double,double,double,bool,int,double*,
+                     double*,double*,double*);
+
+double GEMFlushPairs(GEMBatch&,double,bool,vector<int>&,
+                     vector<vector<double> >&,vector<vector<double> >&,
+                     vector<vector<double> >&,vector<vector<double> >&);
+
+Matrix3d GEMFrame(vector<QMMMAtom>&,int,int);
+
+void GEMGridCells(GEMBatch&,int*,vector<int>&,vector<int>&);
+
+double GEMGridChargeCoulomb(GEMBatch&,vector<double>&);
+
+double GEMGridCoulomb(GEMBatch&);
+
+void GEMGridPotential(GEMBatch&,vector<double>&,vector<double>&);
+
+void GEMGridSetup(int&,int&,int&,double&);
+
+void GEMGridSolve(vector<double>&,int,int,int,vector<double>&);
+
+void GEMGridSpread(GEMBatch&,double,int,int,int,vector<double>&);
+
+void GEMHermRotate(Matrix3d&,int,int,int,vector<int>&,vector<int>&,
+                   vector<int>&,vector<double>&);
+
+void GEMHornerBlock(int,int,const double*,double*,double*,double*);
+
+double GEMPairSum(int,int,int,double,int,double*,double*,double*,double*);
+
+double GEMTaper(double,double,double&);
+
+void GetMMField(vector<QMMMAtom>&,QMMMSettings&,int,vector<double>&);
+
 double Get_PI_Espring(vector<QMMMAtom>&,QMMMSettings&);
 
 double Get_PI_Epot(vector<QMMMAtom>&,QMMMSettings&);
 
-vector<HermGau> HermBasis(string,string);
+int HermBasis(string,string);
 
 double HermCoul1e(HermGau&,double,Coord&);
 
 double HermCoul2e(HermGau&,HermGau&);
 
+double HermGau1D(int,double,double);
+
+double HermMoment1D(int,double,int,double);
+
 double HermOverlap(HermGau&,HermGau&);
 
+void HermiteRTable(int,double,double,double,double,double*);
+
+template<int> void HermiteRTable(double,double,double,double,double*);
+
+MatrixXd IntCoordGInv(MatrixXd&);
+
+VectorXd IntCoordValues(vector<IntCoord>&,VectorXd&);
+
 VectorXd KabschDisplacement(MatrixXd&,MatrixXd&,int);
 
 void KabschRotation(MatrixXd&,MatrixXd&,int);
@@ -127,6 +233,8 @@ void LICHEM2BASIS(int&,char**&);
 
 void LICHEM2TINK(int&,char**&);
 
+void LICHEMBFGS(vector<QMMMAtom>&,QMMMSettings&,int);
+
 template<typename T> int LICHEMCount(T);
 
 double LICHEMDensity(vector<QMMMAtom>&,QMMMSettings&);
@@ -135,29 +243,52 @@ void LICHEMDFP(vector<QMMMAtom>&,QMMMSettings&,int);
 
 void LICHEMErrorChecker(QMMMSettings&);
 
+inline double LICHEMExp(double);
+
 double LICHEMFactorial(int);
 
+MatrixXd LICHEMFDHessian(vector<QMMMAtom>&,QMMMSettings&,int);
+
+void LICHEMFFT1D(complex<double>*,int,bool);
+
+void LICHEMFFT3D(vector<complex<double> >&,int,int,int,bool);
+
 void LICHEMFixSciNot(string&);
 
+double LICHEMForces(vector<QMMMAtom>&,VectorXd&,QMMMSettings&,int,bool);
+
 template<typename T> string LICHEMFormFloat(T,int);
 
 VectorXd LICHEMFreq(vector<QMMMAtom>&,MatrixXd&,QMMMSettings&,int,int&);
 
+void LICHEMIntOpt(vector<QMMMAtom>&,QMMMSettings&,int);
+
 void LICHEMLowerText(string&);
 
-void LICHEMNEB(vector<QMMMAtom>&,QMMMSettings&,int);
+void LICHEMNEB(vector<QMMMAtom>&,MatrixXd&,QMMMSettings&,VectorXd&,
+               vector<int>&,int);
 
 void LICHEMPrintSettings(vector<QMMMAtom>&,QMMMSettings&);
 
 void LICHEMSteepest(vector<QMMMAtom>&,QMMMSettings&,int);
 
+int LICHEMString(vector<QMMMAtom>&,QMMMSettings&,int);
+
 void LICHEMUpperText(string&);
 
 double LRECFunction(Coord&,QMMMSettings&);
 
 bool MCMove(vector<QMMMAtom>&,QMMMSettings&,double&);
 
-VectorXd NEBTangent(VectorXd&,VectorXd&,QMMMSettings&,int);
+void MicroIterMM(vector<QMMMAtom>&,QMMMSettings&,double,int);
+
+void MinImageManyToMany(int,double*,double*,double*,int,double*,double*,
+                        double*,double*,double*,double*);
+
+void MinImageOneToMany(double,double,double,int,double*,double*,double*,
+                       double*,double*,double*);
+
+VectorXd NEBTangent(VectorXd&,VectorXd&,VectorXd&,QMMMSettings&,int);
 
 void NWChemCharges(vector<QMMMAtom>&,QMMMSettings&,int);
 
@@ -172,13 +303,47 @@ double NWChemOpt(vector<QMMMAtom>&,QMMMSettings&,int);
 bool OptConverged(vector<QMMMAtom>&,vector<QMMMAtom>&,VectorXd&,
                   int,QMMMSettings&,int,bool);
 
+void PackConvCoords(vector<QMMMAtom>&,int,bool,vector<double>&,
+                    vector<double>&,vector<double>&,vector<bool>&);
+
+void PackGEMDensity(vector<QMMMAtom>&,vector<int>&,int,GEMBatch&);
+
+MPole PackGEMDM(double,double[3],double[3][3]);
+
 bool PathConverged(vector<QMMMAtom>&,vector<QMMMAtom>&,MatrixXd&,
                    int,QMMMSettings&,bool);
 
+double PathCoordDev(MatrixXd&,MatrixXd&,int,int);
+
+MatrixXd PathCoords(vector<QMMMAtom>&,QMMMSettings&);
+
+void PathDisplacements(vector<QMMMAtom>&,VectorXd&,VectorXd&,int);
+
+void PathFIREStep(vector<QMMMAtom>&,QMMMSettings&,MatrixXd&,MatrixXd&,
+                  FIREState&,int,int);
+
+int PathForces(vector<QMMMAtom>&,QMMMSettings&,vector<int>&,VectorXd&,
+               MatrixXd&);
+
+int PathGrowthBead(vector<QMMMAtom>&,QMMMSettings&,VectorXd&);
+
+void PathInsertBead(vector<QMMMAtom>&,QMMMSettings&,int);
+
 void PathLinInterpolate(int&,char**&);
 
+void PathMMFields(vector<QMMMAtom>&,QMMMSettings&,bool);
+
+void PathProjForces(vector<QMMMAtom>&,QMMMSettings&,VectorXd&,MatrixXd&,
+                    MatrixXd&,MatrixXd&,int,int,bool);
+
+VectorXd PathReactCoord(vector<QMMMAtom>&,QMMMSettings&);
+
+void PathReparam(vector<QMMMAtom>&,VectorXd&,int,int);
+
 void PBCCenter(vector<QMMMAtom>&,QMMMSettings&);
 
+void PoleditTINKpoles(vector<QMMMAtom>&,int);
+
 void PrintFancyTitle();
 
 void PrintLapin();
@@ -200,8 +365,22 @@ void ReadArgs(int&,char**&,fstream&,fstream&,fstream&,fstream&);
 void ReadLICHEMInput(fstream&,fstream&,fstream&,
                      vector<QMMMAtom>&,QMMMSettings&);
 
+void ReadTINKpoleFile(string,vector<int>&,vector<int>&,vector<int>&,
+                      vector<int>&,vector<MPole>&);
+
+double RMSDevKabsch(vector<QMMMAtom>&,vector<QMMMAtom>&,int,bool);
+
+double RMSDevMatrix(vector<QMMMAtom>&,vector<QMMMAtom>&,int,bool);
+
+double RMSDevNeighbor(vector<QMMMAtom>&,vector<QMMMAtom>&,QMMMSettings&,int,
+                      bool);
+
 void RotateTINKCharges(vector<QMMMAtom>&,int);
 
+void RotateTINKPoles(vector<QMMMAtom>&,vector<MPole>&,int);
+
+void SaveMMField(vector<QMMMAtom>&,QMMMSettings&,int);
+
 OctCharges SphHarm2Charges(RedMPole);
 
 void SplitPathTraj(int&,char**&);
@@ -226,10 +405,12 @@ double TINKERPolForces(vector<QMMMAtom>&,VectorXd&,QMMMSettings&,int);
 
 vector<int> TraceBoundary(vector<QMMMAtom>&,int);
 
-void WriteChargeFile(vector<QMMMAtom>&,QMMMSettings&,int);
+MatrixXd WilsonBMatrix(vector<IntCoord>&,VectorXd&);
 
 void WriteGauInput(vector<QMMMAtom>&,string,QMMMSettings&,int);
 
+void WriteGEMCube(vector<QMMMAtom>&,string,int);
+
 void WriteNWChemInput(vector<QMMMAtom>&,string,QMMMSettings&,int);
 
 void WriteModes(vector<QMMMAtom>&,bool,VectorXd&,MatrixXd&,QMMMSettings&,int);
@@ -244,6 +425,7 @@ void WriteQMConnect(int&,char**&);
 #include "Analysis.cpp"
 #include "Basis.cpp"
 #include "Basis_sets.cpp"
+#include "Convergence.cpp"
 #include "Core_funcs.cpp"
 #include "Frozen_density.cpp"
 #include "Hermite_eng.cpp"
@@ -22,6 +22,34 @@ namespace LICHEMOpts
   //Compile options
   const bool JOKES = 0; //Print humorous comments
 
+  //Multipole options
+  const int mpBlock = 64; //Maximum number of atoms in a frame rotation block
+  const double mpGridTol = 1e-8; //Multipole change (a.u.) to rebuild a grid
+
+  //Gaussian integral options
+  const int boysMaxOrder = 16; //Largest tabulated Boys function order
+  const int boysTaylor = 7; //Terms in the Boys function Taylor series
+  const double boysStep = 0.05; //Spacing of the Boys function grid (a.u.)
+  const double boysMaxX = 36.0; //Largest argument on the Boys function grid
+  const int hermMaxL = 8; //Largest total order of the Hermite integrals
+  const double gemScreen = 1e-12; //Overlap to treat GEM pairs as multipoles
+  const double gemGridSpace = 0.4; //Largest GEM grid spacing (Angstroms)
+  const double gemEwaldCut = 8.0; //GEM real-space Ewald cutoff (Angstroms)
+  const double gemDispCut = 9.0; //GEM dispersion cutoff (Angstroms)
+  const double gemDispSkin = 1.0; //GEM neighbor list skin (Angstroms)
+  const double gemDispTaper = 0.9; //Fraction of the cutoff to start tapering
+  const double gemCubeSpace = 0.2; //GEM cube file grid spacing (Angstroms)
+  const double gemCubePad = 4.0; //Margin around the atoms in cube files (Ang)
+  const double gemPoleTol = 1e-10; //Largest error in the cached GEM multipoles
+
+  //FIRE path optimizer options
+  const double fireAlpha = 0.1; //Initial velocity mixing parameter
+  const double fireAlphaDec = 0.99; //Mixing parameter decrease
+  const double fireDtMax = 10.0; //Largest time step (units of the first)
+  const double fireDtInc = 1.1; //Time step increase after downhill steps
+  const double fireDtDec = 0.5; //Time step decrease after uphill steps
+  const int fireMinDownhill = 5; //Downhill steps before increasing dt
+
   //Monte Carlo options
   const bool isotrop = 1; //Force isotropic expansion in NPT Monte Carlo
   const double stepMin = 0.005; //Minimum Monte Carlo step size (Angstroms)
@@ -603,8 +603,10 @@ void KabschRotation(MatrixXd& A, MatrixXd& B, int matSize)
   Ident.setIdentity();
   Ident(2,2) *= signVal; //Change sign for rotation
   //Find optimal rotation matrix
-  rotMat = SVDMat.matrixV()*Ident*(SVDMat.matrixU().transpose());
-  //Rotate matrix A
+  //NB: The positions are stored as rows, so the transpose of the
+  //rotation matrix, V*Ident*U^T, is applied from the right
+  rotMat = SVDMat.matrixU()*Ident*(SVDMat.matrixV().transpose());
+  //Rotate matrix B
   B *= rotMat;
   //Return the modified positions
   return;
@@ -642,7 +644,7 @@ double LICHEMDensity(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
     rho += QMMMData[i].m;
   }
   //Divide by the volume
-  rho /= (Lx*Ly*Lz);
+  rho /= pbcBox.volume();
   //Change units to SI
   rho *= (amu2kg*m2Ang*m2Ang*m2Ang);
   //Change to g/cm^3
@@ -651,6 +653,148 @@ double LICHEMDensity(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
   return rho;
 };
 
+MatrixXd LICHEMFDHessian(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
+                         int bead)
+{
+  //Function to calculate the QMMM Hessian from central differences of the
+  //forces on the QM and PB atoms
+  //NB: Each displaced geometry is evaluated in a scratch bead after the
+  //last bead, so that several gradient calculations can run at once
+  stringstream call; //Stream for system calls
+  int Ndof = 3*(Nqm+Npseudo); //Number of degrees of freedom
+  double h = QMMMOpts.FDStep; //Displacement (Ang)
+  MatrixXd QMMMHess(Ndof,Ndof); //Hessian (a.u.)
+  VectorXd activeDOF(Ndof); //Mask for the displaced degrees of freedom
+  vector<int> QMIDs; //Atom IDs of the QM and PB atoms
+  vector<int> dispDOF; //List of displaced degrees of freedom
+  QMMMHess.setZero();
+  activeDOF.setZero();
+  //Locate the displaced atoms
+  for (int i=0;i<Natoms;i++)
+  {
+    if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+    {
+      int ct = 3*QMIDs.size(); //Position in the Hessian
+      if (QMMMData[i].hessActive)
+      {
+        for (int j=0;j<3;j++)
+        {
+          dispDOF.push_back(ct+j);
+          activeDOF(ct+j) = 1;
+        }
+      }
+      QMIDs.push_back(i);
+    }
+  }
+  int Ndisp = 2*dispDOF.size(); //Number of displaced geometries
+  if (Ndisp == 0)
+  {
+    //Nothing to displace
+    return QMMMHess;
+  }
+  int Njobs = QMMMOpts.FDJobs; //Number of concurrent gradients
+  if (Njobs > Ndisp)
+  {
+    Njobs = Ndisp;
+  }
+  int firstSlot = QMMMOpts.NBeads; //Bead ID of the first scratch bead
+  //Create scratch beads
+  vector<QMMMAtom> FDData = QMMMData;
+  #pragma omp parallel for schedule(dynamic)
+  for (int i=0;i<Natoms;i++)
+  {
+    for (int k=0;k<Njobs;k++)
+    {
+      FDData[i].P.push_back(QMMMData[i].P[bead]);
+      FDData[i].MP.push_back(QMMMData[i].MP[bead]);
+      FDData[i].PC.push_back(QMMMData[i].PC[bead]);
+    }
+  }
+  //Start each job from the current wavefunction
+  call.str("");
+  call << "LICHM_" << bead << ".chk";
+  if (Gaussian and CheckFile(call.str()))
+  {
+    for (int k=0;k<Njobs;k++)
+    {
+      call.str("");
+      call << "cp LICHM_" << bead << ".chk ";
+      call << "LICHM_" << (firstSlot+k) << ".chk";
+      globalSys = system(call.str().c_str());
+    }
+  }
+  //Split the processors between the jobs
+  int oldNcpus = Ncpus; //Save the number of processors
+  Ncpus /= Njobs;
+  if (Ncpus < 1)
+  {
+    Ncpus = 1;
+  }
+  //Calculate forces for all displaced geometries
+  MatrixXd FDForces(Ndof,Ndisp); //Forces for each displacement
+  FDForces.setZero();
+  #pragma omp parallel for schedule(dynamic) num_threads(Njobs)
+  for (int n=0;n<Ndisp;n++)
+  {
+    int slot = firstSlot+omp_get_thread_num(); //Scratch bead
+    int dof = dispDOF[n/2]; //Displaced degree of freedom
+    int atomID = QMIDs[dof/3]; //Displaced atom
+    double disp = h; //Forward displacement
+    if ((n%2) == 1)
+    {
+      disp = -h; //Backward displacement
+    }
+    //Displace the atom
+    if ((dof%3) == 0)
+    {
+      FDData[atomID].P[slot].x += disp;
+    }
+    if ((dof%3) == 1)
+    {
+      FDData[atomID].P[slot].y += disp;
+    }
+    if ((dof%3) == 2)
+    {
+      FDData[atomID].P[slot].z += disp;
+    }
+    if (Nmm > 0)
+    {
+      SaveMMField(FDData,QMMMOpts,slot);
+    }
+    //Calculate forces
+    VectorXd forces(Ndof); //Forces for this displacement
+    LICHEMForces(FDData,forces,QMMMOpts,slot,0);
+    FDForces.col(n) = forces;
+    //Restore the atom
+    FDData[atomID].P[slot] = QMMMData[atomID].P[bead];
+  }
+  Ncpus = oldNcpus; //Restore the number of processors
+  //Clean up the scratch beads
+  if (PSI4)
+  {
+    //Delete annoying useless files
+    globalSys = system("rm -f psi.* timer.*");
+  }
+  for (int k=0;k<Njobs;k++)
+  {
+    call.str("");
+    call << "rm -f LICHM_" << (firstSlot+k) << ".*";
+    globalSys = system(call.str().c_str());
+    ClearMMField(firstSlot+k);
+  }
+  //Assemble the Hessian from the central differences
+  for (unsigned int j=0;j<dispDOF.size();j++)
+  {
+    int dof = dispDOF[j]; //Displaced degree of freedom
+    VectorXd dF = FDForces.col(2*j)-FDForces.col(2*j+1);
+    QMMMHess.col(dof) = -dF.cwiseProduct(activeDOF)/(2*h);
+  }
+  //Symmetrize and change units to a.u.
+  QMMMHess = 0.5*(QMMMHess+QMMMHess.transpose());
+  QMMMHess *= (bohrRad*bohrRad/har2eV);
+  return QMMMHess;
+};
+
 VectorXd LICHEMFreq(vector<QMMMAtom>& QMMMData, MatrixXd& QMMMHess,
                     QMMMSettings& QMMMOpts, int bead, int& remCt)
 {
@@ -841,6 +985,116 @@ VectorXd LICHEMFreq(vector<QMMMAtom>& QMMMData, MatrixXd& QMMMHess,
   return QMMMFreqs;
 };
 
+void WriteGEMCube(vector<QMMMAtom>& QMMMData, string fileName, int bead)
+{
+  //Writes the GEM density of the MM atoms to a Gaussian cube file
+  //NB: The grid covers the atoms plus a margin, without periodic images
+  vector<int> MMAtoms; //Atoms with GEM densities
+  for (int i=0;i<Natoms;i++)
+  {
+    if (QMMMData[i].MMRegion and (((int)QMMMData[i].GEM.size()) > bead))
+    {
+      MMAtoms.push_back(i);
+    }
+  }
+  if (MMAtoms.empty())
+  {
+    //Nothing to write
+    return;
+  }
+  GEMBatch dens; //Packed densities
+  PackGEMDensity(QMMMData,MMAtoms,bead,dens);
+  //Set up the grid
+  double lo[3],hi[3]; //Corners of the grid (Ang)
+  for (int d=0;d<3;d++)
+  {
+    lo[d] = HUGE_VAL;
+    hi[d] = -1*HUGE_VAL;
+  }
+  for (unsigned int i=0;i<MMAtoms.size();i++)
+  {
+    Coord& pos = QMMMData[MMAtoms[i]].P[bead]; //Atom position
+    lo[0] = min(lo[0],pos.x);
+    lo[1] = min(lo[1],pos.y);
+    lo[2] = min(lo[2],pos.z);
+    hi[0] = max(hi[0],pos.x);
+    hi[1] = max(hi[1],pos.y);
+    hi[2] = max(hi[2],pos.z);
+  }
+  int Npts[3]; //Number of points in each direction
+  for (int d=0;d<3;d++)
+  {
+    lo[d] -= gemCubePad;
+    hi[d] += gemCubePad;
+    Npts[d] = ((int)ceil((hi[d]-lo[d])/gemCubeSpace))+1;
+  }
+  //Write the header
+  fstream outFile; //Cube file
+  outFile.open(fileName.c_str(),ios_base::out);
+  outFile << "LICHEM GEM density" << '\n';
+  outFile << "Bead " << bead << ", coordinates in bohr" << '\n';
+  outFile << fixed << setprecision(6);
+  outFile << setw(5) << MMAtoms.size();
+  for (int d=0;d<3;d++)
+  {
+    outFile << " " << setw(12) << (lo[d]/bohrRad);
+  }
+  outFile << '\n';
+  for (int d=0;d<3;d++)
+  {
+    outFile << setw(5) << Npts[d];
+    for (int k=0;k<3;k++)
+    {
+      double step = (k == d) ? (gemCubeSpace/bohrRad) : 0; //Grid vector
+      outFile << " " << setw(12) << step;
+    }
+    outFile << '\n';
+  }
+  for (unsigned int i=0;i<MMAtoms.size();i++)
+  {
+    Coord& pos = QMMMData[MMAtoms[i]].P[bead]; //Atom position
+    int Z = chemTable.revTyping(QMMMData[MMAtoms[i]].QMTyp); //Nuclear charge
+    outFile << setw(5) << Z << " " << setw(12) << ((double)Z);
+    outFile << " " << setw(12) << (pos.x/bohrRad);
+    outFile << " " << setw(12) << (pos.y/bohrRad);
+    outFile << " " << setw(12) << (pos.z/bohrRad);
+    outFile << '\n';
+  }
+  //Evaluate the density one plane at a time
+  int Nplane = Npts[1]*Npts[2]; //Points in a plane
+  vector<double> px(Nplane),py(Nplane),pz(Nplane),rho(Nplane); //Grid data
+  outFile << scientific << setprecision(5);
+  for (int ix=0;ix<Npts[0];ix++)
+  {
+    for (int iy=0;iy<Npts[1];iy++)
+    {
+      for (int iz=0;iz<Npts[2];iz++)
+      {
+        int p = iy*Npts[2]+iz; //Point in the plane
+        px[p] = lo[0]+(ix*gemCubeSpace);
+        py[p] = lo[1]+(iy*gemCubeSpace);
+        pz[p] = lo[2]+(iz*gemCubeSpace);
+      }
+    }
+    GEMDensityPoints(dens,Nplane,&px[0],&py[0],&pz[0],&rho[0]);
+    for (int iy=0;iy<Npts[1];iy++)
+    {
+      //Six values per line, with a new line for each z row
+      for (int iz=0;iz<Npts[2];iz++)
+      {
+        outFile << " " << setw(12) << rho[iy*Npts[2]+iz];
+        if ((((iz+1)%6) == 0) or (iz == (Npts[2]-1)))
+        {
+          outFile << '\n';
+        }
+      }
+    }
+  }
+  outFile.flush();
+  outFile.close();
+  return;
+};
+
 void WriteModes(vector<QMMMAtom>& QMMMData, bool imagOnly, VectorXd& Freqs,
                 MatrixXd& normModes, QMMMSettings& QMMMOpts, int bead)
 {
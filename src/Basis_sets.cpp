@@ -9,23 +9,388 @@
 #                                                                             #
 ###############################################################################
 
- Compiled databases for looking up Cartesian or Hermite Gaussian basis sets
+ Databases for looking up Cartesian or Hermite Gaussian basis sets
 
  Reference for basis sets:
  
 
 */
 
+//Definitions for the HermBasisSet class
+HermBasisSet::HermBasisSet()
+{
+  //Constructor
+  blocks_.resize(1); //Empty block for atoms without a basis
+  blockElem_.push_back(-1);
+  poles_.push_back(blockDM(0));
+  dispC6_.push_back(0);
+  dispEps_.push_back(0);
+  dispRmin_.push_back(0);
+  return;
+};
+
+HermBasisSet::~HermBasisSet()
+{
+  //Generic destructor
+  return;
+};
+
+int HermBasisSet::elementID(string elem)
+{
+  //Return the ID of an element name, adding new names
+  map<string,int>::iterator it = elemIDs_.find(elem);
+  if (it != elemIDs_.end())
+  {
+    return it->second;
+  }
+  int ID = elemIDs_.size(); //New ID
+  elemIDs_[elem] = ID;
+  elemNames_.push_back(elem);
+  return ID;
+};
+
+int HermBasisSet::basisID(string basName)
+{
+  //Return the ID of a basis set name, adding new names
+  LICHEMLowerText(basName);
+  map<string,int>::iterator it = basisIDs_.find(basName);
+  if (it != basisIDs_.end())
+  {
+    return it->second;
+  }
+  int ID = basisIDs_.size(); //New ID
+  basisIDs_[basName] = ID;
+  return ID;
+};
+
+int HermBasisSet::findBlock(string elem, string basName)
+{
+  //Return the block of functions for an element and basis set
+  //NB: A value of -1 is returned if the basis set is not defined
+  pair<int,int> key(basisID(basName),elementID(elem)); //Lookup key
+  map<pair<int,int>,int>::iterator it = blockIDs_.find(key);
+  if (it == blockIDs_.end())
+  {
+    return -1;
+  }
+  return it->second;
+};
+
+void HermBasisSet::readFile(string fileName)
+{
+  //Add the basis sets in a data file
+  //NB: Each basis set starts with a line containing "basis", the basis
+  //name, the element, and the number of functions, which is followed by one
+  //line per function with the coefficient, exponent (a.u.), Hermite x, y,
+  //and z orders, and the x, y, and z offsets (Ang) from the atom
+  //NB: Later definitions replace earlier ones
+  if (!CheckFile(fileName))
+  {
+    cerr << "Error: Could not open the GEM basis set file ";
+    cerr << fileName << "!!!" << '\n' << '\n';
+    cerr.flush();
+    exit(0);
+  }
+  ifstream basisFile; //Data file
+  basisFile.open(fileName.c_str(),ios_base::in);
+  string dummy; //Generic string
+  while (basisFile >> dummy)
+  {
+    //Check for comments
+    if ((dummy[0] == '#') or (dummy[0] == '!'))
+    {
+      getline(basisFile,dummy);
+      continue;
+    }
+    LICHEMLowerText(dummy);
+    if (dummy == "dispersion")
+    {
+      //Read the dispersion parameters of a basis set
+      string basName,elem; //Basis set and element names
+      double C6,eps,Rmin; //Parameters
+      basisFile >> basName >> elem >> C6 >> eps >> Rmin;
+      int block = findBlock(elem,basName); //Block ID
+      if (basisFile.fail() or (block < 0))
+      {
+        cerr << "Error: Dispersion parameters for atom " << elem;
+        cerr << " do not follow basis set " << basName << " in ";
+        cerr << fileName << "!!!" << '\n' << '\n';
+        cerr.flush();
+        exit(0);
+      }
+      dispC6_[block] = C6;
+      dispEps_[block] = eps;
+      dispRmin_[block] = Rmin;
+      continue;
+    }
+    if (dummy != "basis")
+    {
+      cerr << "Error: Unrecognized line in the GEM basis set file ";
+      cerr << fileName << "!!!" << '\n' << '\n';
+      cerr.flush();
+      exit(0);
+    }
+    //Read the block
+    string basName,elem; //Basis set and element names
+    int Nfuncs; //Number of functions
+    basisFile >> basName >> elem >> Nfuncs;
+    vector<HermGau> funcs; //Functions in the block
+    funcs.reserve(Nfuncs);
+    for (int i=0;i<Nfuncs;i++)
+    {
+      double coeff,alpha,x,y,z; //Function properties
+      int ix,iy,iz; //Hermite orders
+      basisFile >> coeff >> alpha >> ix >> iy >> iz >> x >> y >> z;
+      funcs.push_back(HermGau(coeff,alpha,ix,iy,iz,x,y,z));
+    }
+    if (basisFile.fail())
+    {
+      cerr << "Error: Incomplete basis set " << basName;
+      cerr << " for atom " << elem << " in " << fileName;
+      cerr << "!!!" << '\n' << '\n';
+      cerr.flush();
+      exit(0);
+    }
+    //Save the block
+    int block = findBlock(elem,basName); //Block ID
+    if (block < 0)
+    {
+      //Create a new block
+      block = blocks_.size();
+      blocks_.push_back(funcs);
+      blockElem_.push_back(elementID(elem));
+      poles_.push_back(MPole());
+      dispC6_.push_back(0);
+      dispEps_.push_back(0);
+      dispRmin_.push_back(0);
+      pair<int,int> key(basisID(basName),elementID(elem)); //Lookup key
+      blockIDs_[key] = block;
+    }
+    else
+    {
+      //Replace the old definition
+      blocks_[block] = funcs;
+    }
+    //Cache the local frame multipoles
+    poles_[block] = blockDM(block);
+  }
+  basisFile.close();
+  return;
+};
+
+vector<HermGau>& HermBasisSet::block(int ID)
+{
+  //Return the functions in a block
+  return blocks_[ID];
+};
+
+MPole HermBasisSet::blockDM(int ID)
+{
+  //Function to convert a block of GEM density to local frame multipoles
+  //NB: The multipoles are the nuclear charge plus the moments of the
+  //functions about the atom in a.u., where the order zero functions have a
+  //charge equal to the coefficient, and the quadrupole is the traceless
+  //second moment, M-(Tr(M)/3)
+  vector<HermGau>& dens = blocks_[ID]; //Density functions
+  double q = 0; //Charge
+  double D[3] = {0,0,0}; //Dipole
+  double M[3][3] = {{0,0,0},{0,0,0},{0,0,0}}; //Second moments
+  //Add the nuclear charge from the periodic table
+  if (blockElem_[ID] >= 0)
+  {
+    q += chemTable.revTyping(elemNames_[blockElem_[ID]]);
+  }
+  //Convert Hermite Gaussians to multipoles
+  for (unsigned int i=0;i<dens.size();i++)
+  {
+    //Moments about the center of the function
+    double c = dens[i].coeff(); //Coefficient
+    int ord[3] = {dens[i].xPow(),dens[i].yPow(),dens[i].zPow()}; //Orders
+    int L = ord[0]+ord[1]+ord[2]; //Total order
+    double fq = 0; //Charge of the function
+    double fD[3] = {0,0,0}; //Dipole of the function
+    double fM[3][3] = {{0,0,0},{0,0,0},{0,0,0}}; //Second moments
+    if (L == 0)
+    {
+      //Monopole with diagonal second moments
+      fq = c;
+      for (int a=0;a<3;a++)
+      {
+        fM[a][a] = c/(2*dens[i].getAlpha());
+      }
+    }
+    if (L == 1)
+    {
+      //Dipole
+      for (int a=0;a<3;a++)
+      {
+        fD[a] = ord[a]*c;
+      }
+    }
+    if (L == 2)
+    {
+      //Quadrupole
+      for (int a=0;a<3;a++)
+      {
+        for (int b=0;b<3;b++)
+        {
+          if ((a == b) and (ord[a] == 2))
+          {
+            fM[a][b] = 2*c;
+          }
+          if ((a != b) and (ord[a] == 1) and (ord[b] == 1))
+          {
+            fM[a][b] = c;
+          }
+        }
+      }
+    }
+    //Shift the moments from the offset of the function to the atom
+    double R[3]; //Offset (a.u.)
+    R[0] = dens[i].xPos()/bohrRad;
+    R[1] = dens[i].yPos()/bohrRad;
+    R[2] = dens[i].zPos()/bohrRad;
+    q += fq;
+    for (int a=0;a<3;a++)
+    {
+      D[a] += fD[a]+(fq*R[a]);
+      for (int b=0;b<3;b++)
+      {
+        M[a][b] += fM[a][b]+(fD[a]*R[b])+(fD[b]*R[a])+(fq*R[a]*R[b]);
+      }
+    }
+  }
+  return PackGEMDM(q,D,M);
+};
+
+MPole HermBasisSet::blockDMRef(int ID)
+{
+  //Reference GEM multipoles of a block without the cache or the table of
+  //low order functions
+  //NB: Each moment is integrated directly from the Hermite Gaussians, so
+  //this is used to check blockDM
+  vector<HermGau>& dens = blocks_[ID]; //Density functions
+  double q = 0; //Charge
+  double D[3] = {0,0,0}; //Dipole
+  double M[3][3] = {{0,0,0},{0,0,0},{0,0,0}}; //Second moments
+  //Add the nuclear charge from the periodic table
+  if (blockElem_[ID] >= 0)
+  {
+    q += chemTable.revTyping(elemNames_[blockElem_[ID]]);
+  }
+  for (unsigned int i=0;i<dens.size();i++)
+  {
+    double c = dens[i].coeff(); //Coefficient
+    double alpha = dens[i].getAlpha(); //Exponent
+    int ord[3] = {dens[i].xPow(),dens[i].yPow(),dens[i].zPow()}; //Orders
+    double R[3]; //Offset (a.u.)
+    R[0] = dens[i].xPos()/bohrRad;
+    R[1] = dens[i].yPos()/bohrRad;
+    R[2] = dens[i].zPos()/bohrRad;
+    //Integrals of x^n, y^n, and z^n for n = 0, 1, and 2
+    double mom[3][3]; //Moments by direction and power
+    for (int a=0;a<3;a++)
+    {
+      for (int n=0;n<3;n++)
+      {
+        mom[a][n] = HermMoment1D(ord[a],alpha,n,R[a]);
+      }
+    }
+    //Combine the directions
+    q += c*mom[0][0]*mom[1][0]*mom[2][0];
+    for (int a=0;a<3;a++)
+    {
+      for (int b=0;b<3;b++)
+      {
+        int pw[3] = {0,0,0}; //Powers of x, y, and z
+        pw[a] += 1;
+        if (b == 0)
+        {
+          //Dipole
+          D[a] += c*mom[0][pw[0]]*mom[1][pw[1]]*mom[2][pw[2]];
+        }
+        pw[b] += 1;
+        M[a][b] += c*mom[0][pw[0]]*mom[1][pw[1]]*mom[2][pw[2]];
+      }
+    }
+  }
+  return PackGEMDM(q,D,M);
+};
+
+double HermBasisSet::checkPoles()
+{
+  //Return the largest difference between the cached multipoles and the
+  //reference, relative to the size of each moment when it is above one
+  double maxErr = 0; //Largest error
+  for (unsigned int i=0;i<poles_.size();i++)
+  {
+    MPole ref = blockDMRef(i); //Reference multipoles
+    MPole& pole = poles_[i]; //Cached multipoles
+    double cache[10] = {pole.q,pole.Dx,pole.Dy,pole.Dz,pole.Qxx,pole.Qxy,
+                        pole.Qxz,pole.Qyy,pole.Qyz,pole.Qzz};
+    double exact[10] = {ref.q,ref.Dx,ref.Dy,ref.Dz,ref.Qxx,ref.Qxy,
+                        ref.Qxz,ref.Qyy,ref.Qyz,ref.Qzz};
+    for (int k=0;k<10;k++)
+    {
+      double err = abs(cache[k]-exact[k]);
+      err /= max(1.0,abs(exact[k]));
+      maxErr = max(maxErr,err);
+    }
+  }
+  return maxErr;
+};
+
+MPole& HermBasisSet::blockPoles(int ID)
+{
+  //Return the cached local frame multipoles of a block
+  return poles_[ID];
+};
+
+void HermBasisSet::blockDisp(int ID, double& C6, double& eps, double& Rmin)
+{
+  //Return the dispersion parameters of a block
+  C6 = dispC6_[ID];
+  eps = dispEps_[ID];
+  Rmin = dispRmin_[ID];
+  return;
+};
+
 //Basis set definitions
-vector<HermGau> HermBasis(string Typ, string basName)
+MPole PackGEMDM(double q, double D[3], double M[3][3])
+{
+  //Function to save GEM moments as multipoles without a frame
+  MPole dmpole; //Blank set of multipoles
+  //Blank frame of reference
+  dmpole.chiralFlip = 0;
+  dmpole.type = "None";
+  dmpole.atom1 = -1;
+  dmpole.atom2 = -1;
+  dmpole.atom3 = -1;
+  //Save the charge and dipole
+  dmpole.q = q;
+  dmpole.Dx = D[0];
+  dmpole.Dy = D[1];
+  dmpole.Dz = D[2];
+  dmpole.IDx = 0;
+  dmpole.IDy = 0;
+  dmpole.IDz = 0;
+  //Convert to a traceless quadrupole
+  double qTrace = (M[0][0]+M[1][1]+M[2][2])/3;
+  dmpole.Qxx = M[0][0]-qTrace;
+  dmpole.Qxy = M[0][1];
+  dmpole.Qxz = M[0][2];
+  dmpole.Qyy = M[1][1]-qTrace;
+  dmpole.Qyz = M[1][2];
+  dmpole.Qzz = M[2][2]-qTrace;
+  return dmpole;
+};
+
+int HermBasis(string Typ, string basName)
 {
-  //Function to set specific Hermite basis sets
-  bool badBasis = 0; //Flag to exit if no basis set is found
-  vector<HermGau> newBasis;
-  //NB: Organized by basis name, then element
-  
+  //Function to find specific Hermite basis sets in the database
+  int block = hermBasisDB.findBlock(Typ,basName); //Shared block ID
   //Check for errors
-  if (badBasis)
+  if (block < 0)
   {
     cerr << "Error: Basis set " << basName;
     cerr << " is not defined for atom " << Typ;
@@ -34,6 +399,41 @@ vector<HermGau> HermBasis(string Typ, string basName)
     exit(0);
   }
   //Return basis set if it was found in the database
-  return newBasis;
+  return block;
 };
 
+void CheckGEMPoles(int& argc, char**& argv)
+{
+  //Function to compare the cached GEM multipoles with direct integrals of
+  //the Hermite Gaussians for every block in a basis set file
+  string basisFile = "GEM_basis.dat"; //Data file with the basis sets
+  string dummy; //Generic string
+  for (int i=0;i<argc;i++)
+  {
+    //Read the file name
+    dummy = string(argv[i]);
+    if ((dummy == "-b") and ((i+1) < argc))
+    {
+      basisFile = string(argv[i+1]);
+    }
+  }
+  hermBasisDB.readFile(basisFile);
+  double poleErr = hermBasisDB.checkPoles(); //Largest error
+  cout << '\n';
+  cout << "GEM basis file: " << basisFile << '\n';
+  cout << "Largest GEM multipole error: ";
+  cout << LICHEMFormFloat(poleErr,16) << '\n';
+  if (poleErr > gemPoleTol)
+  {
+    cout << "Error: The cached GEM multipoles differ from the reference.";
+  }
+  else
+  {
+    cout << "The cached GEM multipoles match the reference.";
+  }
+  cout << '\n' << '\n';
+  cout.flush();
+  //Quit
+  exit(0);
+  return;
+};
@@ -0,0 +1,357 @@
+/*
+
+###############################################################################
+#                                                                             #
+#                 LICHEM: Layered Interacting CHEmical Models                 #
+#                              By: Eric G. Kratz                              #
+#                                                                             #
+#                      Symbiotic Computational Chemistry                      #
+#                                                                             #
+###############################################################################
+
+ Structural metrics for the convergence tests of optimizations and reaction
+ paths. The RMS deviation between two structures can be calculated from the
+ full distance matrix, from the distances between neighboring atoms, or
+ from Kabsch-aligned coordinates.
+
+ Reference for the Kabsch algorithm:
+ Kabsch, Acta Crystallogr. Sect. A, 32, 5, 922, (1976)
+
+*/
+
+//Utility functions
+void PackConvCoords(vector<QMMMAtom>& QMMMData, int bead, bool QMRegion,
+                    vector<double>& posX, vector<double>& posY,
+                    vector<double>& posZ, vector<bool>& frznAt)
+{
+  //Copies the atomic positions into contiguous arrays
+  posX.clear();
+  posY.clear();
+  posZ.clear();
+  frznAt.clear();
+  for (int i=0;i<Natoms;i++)
+  {
+    if ((!QMRegion) or QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+    {
+      posX.push_back(QMMMData[i].P[bead].x);
+      posY.push_back(QMMMData[i].P[bead].y);
+      posZ.push_back(QMMMData[i].P[bead].z);
+      frznAt.push_back(QMMMData[i].frozen);
+    }
+  }
+  return;
+};
+
+//RMS deviation functions
+double RMSDevMatrix(vector<QMMMAtom>& QMMMData, vector<QMMMAtom>& oldQMMMData,
+                    int bead, bool QMRegion)
+{
+  //RMS change in the distance matrix (all pairs)
+  double RMSDiff = 0; //RMS deviation
+  vector<double> newX,newY,newZ; //New positions
+  vector<double> oldX,oldY,oldZ; //Old positions
+  vector<bool> frznAt; //Frozen atoms
+  PackConvCoords(QMMMData,bead,QMRegion,newX,newY,newZ,frznAt);
+  PackConvCoords(oldQMMMData,bead,QMRegion,oldX,oldY,oldZ,frznAt);
+  int Nact = (int)newX.size(); //Number of atoms in the test
+  double Npairs = 0; //Number of distances
+  if (QMRegion)
+  {
+    Npairs = 0.5*Nact*(Nact-1);
+  }
+  else
+  {
+    Npairs = 0.5*(Natoms-Nfreeze)*(Natoms-Nfreeze-1);
+  }
+  if (Npairs <= 0)
+  {
+    //Nothing can move
+    return 0;
+  }
+  //Pointers to the arrays for vectorization
+  double* nx = &newX[0];
+  double* ny = &newY[0];
+  double* nz = &newZ[0];
+  double* ox = &oldX[0];
+  double* oy = &oldY[0];
+  double* oz = &oldZ[0];
+  #pragma omp parallel for schedule(dynamic) reduction(+:RMSDiff)
+  for (int i=0;i<Nact;i++)
+  {
+    double RMSTemp = 0; //Store a local sum
+    #pragma omp simd reduction(+:RMSTemp)
+    for (int j=0;j<i;j++)
+    {
+      double dxNew = nx[i]-nx[j];
+      double dyNew = ny[i]-ny[j];
+      double dzNew = nz[i]-nz[j];
+      double dxOld = ox[i]-ox[j];
+      double dyOld = oy[i]-oy[j];
+      double dzOld = oz[i]-oz[j];
+      //Minimum image convention
+      pbcBox.minImage(dxNew,dyNew,dzNew);
+      pbcBox.minImage(dxOld,dyOld,dzOld);
+      double RNew = sqrt(dxNew*dxNew+dyNew*dyNew+dzNew*dzNew);
+      double ROld = sqrt(dxOld*dxOld+dyOld*dyOld+dzOld*dzOld);
+      //Update local sum
+      RMSTemp += (RNew-ROld)*(RNew-ROld);
+    }
+    //Update sum
+    RMSDiff += RMSTemp;
+  }
+  RMSDiff /= Npairs;
+  RMSDiff = sqrt(RMSDiff);
+  return RMSDiff;
+};
+
+double RMSDevNeighbor(vector<QMMMAtom>& QMMMData,
+                      vector<QMMMAtom>& oldQMMMData, QMMMSettings& QMMMOpts,
+                      int bead, bool QMRegion)
+{
+  //RMS change in the distances between neighboring atoms
+  //NB: Pairs are found with a cell list built from the old structure
+  double RMSDiff = 0; //RMS deviation
+  double Npairs = 0; //Number of distances
+  double RCut = QMMMOpts.convCut; //Neighbor cutoff
+  double RCut2 = RCut*RCut; //Squared cutoff
+  vector<double> newX,newY,newZ; //New positions
+  vector<double> oldX,oldY,oldZ; //Old positions
+  vector<bool> frznAt; //Frozen atoms
+  PackConvCoords(QMMMData,bead,QMRegion,newX,newY,newZ,frznAt);
+  PackConvCoords(oldQMMMData,bead,QMRegion,oldX,oldY,oldZ,frznAt);
+  int Nact = (int)newX.size(); //Number of atoms in the test
+  if (Nact < 2)
+  {
+    //Nothing can move
+    return 0;
+  }
+  //Set up the cell grid
+  double minX = oldX[0];
+  double minY = oldY[0];
+  double minZ = oldZ[0];
+  double maxX = oldX[0];
+  double maxY = oldY[0];
+  double maxZ = oldZ[0];
+  for (int i=1;i<Nact;i++)
+  {
+    minX = min(minX,oldX[i]);
+    minY = min(minY,oldY[i]);
+    minZ = min(minZ,oldZ[i]);
+    maxX = max(maxX,oldX[i]);
+    maxY = max(maxY,oldY[i]);
+    maxZ = max(maxZ,oldZ[i]);
+  }
+  int NCx,NCy,NCz; //Number of cells in each direction
+  bool wrapCells = 0; //Flag to wrap the cells across the box
+  double cellLen = RCut; //Size of the cells
+  double wa = 0; //Width of the box along a
+  double wb = 0; //Width of the box along b
+  double wc = 0; //Width of the box along c
+  if (PBCon)
+  {
+    pbcBox.widths(wa,wb,wc);
+  }
+  if (PBCon and (wa >= (3*RCut)) and (wb >= (3*RCut)) and (wc >= (3*RCut)))
+  {
+    //Cells span the periodic box in fractional coordinates
+    wrapCells = 1;
+    NCx = (int)floor(wa/RCut);
+    NCy = (int)floor(wb/RCut);
+    NCz = (int)floor(wc/RCut);
+  }
+  else if (PBCon)
+  {
+    //The box is too small for a cell list, so all pairs are checked
+    NCx = 1;
+    NCy = 1;
+    NCz = 1;
+  }
+  else
+  {
+    //Cells span the structure
+    double cellVol = (maxX-minX+RCut)*(maxY-minY+RCut)*(maxZ-minZ+RCut);
+    cellLen = max(RCut,cbrt(cellVol/Nact)); //Avoid mostly empty grids
+    NCx = (int)floor((maxX-minX)/cellLen)+1;
+    NCy = (int)floor((maxY-minY)/cellLen)+1;
+    NCz = (int)floor((maxZ-minZ)/cellLen)+1;
+  }
+  //Assign atoms to cells
+  vector<int> cellID(Nact); //Cell of each atom
+  vector<int> cellStart(NCx*NCy*NCz+1,0); //First atom in each cell
+  vector<int> cellAtoms(Nact); //Atoms sorted by cell
+  for (int i=0;i<Nact;i++)
+  {
+    int cx,cy,cz; //Cell indices
+    if (wrapCells)
+    {
+      double fa,fb,fc; //Fractional coordinates
+      pbcBox.fracCoords(oldX[i],oldY[i],oldZ[i],fa,fb,fc);
+      cx = (int)floor((fa-floor(fa))*NCx);
+      cy = (int)floor((fb-floor(fb))*NCy);
+      cz = (int)floor((fc-floor(fc))*NCz);
+      cx = min(cx,NCx-1);
+      cy = min(cy,NCy-1);
+      cz = min(cz,NCz-1);
+    }
+    else
+    {
+      cx = min((int)floor((oldX[i]-minX)/cellLen),NCx-1);
+      cy = min((int)floor((oldY[i]-minY)/cellLen),NCy-1);
+      cz = min((int)floor((oldZ[i]-minZ)/cellLen),NCz-1);
+    }
+    cellID[i] = cx+NCx*(cy+NCy*cz);
+    cellStart[cellID[i]+1] += 1;
+  }
+  for (int i=0;i<(NCx*NCy*NCz);i++)
+  {
+    cellStart[i+1] += cellStart[i];
+  }
+  vector<int> cellFill(cellStart.begin(),cellStart.end()-1); //Next slot
+  for (int i=0;i<Nact;i++)
+  {
+    cellAtoms[cellFill[cellID[i]]] = i;
+    cellFill[cellID[i]] += 1;
+  }
+  //Sum over neighboring pairs
+  #pragma omp parallel for schedule(dynamic) reduction(+:RMSDiff,Npairs)
+  for (int i=0;i<Nact;i++)
+  {
+    double RMSTemp = 0; //Store a local sum
+    double pairTemp = 0; //Store a local count
+    int cx = cellID[i]%NCx; //Cell indices of atom i
+    int cy = (cellID[i]/NCx)%NCy;
+    int cz = cellID[i]/(NCx*NCy);
+    for (int ix=-1;ix<=1;ix++)
+    {
+      for (int iy=-1;iy<=1;iy++)
+      {
+        for (int iz=-1;iz<=1;iz++)
+        {
+          int nx = cx+ix; //Neighboring cell
+          int ny = cy+iy;
+          int nz = cz+iz;
+          if (wrapCells)
+          {
+            nx = (nx+NCx)%NCx;
+            ny = (ny+NCy)%NCy;
+            nz = (nz+NCz)%NCz;
+          }
+          else if ((nx < 0) or (ny < 0) or (nz < 0) or (nx >= NCx) or
+                  (ny >= NCy) or (nz >= NCz))
+          {
+            //Outside of the grid
+            continue;
+          }
+          int cellNum = nx+NCx*(ny+NCy*nz); //Neighboring cell ID
+          for (int k=cellStart[cellNum];k<cellStart[cellNum+1];k++)
+          {
+            int j = cellAtoms[k];
+            if ((j >= i) or (frznAt[i] and frznAt[j]))
+            {
+              //Count each pair once and skip rigid pairs
+              continue;
+            }
+            double dxOld = oldX[i]-oldX[j];
+            double dyOld = oldY[i]-oldY[j];
+            double dzOld = oldZ[i]-oldZ[j];
+            double dxNew = newX[i]-newX[j];
+            double dyNew = newY[i]-newY[j];
+            double dzNew = newZ[i]-newZ[j];
+            //Minimum image convention
+            pbcBox.minImage(dxOld,dyOld,dzOld);
+            pbcBox.minImage(dxNew,dyNew,dzNew);
+            double ROld = dxOld*dxOld+dyOld*dyOld+dzOld*dzOld;
+            if (ROld <= RCut2)
+            {
+              double RNew = dxNew*dxNew+dyNew*dyNew+dzNew*dzNew;
+              RNew = sqrt(RNew);
+              ROld = sqrt(ROld);
+              RMSTemp += (RNew-ROld)*(RNew-ROld);
+              pairTemp += 1;
+            }
+          }
+        }
+      }
+    }
+    //Update sums
+    RMSDiff += RMSTemp;
+    Npairs += pairTemp;
+  }
+  if (Npairs > 0)
+  {
+    RMSDiff /= Npairs;
+  }
+  RMSDiff = sqrt(RMSDiff);
+  return RMSDiff;
+};
+
+double RMSDevKabsch(vector<QMMMAtom>& QMMMData, vector<QMMMAtom>& oldQMMMData,
+                    int bead, bool QMRegion)
+{
+  //RMS deviation of the atomic positions after Kabsch alignment
+  double RMSDiff = 0; //RMS deviation
+  int Nact = 0; //Number of atoms in the test
+  int Nmove = 0; //Number of atoms which can move
+  for (int i=0;i<Natoms;i++)
+  {
+    if ((!QMRegion) or QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+    {
+      Nact += 1;
+      if (!QMMMData[i].frozen)
+      {
+        Nmove += 1;
+      }
+    }
+  }
+  if (Nmove == 0)
+  {
+    //Nothing can move
+    return 0;
+  }
+  MatrixXd newPos(Nact,3); //New structure
+  MatrixXd oldPos(Nact,3); //Old structure
+  int ct = 0; //Counter
+  for (int i=0;i<Natoms;i++)
+  {
+    if ((!QMRegion) or QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+    {
+      newPos(ct,0) = QMMMData[i].P[bead].x;
+      newPos(ct,1) = QMMMData[i].P[bead].y;
+      newPos(ct,2) = QMMMData[i].P[bead].z;
+      oldPos(ct,0) = oldQMMMData[i].P[bead].x;
+      oldPos(ct,1) = oldQMMMData[i].P[bead].y;
+      oldPos(ct,2) = oldQMMMData[i].P[bead].z;
+      ct += 1;
+    }
+  }
+  if (Nact > 2)
+  {
+    //Remove translation and rotation
+    KabschRotation(oldPos,newPos,Nact);
+  }
+  RMSDiff = (newPos-oldPos).squaredNorm();
+  RMSDiff /= Nmove;
+  RMSDiff = sqrt(RMSDiff);
+  return RMSDiff;
+};
+
+double ConvRMSDev(vector<QMMMAtom>& QMMMData, vector<QMMMAtom>& oldQMMMData,
+                  QMMMSettings& QMMMOpts, int bead, bool QMRegion)
+{
+  //Calculates the RMS deviation with the metric from the input
+  double RMSDiff = 0; //RMS deviation
+  if (QMMMOpts.convMetric == "Neighbor")
+  {
+    RMSDiff = RMSDevNeighbor(QMMMData,oldQMMMData,QMMMOpts,bead,QMRegion);
+  }
+  else if (QMMMOpts.convMetric == "Kabsch")
+  {
+    RMSDiff = RMSDevKabsch(QMMMData,oldQMMMData,bead,QMRegion);
+  }
+  else
+  {
+    //Full distance matrix
+    RMSDiff = RMSDevMatrix(QMMMData,oldQMMMData,bead,QMRegion);
+  }
+  return RMSDiff;
+};
@@ -56,6 +56,138 @@ double LICHEMFactorial(int n)
   return val;
 };
 
+inline double LICHEMExp(double x)
+{
+  //Branch-free exponential which can be vectorized by the compiler
+  //NB: Arguments are clamped to +/-700, and the result is accurate to a
+  //few ulp
+  const double log2e = 1.4426950408889634; //1/ln(2)
+  const double ln2Hi = 6.93147180369123816490e-01; //Leading bits of ln(2)
+  const double ln2Lo = 1.90821492927058770002e-10; //Trailing bits of ln(2)
+  const double shift = 6755399441055744.0; //1.5*2^52 for rounding
+  x = min(max(x,-700.0),700.0);
+  //Split x into n*ln(2)+r with |r| < ln(2)/2
+  double t = (x*log2e)+shift; //Integer n in the low bits
+  double n = t-shift; //Nearest integer to x/ln(2)
+  double r = (x-(n*ln2Hi))-(n*ln2Lo); //Reduced argument
+  //Taylor series for exp(r)
+  double val = 1.0/479001600; //1/12!
+  val = (val*r)+(1.0/39916800);
+  val = (val*r)+(1.0/3628800);
+  val = (val*r)+(1.0/362880);
+  val = (val*r)+(1.0/40320);
+  val = (val*r)+(1.0/5040);
+  val = (val*r)+(1.0/720);
+  val = (val*r)+(1.0/120);
+  val = (val*r)+(1.0/24);
+  val = (val*r)+(1.0/6);
+  val = (val*r)+0.5;
+  val = (val*r)+1;
+  val = (val*r)+1;
+  //Multiply by 2^n from the exponent bits
+  long long tBits,sBits,pBits; //Bit patterns
+  memcpy(&tBits,&t,sizeof(double));
+  memcpy(&sBits,&shift,sizeof(double));
+  pBits = (tBits-sBits+1023) << 52;
+  double pow2; //2^n
+  memcpy(&pow2,&pBits,sizeof(double));
+  return val*pow2;
+};
+
+void LICHEMFFT1D(complex<double>* line, int N, bool inverse)
+{
+  //In-place radix-2 fast Fourier transform
+  //NB: N must be a power of two and the inverse is not normalized
+  for (int i=1,j=0;i<N;i++)
+  {
+    //Bit reversal permutation
+    int bit = N >> 1;
+    while (j & bit)
+    {
+      j ^= bit;
+      bit >>= 1;
+    }
+    j ^= bit;
+    if (i < j)
+    {
+      swap(line[i],line[j]);
+    }
+  }
+  for (int len=2;len<=N;len<<=1)
+  {
+    //Butterflies
+    double ang = 2*pi/len; //Twiddle angle
+    if (!inverse)
+    {
+      ang *= -1;
+    }
+    for (int j=0;j<(len/2);j++)
+    {
+      complex<double> w(cos(j*ang),sin(j*ang)); //Twiddle factor
+      for (int i=0;i<N;i+=len)
+      {
+        complex<double> u = line[i+j];
+        complex<double> v = line[i+j+len/2]*w;
+        line[i+j] = u+v;
+        line[i+j+len/2] = u-v;
+      }
+    }
+  }
+  return;
+};
+
+void LICHEMFFT3D(vector<complex<double> >& data, int Nx, int Ny, int Nz,
+                 bool inverse)
+{
+  //Three dimensional FFT of data stored as [(x*Ny+y)*Nz+z]
+  //NB: The grid sizes must be powers of two
+  #pragma omp parallel
+  {
+    vector<complex<double> > line; //Temporary storage for a line
+    //Transform along z
+    #pragma omp for schedule(static)
+    for (int i=0;i<(Nx*Ny);i++)
+    {
+      LICHEMFFT1D(&data[i*Nz],Nz,inverse);
+    }
+    //Transform along y
+    line.resize(Ny);
+    #pragma omp for schedule(static)
+    for (int i=0;i<(Nx*Nz);i++)
+    {
+      int ix = i/Nz;
+      int iz = i%Nz;
+      for (int iy=0;iy<Ny;iy++)
+      {
+        line[iy] = data[(ix*Ny+iy)*Nz+iz];
+      }
+      LICHEMFFT1D(&line[0],Ny,inverse);
+      for (int iy=0;iy<Ny;iy++)
+      {
+        data[(ix*Ny+iy)*Nz+iz] = line[iy];
+      }
+    }
+    //Transform along x
+    line.resize(Nx);
+    #pragma omp for schedule(static)
+    for (int i=0;i<(Ny*Nz);i++)
+    {
+      int iy = i/Nz;
+      int iz = i%Nz;
+      for (int ix=0;ix<Nx;ix++)
+      {
+        line[ix] = data[(ix*Ny+iy)*Nz+iz];
+      }
+      LICHEMFFT1D(&line[0],Nx,inverse);
+      for (int ix=0;ix<Nx;ix++)
+      {
+        data[(ix*Ny+iy)*Nz+iz] = line[ix];
+      }
+    }
+  }
+  return;
+};
+
 bool CheckFile(const string& file)
 {
   //Checks if a file exists
@@ -91,66 +223,70 @@ double Bohring(double ri)
 Coord CoordDist2(Coord& a, Coord& b)
 {
   //Signed displacements
-  double dx = a.x-b.x;
-  double dy = a.y-b.y;
-  double dz = a.z-b.z;
-  //Check PBC
-  if (PBCon)
-  {
-    bool check = 1; //Continue checking PBC
-    while (check)
-    {
-      //Overkill, bit it checks if atoms are wrapped multiple times
-      check = 0; //Stop if there are no changes
-      if (abs(dx) > (0.5*Lx))
-      {
-        //Update X displacement
-        check = 1; //The displacement was updated
-        if (dx > 0)
-        {
-          dx -= Lx;
-        }
-        else
-        {
-          dx += Lx;
-        }
-      }
-      if (abs(dy) > (0.5*Ly))
-      {
-        //Update Y displacement
-        check = 1; //The displacement was updated
-        if (dy > 0)
-        {
-          dy -= Ly;
-        }
-        else
-        {
-          dy += Ly;
-        }
-      }
-      if (abs(dz) > (0.5*Lz))
-      {
-        //Update Z displacement
-        check = 1; //The displacement was updated
-        if (dz > 0)
-        {
-          dz -= Lz;
-        }
-        else
-        {
-          dz += Lz;
-        }
-      }
-    }
-  }
-  //Save displacements
   Coord dispAB; //Distance between A and B
-  dispAB.x = dx;
-  dispAB.y = dy;
-  dispAB.z = dz;
+  dispAB.x = a.x-b.x;
+  dispAB.y = a.y-b.y;
+  dispAB.z = a.z-b.z;
+  //Apply the minimum image convention (no changes without PBC)
+  pbcBox.minImage(dispAB.x,dispAB.y,dispAB.z);
   return dispAB;
 };
 
+void MinImageOneToMany(double xi, double yi, double zi, int N, double* x,
+                       double* y, double* z, double* dx, double* dy,
+                       double* dz)
+{
+  //Minimum image displacements from one point to a list of points
+  //NB: The displacements are (i-j), the same as CoordDist2
+  //Local copies of the cell for vectorization
+  const double shift = 6755399441055744.0; //1.5*2^52 for rounding
+  const double ax = pbcBox.ax;
+  const double bx = pbcBox.bx;
+  const double by = pbcBox.by;
+  const double cx = pbcBox.cx;
+  const double cy = pbcBox.cy;
+  const double cz = pbcBox.cz;
+  const double invAx = pbcBox.invAx;
+  const double invBy = pbcBox.invBy;
+  const double invCz = pbcBox.invCz;
+  #pragma omp simd
+  for (int j=0;j<N;j++)
+  {
+    double rx = xi-x[j];
+    double ry = yi-y[j];
+    double rz = zi-z[j];
+    double n = ((rz*invCz)+shift)-shift; //Nearest image along c
+    rx -= n*cx;
+    ry -= n*cy;
+    rz -= n*cz;
+    n = ((ry*invBy)+shift)-shift; //Nearest image along b
+    rx -= n*bx;
+    ry -= n*by;
+    n = ((rx*invAx)+shift)-shift; //Nearest image along a
+    rx -= n*ax;
+    dx[j] = rx;
+    dy[j] = ry;
+    dz[j] = rz;
+  }
+  return;
+};
+
+void MinImageManyToMany(int Na, double* xa, double* ya, double* za, int Nb,
+                        double* xb, double* yb, double* zb, double* dx,
+                        double* dy, double* dz)
+{
+  //Minimum image displacements between two lists of points
+  //NB: The displacement (i-j) is stored in row i and column j
+  #pragma omp parallel for schedule(static)
+  for (int i=0;i<Na;i++)
+  {
+    long long row = ((long long)i)*Nb; //Start of the row
+    MinImageOneToMany(xa[i],ya[i],za[i],Nb,xb,yb,zb,&dx[row],&dy[row],
+                      &dz[row]);
+  }
+  return;
+};
+
 double LRECFunction(Coord& dist, QMMMSettings& QMMMOpts)
 {
   //Calculates the LREC scale factor based on the distance between points
@@ -169,83 +305,138 @@ double LRECFunction(Coord& dist, QMMMSettings& QMMMOpts)
     //Combine temp. variables
     scrqA += scrqB+1;
     //Set the scale factor
-    scrq -= pow(scrqA,QMMMOpts.LRECPow);
+    //NB: The exponent is an integer, so pow() is not needed
+    scrqB = 1;
+    for (int i=0;i<QMMMOpts.LRECPow;i++)
+    {
+      scrqB *= scrqA;
+    }
+    scrq -= scrqB;
+    return scrq;
   }
   //Charge is not within the cutoff
   return 0;
 };
 
 //Functions to check connectivity
-vector<int> TraceBoundary(vector<QMMMAtom>& QMMMData, int atID)
+void BuildTopology(vector<QMMMAtom>& QMMMData)
 {
-  //Function to find all boundary atoms connected to a pseudobond atom
-  bool bondError = 0; //Checks if the molecular structure "breaks" the math
-  vector<int> boundAtoms; //Final list of atoms
-  //Add atoms bonded to atom "AtID"
-  for (unsigned int i=0;i<QMMMData[atID].bonds.size();i++)
+  //Builds the 1-2, 1-3, and 1-4 neighbor lists from the connectivity
+  int N = (int)QMMMData.size(); //Number of atoms
+  vector<vector<int> > bonds12(N); //Symmetric bond lists
+  for (int i=0;i<N;i++)
   {
-    int bondID = QMMMData[atID].bonds[i];
-    if (QMMMData[bondID].BARegion)
+    for (unsigned int j=0;j<QMMMData[i].bonds.size();j++)
     {
-      boundAtoms.push_back(bondID);
-    }
-    if (QMMMData[bondID].PBRegion and (bondID != atID))
-    {
-      //Two PBs are connected and this system will fail
-      bondError = 1;
+      int bondID = QMMMData[i].bonds[j];
+      if (bondID != i)
+      {
+        bonds12[i].push_back(bondID);
+        bonds12[bondID].push_back(i);
+      }
     }
   }
-  //Check find other boundary atoms bonded to the initial set
-  bool moreFound = 1; //More boundary atoms were found
-  while (moreFound and (!bondError))
+  for (int i=0;i<N;i++)
   {
-    moreFound = 0; //Break the loop
-    vector<int> tmp;
-    for (unsigned int i=0;i<boundAtoms.size();i++)
+    sort(bonds12[i].begin(),bonds12[i].end());
+    bonds12[i].erase(unique(bonds12[i].begin(),bonds12[i].end()),
+                     bonds12[i].end());
+  }
+  //Walk one bond further for the 1-3 and 1-4 lists
+  vector<vector<int> > bonds13(N); //Atoms two bonds away
+  vector<vector<int> > bonds14(N); //Atoms three bonds away
+  #pragma omp parallel for schedule(dynamic)
+  for (int i=0;i<N;i++)
+  {
+    vector<int>& row12 = bonds12[i];
+    vector<int>& row13 = bonds13[i];
+    vector<int>& row14 = bonds14[i];
+    for (unsigned int j=0;j<row12.size();j++)
     {
-      int BAID = boundAtoms[i];
-      for (unsigned int j=0;j<QMMMData[BAID].bonds.size();j++)
+      vector<int>& next = bonds12[row12[j]];
+      for (unsigned int k=0;k<next.size();k++)
       {
-        int bondID = QMMMData[BAID].bonds[j];
-        //Check if it is on the list
-        bool isThere = 0;
-        for (unsigned int k=0;k<boundAtoms.size();k++)
-        {
-          if (bondID == boundAtoms[k])
-          {
-            isThere = 1;
-          }
-        }
-        if (!isThere)
+        int atK = next[k];
+        if ((atK != i) and
+           (!binary_search(row12.begin(),row12.end(),atK)))
         {
-          if (QMMMData[bondID].BARegion)
-          {
-            moreFound = 1; //Keep going
-            tmp.push_back(bondID);
-          }
-          if (QMMMData[bondID].PBRegion and (bondID != atID))
-          {
-            //Two PBs are connected and this system will fail
-            bondError = 1;
-          }
+          row13.push_back(atK);
         }
       }
     }
-    //Add them to the list
-    for (unsigned int i=0;i<tmp.size();i++)
+    sort(row13.begin(),row13.end());
+    row13.erase(unique(row13.begin(),row13.end()),row13.end());
+    for (unsigned int j=0;j<row13.size();j++)
     {
-      bool isThere = 0;
-      for (unsigned int j=0;j<boundAtoms.size();j++)
+      vector<int>& next = bonds12[row13[j]];
+      for (unsigned int k=0;k<next.size();k++)
       {
-        //Avoid adding the atom twice
-        if (tmp[i] == boundAtoms[j])
+        int atK = next[k];
+        if ((atK != i) and
+           (!binary_search(row12.begin(),row12.end(),atK)) and
+           (!binary_search(row13.begin(),row13.end(),atK)))
         {
-          isThere = 1;
+          row14.push_back(atK);
         }
       }
-      if (!isThere)
+    }
+    sort(row14.begin(),row14.end());
+    row14.erase(unique(row14.begin(),row14.end()),row14.end());
+  }
+  //Pack the lists
+  topoTab.Nnodes = N;
+  for (int order=2;order<=4;order++)
+  {
+    vector<vector<int> >& rows = (order == 2) ? bonds12 :
+                                 ((order == 3) ? bonds13 : bonds14);
+    vector<int>& start = (order == 2) ? topoTab.start12 :
+                         ((order == 3) ? topoTab.start13 : topoTab.start14);
+    vector<int>& list = (order == 2) ? topoTab.list12 :
+                        ((order == 3) ? topoTab.list13 : topoTab.list14);
+    start.assign(N+1,0);
+    for (int i=0;i<N;i++)
+    {
+      start[i+1] = start[i]+rows[i].size();
+    }
+    list.resize(start[N]);
+    for (int i=0;i<N;i++)
+    {
+      copy(rows[i].begin(),rows[i].end(),list.begin()+start[i]);
+    }
+  }
+  return;
+};
+
+vector<int> TraceBoundary(vector<QMMMAtom>& QMMMData, int atID)
+{
+  //Function to find all boundary atoms connected to a pseudobond atom
+  //NB: This is a breadth-first search, where the list of boundary atoms
+  //is also the queue
+  bool bondError = 0; //Checks if the molecular structure "breaks" the math
+  vector<int> boundAtoms; //Final list of atoms
+  vector<bool> visited(topoTab.Nnodes,0); //Atoms which were checked
+  visited[atID] = 1;
+  for (int q=-1;(q<(int)boundAtoms.size()) and (!bondError);q++)
+  {
+    //Start from "AtID" and then search from each boundary atom
+    int curID = (q < 0) ? atID : boundAtoms[q];
+    for (int j=topoTab.start12[curID];j<topoTab.start12[curID+1];j++)
+    {
+      int bondID = topoTab.list12[j];
+      if (visited[bondID])
+      {
+        //Already on the list
+        continue;
+      }
+      if (QMMMData[bondID].BARegion)
       {
-        boundAtoms.push_back(tmp[i]);
+        visited[bondID] = 1;
+        boundAtoms.push_back(bondID);
+      }
+      if (QMMMData[bondID].PBRegion)
+      {
+        //Two PBs are connected and this system will fail
+        bondError = 1;
       }
     }
   }
@@ -267,55 +458,25 @@ vector<int> TraceBoundary(vector<QMMMAtom>& QMMMData, int atID)
 bool Bonded(vector<QMMMAtom>& QMMMData, int atom1, int atom2)
 {
   //Function to check if two atoms are 1-2 connected
-  bool isBound = 0;
-  for (unsigned int i=0;i<QMMMData[atom2].bonds.size();i++)
-  {
-    if (atom1 == QMMMData[atom2].bonds[i])
-    {
-      isBound = 1;
-    }
-  }
-  return isBound;
+  vector<int>::iterator first = topoTab.list12.begin();
+  return binary_search(first+topoTab.start12[atom2],
+                       first+topoTab.start12[atom2+1],atom1);
 };
 
 bool Angled(vector<QMMMAtom>& QMMMData, int atom1, int atom3)
 {
   //Function to check if two atoms are 1-3 connected
-  bool isBound = 0;
-  for (unsigned int i=0;i<QMMMData[atom1].bonds.size();i++)
-  {
-    int atom2 = QMMMData[atom1].bonds[i];
-    for (unsigned int j=0;j<QMMMData[atom2].bonds.size();j++)
-    {
-      if (atom3 == QMMMData[atom2].bonds[j])
-      {
-        isBound = 1;
-      }
-    }
-  }
-  return isBound;
+  vector<int>::iterator first = topoTab.list13.begin();
+  return binary_search(first+topoTab.start13[atom1],
+                       first+topoTab.start13[atom1+1],atom3);
 };
 
 bool Dihedraled(vector<QMMMAtom>& QMMMData, int atom1, int atom4)
 {
   //Function to check if two atoms are 1-4 connected
-  bool isBound = 0;
-  for (unsigned int i=0;i<QMMMData[atom1].bonds.size();i++)
-  {
-    int atom2 = QMMMData[atom1].bonds[i];
-    for (unsigned int j=0;j<QMMMData[atom2].bonds.size();j++)
-    {
-      int atom3 = QMMMData[atom2].bonds[j];
-      for (unsigned int k=0;k<QMMMData[atom3].bonds.size();k++)
-      {
-        if (atom4 == QMMMData[atom3].bonds[k])
-        {
-          isBound = 1;
-        }
-      }
-    }
-  }
-  return isBound;
+  vector<int>::iterator first = topoTab.list14.begin();
+  return binary_search(first+topoTab.start14[atom1],
+                       first+topoTab.start14[atom1+1],atom4);
 };
 
 //Structure correction functions
@@ -372,7 +533,7 @@ void PBCCenter(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
   avgX /= Natoms*QMMMOpts.NBeads;
   avgY /= Natoms*QMMMOpts.NBeads;
   avgZ /= Natoms*QMMMOpts.NBeads;
-  //Move atoms to the center of the box
+  //Move atoms to the center of the box, (a+b+c)/2
   #pragma omp parallel
   {
     #pragma omp for nowait schedule(dynamic)
@@ -383,7 +544,7 @@ void PBCCenter(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
       {
         //Move bead to the center
         QMMMData[i].P[j].x -= avgX;
-        QMMMData[i].P[j].x += 0.5*Lx;
+        QMMMData[i].P[j].x += 0.5*(pbcBox.ax+pbcBox.bx+pbcBox.cx);
       }
     }
     #pragma omp for nowait schedule(dynamic)
@@ -394,7 +555,7 @@ void PBCCenter(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
       {
         //Move bead to the center
         QMMMData[i].P[j].y -= avgY;
-        QMMMData[i].P[j].y += 0.5*Ly;
+        QMMMData[i].P[j].y += 0.5*(pbcBox.by+pbcBox.cy);
       }
     }
     #pragma omp for nowait schedule(dynamic)
@@ -405,7 +566,7 @@ void PBCCenter(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
       {
         //Move bead to the center
         QMMMData[i].P[j].z -= avgZ;
-        QMMMData[i].P[j].z += 0.5*Lz;
+        QMMMData[i].P[j].z += 0.5*pbcBox.cz;
       }
     }
   }
@@ -24,11 +24,37 @@
 */
 
 //GEM utility functions
+double GEMTaper(double r, double Rcut, double& dTaper)
+{
+  //Quintic switching function which turns off pair terms at the cutoff
+  //NB: The derivative is returned in dTaper
+  double rOn = gemDispTaper*Rcut; //Start of the switching region
+  dTaper = 0;
+  if (r <= rOn)
+  {
+    return 1;
+  }
+  if (r >= Rcut)
+  {
+    return 0;
+  }
+  double x = (r-rOn)/(Rcut-rOn); //Position in the switching region
+  double x2 = x*x;
+  dTaper = (-30*x2+60*x2*x-30*x2*x2)/(Rcut-rOn);
+  return 1-(10*x2*x)+(15*x2*x2)-(6*x2*x2*x);
+};
+
 double GEMC6(double C6, Coord& POSi, Coord& POSj, double Rcut)
 {
   //Function to calculate the LJ style dispersion
   double Eij = 0; //Dispersion energy
-  
+  Coord dist = CoordDist2(POSi,POSj); //Minimum image displacement
+  double r2 = (dist.x*dist.x)+(dist.y*dist.y)+(dist.z*dist.z);
+  if (r2 < (Rcut*Rcut))
+  {
+    double dTaper; //Unused derivative
+    Eij = -1*C6*GEMTaper(sqrt(r2),Rcut,dTaper)/(r2*r2*r2);
+  }
   //Return energy
   return Eij;
 };
@@ -38,10 +64,1693 @@ double GEMBuffC7(double C7, double Rmin, Coord& POSi, Coord& POSj,
 {
   //Function to calculate buffered 14-7 style dispersion
   double Eij = 0; //Dispersion energy
-  
+  Coord dist = CoordDist2(POSi,POSj); //Minimum image displacement
+  double r = sqrt((dist.x*dist.x)+(dist.y*dist.y)+(dist.z*dist.z));
+  if (r < Rcut)
+  {
+    double rho = r/Rmin; //Reduced distance
+    double rho7 = pow(rho,7);
+    double dTaper; //Unused derivative
+    Eij = C7*pow(1.07/(rho+0.07),7)*((1.12/(rho7+0.12))-2);
+    Eij *= GEMTaper(r,Rcut,dTaper);
+  }
   //Return energy
   return Eij;
 };
 
+Matrix3d GEMFrame(vector<QMMMAtom>& QMMMData, int i, int bead)
+{
+  //Builds the rotation from the local frame of a GEM density to the global
+  //frame, with the local axes as the columns
+  //NB: The axes are defined in the same way as in RotateTINKPoles, so the
+  //density and the GEM multipoles rotate together
+  Matrix3d rotMat = Matrix3d::Identity(); //Local axes
+  bool flip; //Flip y axis
+  string type; //Frame type
+  int at1,at2,at3; //Atoms which define the frame
+  QMMMData[i].GEM[bead].getFrame(flip,type,at1,at2,at3);
+  if ((at1 < 0) or ((type != "Bisector") and (type != "Z-then-X") and
+     (type != "Z-Bisect") and (type != "3-Fold") and (type != "Z-Only")))
+  {
+    //Keep the global frame
+    return rotMat;
+  }
+  Coord& pos = QMMMData[i].P[bead];
+  Vector3d vecX,vecY,vecZ; //Local axes
+  //Point the z axis at the first atom
+  Coord& pos1 = QMMMData[at1].P[bead];
+  vecZ << (pos1.x-pos.x),(pos1.y-pos.y),(pos1.z-pos.z);
+  vecZ.normalize();
+  if (type == "Z-Only")
+  {
+    //Use a global axis for the second vector
+    //NB: Switch to the y axis if the overlap is large
+    vecX << 1,0,0;
+    if (vecZ(0) > 0.85)
+    {
+      vecX << 0,1,0;
+    }
+  }
+  else
+  {
+    //Point the x axis at the second atom
+    Coord& pos2 = QMMMData[at2].P[bead];
+    vecX << (pos2.x-pos.x),(pos2.y-pos.y),(pos2.z-pos.z);
+    vecX.normalize();
+  }
+  if ((type == "Z-Bisect") or (type == "3-Fold"))
+  {
+    //Point the y axis at the third atom
+    Coord& pos3 = QMMMData[at3].P[bead];
+    vecY << (pos3.x-pos.x),(pos3.y-pos.y),(pos3.z-pos.z);
+    vecY.normalize();
+  }
+  if (type == "Bisector")
+  {
+    //Bisect the two bonds
+    vecZ += vecX;
+    vecZ.normalize();
+  }
+  if (type == "Z-Bisect")
+  {
+    //Bisect the second and third bonds
+    vecX += vecY;
+    vecX.normalize();
+  }
+  if (type == "3-Fold")
+  {
+    //Combine all three bonds
+    vecZ += vecX+vecY;
+    vecZ.normalize();
+  }
+  //Subtract the overlap from the x axis and fill in the y axis
+  vecX -= vecZ*vecX.dot(vecZ);
+  vecX.normalize();
+  vecY = vecX.cross(vecZ);
+  vecY.normalize();
+  if (flip)
+  {
+    vecY *= -1;
+  }
+  rotMat.col(0) = vecX;
+  rotMat.col(1) = vecY;
+  rotMat.col(2) = vecZ;
+  return rotMat;
+};
+
+void GEMHermRotate(Matrix3d& rotMat, int T, int U, int V, vector<int>& ordX,
+                   vector<int>& ordY, vector<int>& ordZ, vector<double>& c)
+{
+  //Expands a local frame Hermite Gaussian of order (T,U,V) in global frame
+  //Hermite Gaussians with the same center and exponent
+  //NB: A Hermite Gaussian is a derivative with respect to its center, and
+  //the local derivatives are the global gradient along the local axes,
+  //so the (T+U+V) order terms are the expansion of a product of
+  //directional derivatives
+  int L = T+U+V; //Total order
+  int N = L+1; //Stride of the polynomial
+  vector<double> poly(N*N*N,0.0); //Coefficients of the global orders
+  vector<double> newPoly(N*N*N,0.0); //Product with the next axis
+  poly[0] = 1;
+  int deg = 0; //Degree of the polynomial
+  for (int ax=0;ax<3;ax++)
+  {
+    //Multiply by the derivative along each local axis
+    int Nmult = T; //Number of derivatives along the axis
+    if (ax == 1)
+    {
+      Nmult = U;
+    }
+    if (ax == 2)
+    {
+      Nmult = V;
+    }
+    for (int n=0;n<Nmult;n++)
+    {
+      fill(newPoly.begin(),newPoly.end(),0.0);
+      for (int a=0;a<=deg;a++)
+      {
+        for (int b=0;b<=(deg-a);b++)
+        {
+          int cz = deg-a-b; //Only terms of the current degree are set
+          double val = poly[(a*N+b)*N+cz]; //Current coefficient
+          if (val == 0)
+          {
+            continue;
+          }
+          newPoly[((a+1)*N+b)*N+cz] += val*rotMat(0,ax);
+          newPoly[(a*N+b+1)*N+cz] += val*rotMat(1,ax);
+          newPoly[(a*N+b)*N+cz+1] += val*rotMat(2,ax);
+        }
+      }
+      poly.swap(newPoly);
+      deg += 1;
+    }
+  }
+  //Save the nonzero terms
+  ordX.clear();
+  ordY.clear();
+  ordZ.clear();
+  c.clear();
+  for (int a=0;a<=L;a++)
+  {
+    for (int b=0;b<=(L-a);b++)
+    {
+      double val = poly[(a*N+b)*N+(L-a-b)]; //Coefficient
+      if (abs(val) > 1e-14)
+      {
+        ordX.push_back(a);
+        ordY.push_back(b);
+        ordZ.push_back(L-a-b);
+        c.push_back(val);
+      }
+    }
+  }
+  return;
+};
+
+//GEM density grids
+void GEMHornerBlock(int Nb, int T, const double* coeffs, double* dx,
+                    double* val, double* work)
+{
+  //Multiplies a block of values by a Hermite polynomial of order T
+  if (T == 0)
+  {
+    //Nothing to do, since P_0 = 1
+    return;
+  }
+  #pragma omp simd
+  for (int p=0;p<Nb;p++)
+  {
+    work[p] = coeffs[T];
+  }
+  for (int k=(T-1);k>=0;k--)
+  {
+    const double ck = coeffs[k];
+    #pragma omp simd
+    for (int p=0;p<Nb;p++)
+    {
+      work[p] = (work[p]*dx[p])+ck;
+    }
+  }
+  #pragma omp simd
+  for (int p=0;p<Nb;p++)
+  {
+    val[p] *= work[p];
+  }
+  return;
+};
+
+void GEMDensityPoints(GEMBatch& dens, int Npts, double* x, double* y,
+                      double* z, double* rho)
+{
+  //Evaluates a packed GEM density (a.u.) at a list of points (Ang)
+  //NB: Points are handled in blocks, so spatially sorted points are much
+  //faster, and periodic images are not included
+  const int blockSize = 256; //Points per block
+  int NL = hermMaxL+1; //Stride between polynomials
+  double cut = -1*log(gemScreen); //Exponent at the edge of a function
+  //Hermite polynomial coefficients of each group, where
+  //P_(t+1) = 2*a*X*P_t-2*a*t*P_(t-1)
+  int Ng = dens.Ngroups; //Number of groups
+  vector<double> polyX(Ng*NL,0),polyY(Ng*NL,0),polyZ(Ng*NL,0);
+  vector<double> groupR2(Ng); //Squared cutoff of each group (a.u.)
+  for (int ga=0;ga<Ng;ga++)
+  {
+    double a = dens.alpha[dens.groupStart[ga]]; //Exponent
+    int ords[3] = {dens.groupX[ga],dens.groupY[ga],dens.groupZ[ga]};
+    for (int d=0;d<3;d++)
+    {
+      vector<double>& poly = (d == 0) ? polyX : ((d == 1) ? polyY : polyZ);
+      vector<double> pOld(NL,0),pCur(NL,0),pNew(NL,0); //Recursion terms
+      pCur[0] = 1;
+      for (int t=0;t<ords[d];t++)
+      {
+        for (int k=0;k<NL;k++)
+        {
+          pNew[k] = -2*a*t*pOld[k];
+          if (k > 0)
+          {
+            pNew[k] += 2*a*pCur[k-1];
+          }
+        }
+        pOld = pCur;
+        pCur = pNew;
+      }
+      copy(pCur.begin(),pCur.end(),poly.begin()+ga*NL);
+    }
+    groupR2[ga] = (cut+3*(ords[0]+ords[1]+ords[2]))/a;
+  }
+  #pragma omp parallel
+  {
+    vector<double> bx(blockSize),by(blockSize),bz(blockSize); //Points
+    vector<double> bRho(blockSize); //Density at the points
+    vector<double> bdx(blockSize),bdy(blockSize),bdz(blockSize); //Offsets
+    vector<double> bVal(blockSize),bPoly(blockSize); //Function values
+    #pragma omp for schedule(dynamic)
+    for (int blk=0;blk<Npts;blk+=blockSize)
+    {
+      int Nb = min(blockSize,(Npts-blk)); //Points in the block
+      double lo[3] = {x[blk]/bohrRad,y[blk]/bohrRad,z[blk]/bohrRad};
+      double hi[3] = {lo[0],lo[1],lo[2]};
+      for (int p=0;p<Nb;p++)
+      {
+        //Convert to a.u. and find the bounding box
+        bx[p] = x[blk+p]/bohrRad;
+        by[p] = y[blk+p]/bohrRad;
+        bz[p] = z[blk+p]/bohrRad;
+        lo[0] = min(lo[0],bx[p]);
+        lo[1] = min(lo[1],by[p]);
+        lo[2] = min(lo[2],bz[p]);
+        hi[0] = max(hi[0],bx[p]);
+        hi[1] = max(hi[1],by[p]);
+        hi[2] = max(hi[2],bz[p]);
+        bRho[p] = 0;
+      }
+      double* px = &bx[0];
+      double* py = &by[0];
+      double* pz = &bz[0];
+      double* pRho = &bRho[0];
+      double* pdx = &bdx[0];
+      double* pdy = &bdy[0];
+      double* pdz = &bdz[0];
+      double* pVal = &bVal[0];
+      double* pPoly = &bPoly[0];
+      for (int ga=0;ga<Ng;ga++)
+      {
+        const int T = dens.groupX[ga]; //Hermite orders
+        const int U = dens.groupY[ga];
+        const int V = dens.groupZ[ga];
+        const double* cX = &polyX[ga*NL]; //Polynomial coefficients
+        const double* cY = &polyY[ga*NL];
+        const double* cZ = &polyZ[ga*NL];
+        const double rc2 = groupR2[ga]; //Squared cutoff
+        for (int f=dens.groupStart[ga];f<dens.groupStart[ga+1];f++)
+        {
+          //Skip functions which are far from the block
+          double fPos[3] = {dens.x[f],dens.y[f],dens.z[f]}; //Center
+          double dBox2 = 0; //Squared distance to the bounding box
+          for (int d=0;d<3;d++)
+          {
+            double gap = max(max((lo[d]-fPos[d]),(fPos[d]-hi[d])),0.0);
+            dBox2 += gap*gap;
+          }
+          if (dBox2 > rc2)
+          {
+            continue;
+          }
+          const double a = dens.alpha[f]; //Exponent
+          const double mag = dens.mag[f]; //Coefficient
+          //Gaussian and displacements
+          #pragma omp simd
+          for (int p=0;p<Nb;p++)
+          {
+            double dx = px[p]-fPos[0];
+            double dy = py[p]-fPos[1];
+            double dz = pz[p]-fPos[2];
+            double r2 = (dx*dx)+(dy*dy)+(dz*dz);
+            pdx[p] = dx;
+            pdy[p] = dy;
+            pdz[p] = dz;
+            double wt = (r2 < rc2) ? mag : 0; //Cutoff
+            pVal[p] = wt*LICHEMExp(-1*a*r2);
+          }
+          //Hermite polynomials from Horner's rule, one axis at a time
+          GEMHornerBlock(Nb,T,cX,pdx,pVal,pPoly);
+          GEMHornerBlock(Nb,U,cY,pdy,pVal,pPoly);
+          GEMHornerBlock(Nb,V,cZ,pdz,pVal,pPoly);
+          #pragma omp simd
+          for (int p=0;p<Nb;p++)
+          {
+            pRho[p] += pVal[p];
+          }
+        }
+      }
+      for (int p=0;p<Nb;p++)
+      {
+        rho[blk+p] = bRho[p];
+      }
+    }
+  }
+  return;
+};
+
+//GEM dispersion engine
+void GEMBuildNeighbors(vector<QMMMAtom>& QMMMData, GEMNeighborList& nbrList,
+                       int bead)
+{
+  //Builds the Verlet list of GEM dispersion pairs with a cell list
+  double Rlist = gemDispCut+gemDispSkin; //List cutoff
+  double Rlist2 = Rlist*Rlist;
+  //Collect the sites and parameters
+  nbrList.bead = bead;
+  nbrList.site.clear();
+  nbrList.C6.clear();
+  nbrList.eps.clear();
+  nbrList.Rmin.clear();
+  for (int i=0;i<Natoms;i++)
+  {
+    if (QMMMData[i].MMRegion and (((int)QMMMData[i].GEM.size()) > bead))
+    {
+      double C6,eps,Rmin; //Parameters
+      hermBasisDB.blockDisp(QMMMData[i].GEM[bead].blockID(),C6,eps,Rmin);
+      if ((C6 != 0) or (eps != 0))
+      {
+        nbrList.site.push_back(i);
+        nbrList.C6.push_back(C6);
+        nbrList.eps.push_back(eps);
+        nbrList.Rmin.push_back(Rmin);
+      }
+    }
+  }
+  int Ns = nbrList.site.size(); //Number of sites
+  nbrList.Nsites = Ns;
+  nbrList.x0.resize(Ns);
+  nbrList.y0.resize(Ns);
+  nbrList.z0.resize(Ns);
+  for (int i=0;i<Ns;i++)
+  {
+    nbrList.x0[i] = QMMMData[nbrList.site[i]].P[bead].x;
+    nbrList.y0[i] = QMMMData[nbrList.site[i]].P[bead].y;
+    nbrList.z0[i] = QMMMData[nbrList.site[i]].P[bead].z;
+  }
+  nbrList.box[0] = Lx;
+  nbrList.box[1] = Ly;
+  nbrList.box[2] = Lz;
+  //Sort the sites into cells
+  //NB: Without PBC, the cells cover the bounding box of the sites
+  double lo[3] = {0,0,0}; //Lower corner of the cells
+  double len[3] = {Lx,Ly,Lz}; //Lengths covered by the cells
+  if (!PBCon)
+  {
+    for (int d=0;d<3;d++)
+    {
+      vector<double>& pos = (d == 0) ? nbrList.x0 :
+                            ((d == 1) ? nbrList.y0 : nbrList.z0);
+      double hi = lo[d];
+      if (Ns > 0)
+      {
+        lo[d] = *min_element(pos.begin(),pos.end());
+        hi = *max_element(pos.begin(),pos.end());
+      }
+      len[d] = max((hi-lo[d])*(1+1e-12),1e-6);
+    }
+  }
+  int Nc[3]; //Number of cells in each direction
+  int dMax[3]; //Range of neighboring cells
+  for (int d=0;d<3;d++)
+  {
+    Nc[d] = max((int)floor(len[d]/Rlist),1);
+    if (PBCon and (Nc[d] < 3))
+    {
+      //Periodic images would be visited twice
+      Nc[d] = 1;
+    }
+    dMax[d] = (Nc[d] > 1) ? 1 : 0;
+  }
+  int Ncells = Nc[0]*Nc[1]*Nc[2]; //Total number of cells
+  vector<int> siteCell(Ns); //Cell of each site
+  vector<int> cellStart(Ncells+1,0); //First site of each cell
+  for (int i=0;i<Ns;i++)
+  {
+    double pos[3] = {nbrList.x0[i],nbrList.y0[i],nbrList.z0[i]};
+    int cid[3]; //Cell indices
+    for (int d=0;d<3;d++)
+    {
+      double frac = (pos[d]-lo[d])/len[d]; //Fractional coordinate
+      frac -= floor(frac);
+      cid[d] = min((int)(frac*Nc[d]),(Nc[d]-1));
+    }
+    siteCell[i] = (cid[0]*Nc[1]+cid[1])*Nc[2]+cid[2];
+    cellStart[siteCell[i]+1] += 1;
+  }
+  for (int c=0;c<Ncells;c++)
+  {
+    cellStart[c+1] += cellStart[c];
+  }
+  vector<int> cellSites(Ns); //Sites sorted by cell
+  vector<int> cellFill = cellStart; //Next free slot in each cell
+  for (int i=0;i<Ns;i++)
+  {
+    cellSites[cellFill[siteCell[i]]] = i;
+    cellFill[siteCell[i]] += 1;
+  }
+  //Find the neighbors of each site
+  vector<vector<int> > siteNbrs(Ns); //Neighbors of each site
+  #pragma omp parallel for schedule(dynamic,64)
+  for (int i=0;i<Ns;i++)
+  {
+    int c = siteCell[i]; //Cell of the site
+    int cx = c/(Nc[1]*Nc[2]); //Cell indices
+    int cy = (c/Nc[2])%Nc[1];
+    int cz = c%Nc[2];
+    for (int dx=-dMax[0];dx<=dMax[0];dx++)
+    {
+      int nx = cx+dx; //Neighboring cell index
+      if (PBCon)
+      {
+        nx = (nx+Nc[0])%Nc[0];
+      }
+      else if ((nx < 0) or (nx >= Nc[0]))
+      {
+        continue;
+      }
+      for (int dy=-dMax[1];dy<=dMax[1];dy++)
+      {
+        int ny = cy+dy; //Neighboring cell index
+        if (PBCon)
+        {
+          ny = (ny+Nc[1])%Nc[1];
+        }
+        else if ((ny < 0) or (ny >= Nc[1]))
+        {
+          continue;
+        }
+        for (int dz=-dMax[2];dz<=dMax[2];dz++)
+        {
+          int nz = cz+dz; //Neighboring cell index
+          if (PBCon)
+          {
+            nz = (nz+Nc[2])%Nc[2];
+          }
+          else if ((nz < 0) or (nz >= Nc[2]))
+          {
+            continue;
+          }
+          int c2 = (nx*Nc[1]+ny)*Nc[2]+nz; //Neighboring cell
+          for (int q=cellStart[c2];q<cellStart[c2+1];q++)
+          {
+            int j = cellSites[q]; //Neighboring site
+            if (j <= i)
+            {
+              //Pairs are stored once
+              continue;
+            }
+            double rx = nbrList.x0[i]-nbrList.x0[j];
+            double ry = nbrList.y0[i]-nbrList.y0[j];
+            double rz = nbrList.z0[i]-nbrList.z0[j];
+            //Minimum image convention
+            pbcBox.minImage(rx,ry,rz);
+            if (((rx*rx)+(ry*ry)+(rz*rz)) <= Rlist2)
+            {
+              siteNbrs[i].push_back(j);
+            }
+          }
+        }
+      }
+    }
+  }
+  //Pack the list
+  nbrList.start.assign(Ns+1,0);
+  for (int i=0;i<Ns;i++)
+  {
+    nbrList.start[i+1] = nbrList.start[i]+siteNbrs[i].size();
+  }
+  nbrList.nbrs.resize(nbrList.start[Ns]);
+  for (int i=0;i<Ns;i++)
+  {
+    copy(siteNbrs[i].begin(),siteNbrs[i].end(),
+         nbrList.nbrs.begin()+nbrList.start[i]);
+  }
+  nbrList.Nbuilds += 1;
+  return;
+};
+
+bool GEMCheckNeighbors(vector<QMMMAtom>& QMMMData, GEMNeighborList& nbrList,
+                       int bead)
+{
+  //Rebuilds the GEM dispersion neighbor list if it is out of date
+  //NB: Returns true when the list was rebuilt
+  bool rebuild = 0; //Flag to rebuild the list
+  if ((nbrList.bead != bead) or (nbrList.box[0] != Lx) or
+     (nbrList.box[1] != Ly) or (nbrList.box[2] != Lz))
+  {
+    //The list is from a different bead or box
+    rebuild = 1;
+  }
+  else
+  {
+    //Check the displacements since the last build
+    double maxDisp2 = 0.25*gemDispSkin*gemDispSkin; //Half of the skin
+    int Ns = nbrList.Nsites; //Number of sites
+    #pragma omp parallel for schedule(static) reduction(||:rebuild)
+    for (int i=0;i<Ns;i++)
+    {
+      Coord& pos = QMMMData[nbrList.site[i]].P[bead]; //Current position
+      double dx = pos.x-nbrList.x0[i];
+      double dy = pos.y-nbrList.y0[i];
+      double dz = pos.z-nbrList.z0[i];
+      if (((dx*dx)+(dy*dy)+(dz*dz)) > maxDisp2)
+      {
+        rebuild = 1;
+      }
+    }
+  }
+  if (rebuild)
+  {
+    GEMBuildNeighbors(QMMMData,nbrList,bead);
+  }
+  return rebuild;
+};
+
+double GEMDispEnergy(vector<QMMMAtom>& QMMMData, GEMNeighborList& nbrList,
+                     int bead)
+{
+  //Calculates the GEM dispersion energy (eV) between the MM sites
+  //NB: Pairs are C6 and buffered 14-7 terms with AMOEBA combining rules,
+  //which are tapered to zero at the cutoff
+  GEMCheckNeighbors(QMMMData,nbrList,bead);
+  int Ns = nbrList.Nsites; //Number of sites
+  double Rcut2 = gemDispCut*gemDispCut; //Squared cutoff
+  //Current positions
+  vector<double> xs(Ns),ys(Ns),zs(Ns); //Site positions
+  for (int i=0;i<Ns;i++)
+  {
+    xs[i] = QMMMData[nbrList.site[i]].P[bead].x;
+    ys[i] = QMMMData[nbrList.site[i]].P[bead].y;
+    zs[i] = QMMMData[nbrList.site[i]].P[bead].z;
+  }
+  double Edisp = 0; //Dispersion energy
+  #pragma omp parallel for schedule(dynamic,64) reduction(+:Edisp)
+  for (int i=0;i<Ns;i++)
+  {
+    int first = nbrList.start[i]; //First neighbor
+    int Nnbrs = nbrList.start[i+1]-first; //Number of neighbors
+    const int* nbr = &nbrList.nbrs[0]+first; //Neighbors of i
+    const double* C6s = &nbrList.C6[0];
+    const double* epss = &nbrList.eps[0];
+    const double* Rmins = &nbrList.Rmin[0];
+    const double xi = xs[i];
+    const double yi = ys[i];
+    const double zi = zs[i];
+    const double C6i = C6s[i];
+    const double epsi = epss[i];
+    const double Ri = Rmins[i];
+    const double rOn = gemDispTaper*gemDispCut; //Start of the taper
+    const double rWidth = gemDispCut-rOn; //Width of the taper
+    double Ei = 0; //Energy of the pairs
+    #pragma omp simd reduction(+:Ei)
+    for (int k=0;k<Nnbrs;k++)
+    {
+      int j = nbr[k]; //Neighboring site
+      double dx = xi-xs[j];
+      double dy = yi-ys[j];
+      double dz = zi-zs[j];
+      //Minimum image convention
+      pbcBox.minImage(dx,dy,dz);
+      double r2 = (dx*dx)+(dy*dy)+(dz*dz);
+      double r = sqrt(r2);
+      //Combined parameters
+      double C6ij = sqrt(C6i*C6s[j]);
+      double sqE = sqrt(epsi)+sqrt(epss[j]);
+      double epsij = (sqE > 0) ? (4*epsi*epss[j]/(sqE*sqE)) : 0;
+      double Rj = Rmins[j];
+      double R2sum = (Ri*Ri)+(Rj*Rj);
+      double Rij = (R2sum > 0) ? (((Ri*Ri*Ri)+(Rj*Rj*Rj))/R2sum) : 1;
+      //C6 term
+      double ir2 = 1/r2;
+      double E = -1*C6ij*ir2*ir2*ir2;
+      //Buffered 14-7 term
+      double rho = r/Rij; //Reduced distance
+      double rho7 = rho*rho*rho*rho*rho*rho*rho;
+      double t1 = 1.07/(rho+0.07);
+      double t2 = t1*t1;
+      E += epsij*t2*t2*t2*t1*((1.12/(rho7+0.12))-2);
+      //Taper and cutoff
+      double x = (r-rOn)/rWidth; //Position in the taper
+      x = (x > 0) ? x : 0;
+      double x2 = x*x;
+      double S = 1-(10*x2*x)+(15*x2*x2)-(6*x2*x2*x);
+      double inside = (r2 < Rcut2) ? 1 : 0;
+      Ei += inside*E*S;
+    }
+    Edisp += Ei;
+  }
+  return Edisp;
+};
+
+//GEM electrostatics engine
+void PackGEMDensity(vector<QMMMAtom>& QMMMData, vector<int>& atoms,
+                    int bead, GEMBatch& dens)
+{
+  //Packs the GEM densities of a set of atoms into groups of functions
+  //with the same exponent and Hermite orders
+  //NB: The positions (Ang) and Hermite orders of the basis functions are
+  //in the local frame of the atom, so they are rotated to the global frame
+  //before packing
+  vector<double> keyA; //Exponent of each group
+  vector<int> keyX,keyY,keyZ; //Hermite orders of each group
+  vector<int> funcGroup; //Group of each function
+  vector<int> funcAtom; //Atom of each function
+  vector<double> funcMag; //Global frame coefficient of each function
+  vector<double> funcX,funcY,funcZ; //Global position of each function
+  vector<int> ordX,ordY,ordZ; //Global Hermite orders of a local function
+  vector<double> ordC; //Coefficients of the global Hermite orders
+  for (unsigned int i=0;i<atoms.size();i++)
+  {
+    int at = atoms[i]; //Atom ID
+    vector<HermGau>& basis = QMMMData[at].GEM[bead].basis();
+    Matrix3d rotMat = GEMFrame(QMMMData,at,bead); //Local axes
+    for (unsigned int j=0;j<basis.size();j++)
+    {
+      //Rotate the offset and the Hermite orders
+      Vector3d offset; //Position relative to the atom
+      offset << basis[j].xPos(),basis[j].yPos(),basis[j].zPos();
+      offset = rotMat*offset;
+      GEMHermRotate(rotMat,basis[j].xPow(),basis[j].yPow(),basis[j].zPow(),
+                    ordX,ordY,ordZ,ordC);
+      for (unsigned int n=0;n<ordC.size();n++)
+      {
+        //Find the group
+        int grp = -1; //Group ID
+        for (unsigned int k=0;k<keyA.size();k++)
+        {
+          if ((keyA[k] == basis[j].getAlpha()) and (keyX[k] == ordX[n]) and
+             (keyY[k] == ordY[n]) and (keyZ[k] == ordZ[n]))
+          {
+            grp = k;
+            break;
+          }
+        }
+        if (grp < 0)
+        {
+          //Create a new group
+          grp = keyA.size();
+          keyA.push_back(basis[j].getAlpha());
+          keyX.push_back(ordX[n]);
+          keyY.push_back(ordY[n]);
+          keyZ.push_back(ordZ[n]);
+        }
+        funcGroup.push_back(grp);
+        funcAtom.push_back(at);
+        funcMag.push_back(basis[j].coeff()*ordC[n]);
+        funcX.push_back((QMMMData[at].P[bead].x+offset(0))/bohrRad);
+        funcY.push_back((QMMMData[at].P[bead].y+offset(1))/bohrRad);
+        funcZ.push_back((QMMMData[at].P[bead].z+offset(2))/bohrRad);
+      }
+    }
+  }
+  //Set up the groups
+  dens.Nfuncs = funcGroup.size();
+  dens.Ngroups = keyA.size();
+  dens.groupX = keyX;
+  dens.groupY = keyY;
+  dens.groupZ = keyZ;
+  dens.groupStart.assign(dens.Ngroups+1,0);
+  for (int i=0;i<dens.Nfuncs;i++)
+  {
+    dens.groupStart[funcGroup[i]+1] += 1;
+  }
+  for (int k=0;k<dens.Ngroups;k++)
+  {
+    dens.groupStart[k+1] += dens.groupStart[k];
+  }
+  //Pack the functions
+  dens.atom.resize(dens.Nfuncs);
+  dens.mag.resize(dens.Nfuncs);
+  dens.alpha.resize(dens.Nfuncs);
+  dens.x.resize(dens.Nfuncs);
+  dens.y.resize(dens.Nfuncs);
+  dens.z.resize(dens.Nfuncs);
+  vector<int> groupFill = dens.groupStart; //Next free slot in each group
+  for (int i=0;i<dens.Nfuncs;i++)
+  {
+    int slot = groupFill[funcGroup[i]];
+    groupFill[funcGroup[i]] += 1;
+    dens.atom[slot] = funcAtom[i];
+    dens.mag[slot] = funcMag[i];
+    dens.alpha[slot] = keyA[funcGroup[i]];
+    dens.x[slot] = funcX[i];
+    dens.y[slot] = funcY[i];
+    dens.z[slot] = funcZ[i];
+  }
+  return;
+};
+
+double GEMPairSum(int T, int U, int V, double mu, int Npairs, double* X,
+                  double* Y, double* Z, double* pairMag)
+{
+  //Sums the Hermite Coulomb integrals R_TUV(mu,X,Y,Z) for a list of pairs
+  //NB: This is the closed form of the McMurchie-Davidson recursion, which
+  //is a product of Hermite polynomials in X, Y, and Z times Boys functions
+  int L = T+U+V; //Total order
+  if (L > hermMaxL)
+  {
+    //Order is too large
+    cerr << "Error: Hermite Gaussian order " << L;
+    cerr << " is larger than the maximum (" << hermMaxL << ")!!!";
+    cerr << '\n' << '\n';
+    cerr.flush();
+    exit(0);
+  }
+  //Coefficients of the Hermite polynomials
+  double cT[hermMaxL+1],cU[hermMaxL+1],cV[hermMaxL+1];
+  for (int i=0;(2*i)<=T;i++)
+  {
+    cT[i] = LICHEMFactorial(T)/(LICHEMFactorial(i)*LICHEMFactorial(T-2*i));
+  }
+  for (int i=0;(2*i)<=U;i++)
+  {
+    cU[i] = LICHEMFactorial(U)/(LICHEMFactorial(i)*LICHEMFactorial(U-2*i));
+  }
+  for (int i=0;(2*i)<=V;i++)
+  {
+    cV[i] = LICHEMFactorial(V)/(LICHEMFactorial(i)*LICHEMFactorial(V-2*i));
+  }
+  double muPow[hermMaxL+1]; //(-mu)^m
+  muPow[0] = 1;
+  for (int m=1;m<=L;m++)
+  {
+    muPow[m] = -1*mu*muPow[m-1];
+  }
+  //Pairs with a small overlap skip the Boys function table
+  double farArg = min(-1*log(gemScreen),boysMaxX);
+  const double* tab = &boysTab.vals[L]; //Table for order L
+  const int Nord = boysTab.Nord; //Stride between grid points
+  double Esum = 0; //Sum of the integrals
+  #pragma omp simd reduction(+:Esum)
+  for (int p=0;p<Npairs;p++)
+  {
+    double arg = mu*(X[p]*X[p]+Y[p]*Y[p]+Z[p]*Z[p]); //Boys argument
+    double F[hermMaxL+1]; //Boys functions
+    if (arg > farArg)
+    {
+      //Upward recursion is stable for large arguments
+      //NB: The exponential is kept, since the higher orders are not
+      //accurate without it
+      double expX = exp(-1*arg); //Exponential term
+      F[0] = sqrt(pi/(4*arg));
+      for (int n=1;n<=L;n++)
+      {
+        F[n] = (((2*n-1)*F[n-1])-expX)/(2*arg);
+      }
+    }
+    else
+    {
+      //Taylor series and downward recursion
+      int pt = (int)((arg/boysStep)+0.5); //Nearest grid point
+      double dx = (pt*boysStep)-arg; //Negative displacement
+      double val = tab[pt*Nord+boysTaylor-1];
+      for (int k=(boysTaylor-1);k>0;k--)
+      {
+        val = tab[pt*Nord+k-1]+(dx*val/k);
+      }
+      F[L] = val;
+      double expX = exp(-1*arg); //Exponential term
+      for (int n=L;n>0;n--)
+      {
+        F[n-1] = ((2*arg*F[n])+expX)/(2*n-1);
+      }
+    }
+    //Powers of the displacements
+    double powX[hermMaxL+1],powY[hermMaxL+1],powZ[hermMaxL+1];
+    powX[0] = 1;
+    powY[0] = 1;
+    powZ[0] = 1;
+    for (int n=1;n<=T;n++)
+    {
+      powX[n] = 2*X[p]*powX[n-1];
+    }
+    for (int n=1;n<=U;n++)
+    {
+      powY[n] = 2*Y[p]*powY[n-1];
+    }
+    for (int n=1;n<=V;n++)
+    {
+      powZ[n] = 2*Z[p]*powZ[n-1];
+    }
+    //Combine the terms
+    double R = 0; //Hermite Coulomb integral
+    for (int i=0;(2*i)<=T;i++)
+    {
+      for (int j=0;(2*j)<=U;j++)
+      {
+        for (int k=0;(2*k)<=V;k++)
+        {
+          int m = L-i-j-k; //Derivative order
+          R += cT[i]*cU[j]*cV[k]*powX[T-2*i]*powY[U-2*j]*powZ[V-2*k]*
+               muPow[m]*F[m];
+        }
+      }
+    }
+    Esum += pairMag[p]*R;
+  }
+  return Esum;
+};
+
+double GEMCoulomb(GEMBatch& densA, GEMBatch& densB, bool sameSet)
+{
+  //Calculates the Coulomb energy between two packed GEM densities
+  //NB: If sameSet is true, each pair is counted once and functions on
+  //the same atom are skipped
+  double Eij = 0; //Energy
+  PBCBox boxB = pbcBox; //Periodic cell (a.u.)
+  boxB.scale(1/bohrRad);
+  int Npairs = densA.Ngroups*densB.Ngroups; //Number of group pairs
+  #pragma omp parallel reduction(+:Eij)
+  {
+    vector<double> X,Y,Z,pairMag; //Pair data
+    #pragma omp for schedule(dynamic)
+    for (int gp=0;gp<Npairs;gp++)
+    {
+      int ga = gp/densB.Ngroups; //Group in A
+      int gb = gp%densB.Ngroups; //Group in B
+      if (sameSet and (gb < ga))
+      {
+        //Pairs are counted by the other group
+        continue;
+      }
+      //Collect the pairs
+      X.clear();
+      Y.clear();
+      Z.clear();
+      pairMag.clear();
+      for (int i=densA.groupStart[ga];i<densA.groupStart[ga+1];i++)
+      {
+        for (int j=densB.groupStart[gb];j<densB.groupStart[gb+1];j++)
+        {
+          if (sameSet and ((densA.atom[i] == densB.atom[j]) or
+             ((ga == gb) and (j <= i))))
+          {
+            //Skip intramolecular and double counted pairs
+            continue;
+          }
+          double dx = densA.x[i]-densB.x[j];
+          double dy = densA.y[i]-densB.y[j];
+          double dz = densA.z[i]-densB.z[j];
+          //Minimum image convention
+          boxB.minImage(dx,dy,dz);
+          X.push_back(dx);
+          Y.push_back(dy);
+          Z.push_back(dz);
+          pairMag.push_back(densA.mag[i]*densB.mag[j]);
+        }
+      }
+      if (pairMag.empty())
+      {
+        continue;
+      }
+      //Calculate the integrals
+      double ai = densA.alpha[densA.groupStart[ga]]; //Exponent of group A
+      double aj = densB.alpha[densB.groupStart[gb]]; //Exponent of group B
+      int T = densA.groupX[ga]+densB.groupX[gb];
+      int U = densA.groupY[ga]+densB.groupY[gb];
+      int V = densA.groupZ[ga]+densB.groupZ[gb];
+      double Egrp = GEMPairSum(T,U,V,(ai*aj/(ai+aj)),pairMag.size(),
+                               &X[0],&Y[0],&Z[0],&pairMag[0]);
+      Egrp *= 2*pow(pi,2.5)/(ai*aj*sqrt(ai+aj));
+      if (((densB.groupX[gb]+densB.groupY[gb]+densB.groupZ[gb])%2) == 1)
+      {
+        //Derivatives on the second center have the opposite sign
+        Egrp *= -1;
+      }
+      Eij += Egrp;
+    }
+  }
+  //Change units and return
+  Eij *= har2eV;
+  return Eij;
+};
+
+double GEMChargeCoulomb(GEMBatch& dens, vector<double>& charges)
+{
+  //Calculates the Coulomb energy between a packed GEM density and
+  //point-charges packed as (x,y,z,q) in Angstroms
+  double Eij = 0; //Energy
+  PBCBox boxB = pbcBox; //Periodic cell (a.u.)
+  boxB.scale(1/bohrRad);
+  int Nchrg = charges.size()/4; //Number of charges
+  #pragma omp parallel reduction(+:Eij)
+  {
+    vector<double> X,Y,Z,pairMag; //Pair data
+    #pragma omp for schedule(dynamic)
+    for (int ga=0;ga<dens.Ngroups;ga++)
+    {
+      //Collect the pairs
+      X.clear();
+      Y.clear();
+      Z.clear();
+      pairMag.clear();
+      for (int i=dens.groupStart[ga];i<dens.groupStart[ga+1];i++)
+      {
+        for (int j=0;j<Nchrg;j++)
+        {
+          double dx = dens.x[i]-(charges[4*j]/bohrRad);
+          double dy = dens.y[i]-(charges[4*j+1]/bohrRad);
+          double dz = dens.z[i]-(charges[4*j+2]/bohrRad);
+          //Minimum image convention
+          boxB.minImage(dx,dy,dz);
+          X.push_back(dx);
+          Y.push_back(dy);
+          Z.push_back(dz);
+          pairMag.push_back(dens.mag[i]*charges[4*j+3]);
+        }
+      }
+      if (pairMag.empty())
+      {
+        continue;
+      }
+      //Calculate the integrals
+      double ai = dens.alpha[dens.groupStart[ga]]; //Exponent of the group
+      double Egrp = GEMPairSum(dens.groupX[ga],dens.groupY[ga],
+                               dens.groupZ[ga],ai,pairMag.size(),
+                               &X[0],&Y[0],&Z[0],&pairMag[0]);
+      Egrp *= 2*pi/ai;
+      Eij += Egrp;
+    }
+  }
+  //Change units and return
+  Eij *= har2eV;
+  return Eij;
+};
+
+//GEM grid electrostatics
+void GEMGridSetup(int& Nx, int& Ny, int& Nz, double& g)
+{
+  //Chooses the FFT grid and the Ewald splitting exponent
+  //NB: The short-range kernel, erfc(sqrt(g/2)*r)/r, is smaller than
+  //gemScreen beyond the real-space cutoff
+  if (!PBCon)
+  {
+    //The grid is periodic
+    cerr << "Error: GEM grid electrostatics require PBC!!!";
+    cerr << '\n' << '\n';
+    cerr.flush();
+    exit(0);
+  }
+  if ((2*gemEwaldCut) > min(Lx,min(Ly,Lz)))
+  {
+    //The minimum image convention fails
+    cerr << "Error: The box is too small for the GEM Ewald cutoff!!!";
+    cerr << '\n' << '\n';
+    cerr.flush();
+    exit(0);
+  }
+  //Power of two grids
+  Nx = 1;
+  while ((Nx*gemGridSpace) < Lx)
+  {
+    Nx *= 2;
+  }
+  Ny = 1;
+  while ((Ny*gemGridSpace) < Ly)
+  {
+    Ny *= 2;
+  }
+  Nz = 1;
+  while ((Nz*gemGridSpace) < Lz)
+  {
+    Nz *= 2;
+  }
+  //Splitting exponent
+  double rc = gemEwaldCut/bohrRad; //Cutoff (a.u.)
+  g = -2*log(gemScreen)/(rc*rc);
+  return;
+};
+
+void GEMGridSpread(GEMBatch& dens, double g, int Nx, int Ny, int Nz,
+                   vector<double>& rho)
+{
+  //Spreads the GEM density, smoothed by a normalized Gaussian with exponent
+  //g, onto a periodic grid
+  double hx = Lx/(bohrRad*Nx); //Grid spacing (a.u.)
+  double hy = Ly/(bohrRad*Ny); //Grid spacing (a.u.)
+  double hz = Lz/(bohrRad*Nz); //Grid spacing (a.u.)
+  double cut = -1*log(gemScreen); //Exponent at the edge of a function
+  rho.assign(Nx*Ny*Nz,0);
+  #pragma omp parallel
+  {
+    //Each thread fills a slab of x planes
+    int Nthr = omp_get_num_threads(); //Number of threads
+    int thr = omp_get_thread_num(); //Thread ID
+    int xStart = (thr*Nx)/Nthr; //First plane
+    int xEnd = ((thr+1)*Nx)/Nthr; //End of the slab
+    vector<double> fx,fy,fz; //One dimensional factors
+    vector<int> ix,iy,iz; //Grid indices
+    for (int ga=0;ga<dens.Ngroups;ga++)
+    {
+      int T = dens.groupX[ga]; //Hermite orders
+      int U = dens.groupY[ga];
+      int V = dens.groupZ[ga];
+      for (int f=dens.groupStart[ga];f<dens.groupStart[ga+1];f++)
+      {
+        double a = dens.alpha[f]; //Exponent
+        double aS = a*g/(a+g); //Smoothed exponent
+        //Find the x planes in the slab
+        double rs = sqrt((cut+3*T)/aS); //Window radius
+        int i0 = (int)ceil((dens.x[f]-rs)/hx);
+        int i1 = (int)floor((dens.x[f]+rs)/hx);
+        fx.clear();
+        ix.clear();
+        for (int i=i0;i<=i1;i++)
+        {
+          int idx = ((i%Nx)+Nx)%Nx; //Periodic index
+          if ((idx >= xStart) and (idx < xEnd))
+          {
+            fx.push_back(HermGau1D(T,aS,((i*hx)-dens.x[f])));
+            ix.push_back(idx);
+          }
+        }
+        if (ix.empty())
+        {
+          continue;
+        }
+        //Factors in y and z
+        rs = sqrt((cut+3*U)/aS);
+        i0 = (int)ceil((dens.y[f]-rs)/hy);
+        i1 = (int)floor((dens.y[f]+rs)/hy);
+        fy.clear();
+        iy.clear();
+        for (int i=i0;i<=i1;i++)
+        {
+          fy.push_back(HermGau1D(U,aS,((i*hy)-dens.y[f])));
+          iy.push_back(((i%Ny)+Ny)%Ny);
+        }
+        rs = sqrt((cut+3*V)/aS);
+        i0 = (int)ceil((dens.z[f]-rs)/hz);
+        i1 = (int)floor((dens.z[f]+rs)/hz);
+        fz.clear();
+        iz.clear();
+        for (int i=i0;i<=i1;i++)
+        {
+          fz.push_back(HermGau1D(V,aS,((i*hz)-dens.z[f])));
+          iz.push_back(((i%Nz)+Nz)%Nz);
+        }
+        //Add the function to the grid
+        double scale = dens.mag[f]*pow(aS/a,1.5); //Smoothed magnitude
+        int Nwz = fz.size(); //Window size in z
+        for (unsigned int kx=0;kx<ix.size();kx++)
+        {
+          for (unsigned int ky=0;ky<iy.size();ky++)
+          {
+            double fxy = scale*fx[kx]*fy[ky]; //Product of x and y
+            double* row = &rho[(ix[kx]*Ny+iy[ky])*Nz]; //Line along z
+            #pragma omp simd
+            for (int kz=0;kz<Nwz;kz++)
+            {
+              row[iz[kz]] += fxy*fz[kz];
+            }
+          }
+        }
+      }
+    }
+  }
+  return;
+};
+
+void GEMGridSolve(vector<double>& rho, int Nx, int Ny, int Nz,
+                  vector<double>& phi)
+{
+  //Solves the periodic Poisson equation for a grid density
+  //NB: The k = 0 term is dropped, which assumes a neutral cell
+  double LxB = Lx/bohrRad; //Box length (a.u.)
+  double LyB = Ly/bohrRad; //Box length (a.u.)
+  double LzB = Lz/bohrRad; //Box length (a.u.)
+  int Npts = Nx*Ny*Nz; //Number of grid points
+  vector<complex<double> > rhoK(rho.begin(),rho.end()); //Transformed grid
+  LICHEMFFT3D(rhoK,Nx,Ny,Nz,0);
+  #pragma omp parallel for schedule(static)
+  for (int ix=0;ix<Nx;ix++)
+  {
+    //Multiply by the Coulomb kernel, 4*pi/k^2
+    int mx = (ix < (Nx/2)) ? ix : (ix-Nx); //Wave number
+    double kx = 2*pi*mx/LxB;
+    for (int iy=0;iy<Ny;iy++)
+    {
+      int my = (iy < (Ny/2)) ? iy : (iy-Ny); //Wave number
+      double ky = 2*pi*my/LyB;
+      for (int iz=0;iz<Nz;iz++)
+      {
+        int mz = (iz < (Nz/2)) ? iz : (iz-Nz); //Wave number
+        double kz = 2*pi*mz/LzB;
+        double k2 = (kx*kx)+(ky*ky)+(kz*kz);
+        int idx = (ix*Ny+iy)*Nz+iz; //Grid index
+        if (k2 == 0)
+        {
+          rhoK[idx] = 0;
+        }
+        else
+        {
+          rhoK[idx] *= 4*pi/(k2*Npts);
+        }
+      }
+    }
+  }
+  LICHEMFFT3D(rhoK,Nx,Ny,Nz,1);
+  phi.resize(Npts);
+  #pragma omp parallel for schedule(static)
+  for (int i=0;i<Npts;i++)
+  {
+    phi[i] = rhoK[i].real();
+  }
+  return;
+};
+
+void GEMGridCells(GEMBatch& dens, int* Nc, vector<int>& cellStart,
+                  vector<int>& cellFuncs)
+{
+  //Sorts the functions of a packed GEM density into cells for the
+  //real-space part of the Ewald sum
+  //NB: Dimensions with fewer than three cells use a single cell
+  double boxL[3] = {Lx/bohrRad,Ly/bohrRad,Lz/bohrRad}; //Box (a.u.)
+  double rc = gemEwaldCut/bohrRad; //Cutoff (a.u.)
+  for (int d=0;d<3;d++)
+  {
+    Nc[d] = (int)floor(boxL[d]/rc);
+    if (Nc[d] < 3)
+    {
+      Nc[d] = 1;
+    }
+  }
+  int Ncells = Nc[0]*Nc[1]*Nc[2]; //Total number of cells
+  vector<int> funcCell(dens.Nfuncs); //Cell of each function
+  cellStart.assign(Ncells+1,0);
+  for (int f=0;f<dens.Nfuncs;f++)
+  {
+    double pos[3] = {dens.x[f],dens.y[f],dens.z[f]}; //Position
+    int cid[3]; //Cell indices
+    for (int d=0;d<3;d++)
+    {
+      double frac = pos[d]/boxL[d]; //Fractional coordinate
+      frac -= floor(frac);
+      cid[d] = (int)(frac*Nc[d]);
+      if (cid[d] >= Nc[d])
+      {
+        cid[d] = Nc[d]-1;
+      }
+    }
+    funcCell[f] = (cid[0]*Nc[1]+cid[1])*Nc[2]+cid[2];
+    cellStart[funcCell[f]+1] += 1;
+  }
+  for (int c=0;c<Ncells;c++)
+  {
+    cellStart[c+1] += cellStart[c];
+  }
+  vector<int> cellFill = cellStart; //Next free slot in each cell
+  cellFuncs.resize(dens.Nfuncs);
+  for (int f=0;f<dens.Nfuncs;f++)
+  {
+    cellFuncs[cellFill[funcCell[f]]] = f;
+    cellFill[funcCell[f]] += 1;
+  }
+  return;
+};
+
+double GEMEwaldPairs(int T, int U, int V, double ai, double aj, double g,
+                     bool longOnly, int Npairs, double* X, double* Y,
+                     double* Z, double* pairMag)
+{
+  //Sums the Ewald split Coulomb integrals for a list of Hermite Gaussian
+  //pairs, either the short-range part (full minus long-range) or only the
+  //long-range part
+  //NB: The long-range part smooths both functions by a normalized Gaussian
+  //with exponent g, and aj = 0 marks point-charges
+  double aiS = ai*g/(ai+g); //Smoothed exponent
+  double pref,mu; //Full integral prefactor and reduced exponent
+  double prefS,muS; //Long-range prefactor and reduced exponent
+  if (aj > 0)
+  {
+    //Gaussian pairs
+    double ajS = aj*g/(aj+g); //Smoothed exponent
+    pref = 2*pow(pi,2.5)/(ai*aj*sqrt(ai+aj));
+    mu = ai*aj/(ai+aj);
+    prefS = pow((aiS*ajS)/(ai*aj),1.5)*2*pow(pi,2.5);
+    prefS /= aiS*ajS*sqrt(aiS+ajS);
+    muS = aiS*ajS/(aiS+ajS);
+  }
+  else
+  {
+    //Gaussian and point-charge pairs
+    pref = 2*pi/ai;
+    mu = ai;
+    prefS = pow(aiS*g/(ai*pi),1.5)*2*pow(pi,2.5);
+    prefS /= aiS*g*sqrt(aiS+g);
+    muS = aiS*g/(aiS+g);
+  }
+  double Esum = prefS*GEMPairSum(T,U,V,muS,Npairs,X,Y,Z,pairMag);
+  if (!longOnly)
+  {
+    //Short-range part
+    Esum = (pref*GEMPairSum(T,U,V,mu,Npairs,X,Y,Z,pairMag))-Esum;
+  }
+  return Esum;
+};
+
+double GEMFlushPairs(GEMBatch& dens, double g, bool longOnly,
+                     vector<int>& used, vector<vector<double> >& X,
+                     vector<vector<double> >& Y, vector<vector<double> >& Z,
+                     vector<vector<double> >& pairMag)
+{
+  //Sums and clears lists of GEM function pairs stored by group pair
+  double Eij = 0; //Energy
+  for (unsigned int k=0;k<used.size();k++)
+  {
+    int key = used[k]; //Group pair
+    int ga = key/dens.Ngroups; //First group
+    int gb = key%dens.Ngroups; //Second group
+    double Egrp = GEMEwaldPairs((dens.groupX[ga]+dens.groupX[gb]),
+                                (dens.groupY[ga]+dens.groupY[gb]),
+                                (dens.groupZ[ga]+dens.groupZ[gb]),
+                                dens.alpha[dens.groupStart[ga]],
+                                dens.alpha[dens.groupStart[gb]],g,longOnly,
+                                pairMag[key].size(),&X[key][0],&Y[key][0],
+                                &Z[key][0],&pairMag[key][0]);
+    if (((dens.groupX[gb]+dens.groupY[gb]+dens.groupZ[gb])%2) == 1)
+    {
+      //Derivatives on the second center have the opposite sign
+      Egrp *= -1;
+    }
+    Eij += Egrp;
+    X[key].clear();
+    Y[key].clear();
+    Z[key].clear();
+    pairMag[key].clear();
+  }
+  used.clear();
+  return Eij;
+};
+
+double GEMGridCoulomb(GEMBatch& dens)
+{
+  //Calculates the periodic Coulomb energy of a packed GEM density with a
+  //particle mesh Ewald sum
+  //NB: Pairs of functions on the same atom are skipped, as in GEMCoulomb
+  int Nx,Ny,Nz; //Grid size
+  double g; //Splitting exponent
+  GEMGridSetup(Nx,Ny,Nz,g);
+  double LxB = Lx/bohrRad; //Box length (a.u.)
+  double LyB = Ly/bohrRad; //Box length (a.u.)
+  double LzB = Lz/bohrRad; //Box length (a.u.)
+  PBCBox boxB = pbcBox; //Periodic cell (a.u.)
+  boxB.scale(1/bohrRad);
+  double rc2 = pow(gemEwaldCut/bohrRad,2); //Squared cutoff (a.u.)
+  int Ng = dens.Ngroups; //Number of groups
+  //Long-range energy from the grid
+  vector<double> rho,phi; //Density and potential grids
+  GEMGridSpread(dens,g,Nx,Ny,Nz,rho);
+  GEMGridSolve(rho,Nx,Ny,Nz,phi);
+  double Egrid = 0; //Grid energy
+  int Npts = Nx*Ny*Nz; //Number of grid points
+  #pragma omp parallel for schedule(static) reduction(+:Egrid)
+  for (int i=0;i<Npts;i++)
+  {
+    Egrid += rho[i]*phi[i];
+  }
+  Egrid *= 0.5*LxB*LyB*LzB/Npts;
+  //Group of each function
+  vector<int> funcGroup(dens.Nfuncs);
+  for (int ga=0;ga<Ng;ga++)
+  {
+    for (int f=dens.groupStart[ga];f<dens.groupStart[ga+1];f++)
+    {
+      funcGroup[f] = ga;
+    }
+  }
+  //Functions of each atom
+  map<int,int> atomIDs; //Local ID of each atom
+  vector<int> atomStart(1,0); //First function of each atom
+  for (int f=0;f<dens.Nfuncs;f++)
+  {
+    if (atomIDs.count(dens.atom[f]) == 0)
+    {
+      atomIDs[dens.atom[f]] = atomStart.size()-1;
+      atomStart.push_back(0);
+    }
+    atomStart[atomIDs[dens.atom[f]]+1] += 1;
+  }
+  int Nat = atomStart.size()-1; //Number of atoms
+  for (int i=0;i<Nat;i++)
+  {
+    atomStart[i+1] += atomStart[i];
+  }
+  vector<int> atomFuncs(dens.Nfuncs); //Functions sorted by atom
+  vector<int> atomFill = atomStart; //Next free slot for each atom
+  for (int f=0;f<dens.Nfuncs;f++)
+  {
+    int at = atomIDs[dens.atom[f]]; //Local atom ID
+    atomFuncs[atomFill[at]] = f;
+    atomFill[at] += 1;
+  }
+  //Cells for the real-space sum
+  int Nc[3]; //Number of cells in each direction
+  vector<int> cellStart,cellFuncs; //Functions in each cell
+  GEMGridCells(dens,Nc,cellStart,cellFuncs);
+  int Ncells = Nc[0]*Nc[1]*Nc[2]; //Total number of cells
+  //Real-space corrections
+  double Eintra = 0; //Long-range energy of functions on the same atom
+  double Eshort = 0; //Short-range energy
+  #pragma omp parallel reduction(+:Eintra,Eshort)
+  {
+    vector<vector<double> > X(Ng*Ng),Y(Ng*Ng),Z(Ng*Ng); //Displacements
+    vector<vector<double> > pairMag(Ng*Ng); //Products of the coefficients
+    vector<int> used; //Group pairs with stored pairs
+    //Remove the long-range interactions within atoms
+    const int blockSize = 64; //Atoms per block
+    #pragma omp for schedule(dynamic)
+    for (int blk=0;blk<Nat;blk+=blockSize)
+    {
+      for (int at=blk;at<min(blk+blockSize,Nat);at++)
+      {
+        for (int p=atomStart[at];p<atomStart[at+1];p++)
+        {
+          for (int q=p;q<atomStart[at+1];q++)
+          {
+            int i = atomFuncs[p]; //First function
+            int j = atomFuncs[q]; //Second function
+            if (funcGroup[i] > funcGroup[j])
+            {
+              swap(i,j);
+            }
+            int key = funcGroup[i]*Ng+funcGroup[j]; //Group pair
+            if (pairMag[key].empty())
+            {
+              used.push_back(key);
+            }
+            X[key].push_back(dens.x[i]-dens.x[j]);
+            Y[key].push_back(dens.y[i]-dens.y[j]);
+            Z[key].push_back(dens.z[i]-dens.z[j]);
+            if (i == j)
+            {
+              //Self-interaction is counted once in the grid
+              pairMag[key].push_back(0.5*dens.mag[i]*dens.mag[j]);
+            }
+            else
+            {
+              pairMag[key].push_back(dens.mag[i]*dens.mag[j]);
+            }
+          }
+        }
+      }
+      Eintra += GEMFlushPairs(dens,g,1,used,X,Y,Z,pairMag);
+    }
+    //Short-range interactions between atoms
+    #pragma omp for schedule(dynamic)
+    for (int c=0;c<Ncells;c++)
+    {
+      int cx = c/(Nc[1]*Nc[2]); //Cell indices
+      int cy = (c/Nc[2])%Nc[1];
+      int cz = c%Nc[2];
+      int dMax[3]; //Range of neighboring cells
+      for (int d=0;d<3;d++)
+      {
+        dMax[d] = (Nc[d] > 1) ? 1 : 0;
+      }
+      for (int dx=-dMax[0];dx<=dMax[0];dx++)
+      {
+        for (int dy=-dMax[1];dy<=dMax[1];dy++)
+        {
+          for (int dz=-dMax[2];dz<=dMax[2];dz++)
+          {
+            int c2 = (((cx+dx+Nc[0])%Nc[0])*Nc[1]+((cy+dy+Nc[1])%Nc[1]))*
+                     Nc[2]+((cz+dz+Nc[2])%Nc[2]); //Neighboring cell
+            for (int p=cellStart[c];p<cellStart[c+1];p++)
+            {
+              for (int q=cellStart[c2];q<cellStart[c2+1];q++)
+              {
+                int i = cellFuncs[p]; //First function
+                int j = cellFuncs[q]; //Second function
+                if ((j <= i) or (dens.atom[i] == dens.atom[j]))
+                {
+                  //Skip intramolecular and double counted pairs
+                  continue;
+                }
+                if (funcGroup[i] > funcGroup[j])
+                {
+                  swap(i,j);
+                }
+                //Minimum image convention
+                double rx = dens.x[i]-dens.x[j];
+                double ry = dens.y[i]-dens.y[j];
+                double rz = dens.z[i]-dens.z[j];
+                boxB.minImage(rx,ry,rz);
+                if (((rx*rx)+(ry*ry)+(rz*rz)) > rc2)
+                {
+                  continue;
+                }
+                int key = funcGroup[i]*Ng+funcGroup[j]; //Group pair
+                if (pairMag[key].empty())
+                {
+                  used.push_back(key);
+                }
+                X[key].push_back(rx);
+                Y[key].push_back(ry);
+                Z[key].push_back(rz);
+                pairMag[key].push_back(dens.mag[i]*dens.mag[j]);
+              }
+            }
+          }
+        }
+      }
+      Eshort += GEMFlushPairs(dens,g,0,used,X,Y,Z,pairMag);
+    }
+  }
+  //Combine the terms, change units, and return
+  double Eij = (Egrid-Eintra+Eshort)*har2eV; //Energy
+  return Eij;
+};
+
+void GEMGridPotential(GEMBatch& dens, vector<double>& sites,
+                      vector<double>& pot)
+{
+  //Calculates the periodic electrostatic potential (eV/e) of a packed GEM
+  //density at sites packed as (x,y,z) in Angstroms with a particle mesh
+  //Ewald sum
+  int Nx,Ny,Nz; //Grid size
+  double g; //Splitting exponent
+  GEMGridSetup(Nx,Ny,Nz,g);
+  double LxB = Lx/bohrRad; //Box length (a.u.)
+  double LyB = Ly/bohrRad; //Box length (a.u.)
+  double LzB = Lz/bohrRad; //Box length (a.u.)
+  PBCBox boxB = pbcBox; //Periodic cell (a.u.)
+  boxB.scale(1/bohrRad);
+  double hx = LxB/Nx; //Grid spacing (a.u.)
+  double hy = LyB/Ny; //Grid spacing (a.u.)
+  double hz = LzB/Nz; //Grid spacing (a.u.)
+  double rc2 = pow(gemEwaldCut/bohrRad,2); //Squared cutoff (a.u.)
+  int Ng = dens.Ngroups; //Number of groups
+  int Nsites = sites.size()/3; //Number of sites
+  //Long-range potential on the grid
+  vector<double> rho,phi; //Density and potential grids
+  GEMGridSpread(dens,g,Nx,Ny,Nz,rho);
+  GEMGridSolve(rho,Nx,Ny,Nz,phi);
+  //Group of each function
+  vector<int> funcGroup(dens.Nfuncs);
+  for (int ga=0;ga<Ng;ga++)
+  {
+    for (int f=dens.groupStart[ga];f<dens.groupStart[ga+1];f++)
+    {
+      funcGroup[f] = ga;
+    }
+  }
+  //Cells for the real-space sum
+  int Nc[3]; //Number of cells in each direction
+  vector<int> cellStart,cellFuncs; //Functions in each cell
+  GEMGridCells(dens,Nc,cellStart,cellFuncs);
+  pot.assign(Nsites,0);
+  #pragma omp parallel
+  {
+    vector<vector<double> > X(Ng),Y(Ng),Z(Ng),pairMag(Ng); //Pair data
+    vector<int> used; //Groups with stored pairs
+    vector<double> fx,fy,fz; //One dimensional Gaussian factors
+    vector<int> ix,iy,iz; //Grid indices
+    double rs = sqrt(-1*log(gemScreen)/g); //Window radius
+    double norm = pow(g/pi,1.5)*hx*hy*hz; //Normalization and volume
+    #pragma omp for schedule(dynamic)
+    for (int s=0;s<Nsites;s++)
+    {
+      double pos[3]; //Site position (a.u.)
+      for (int d=0;d<3;d++)
+      {
+        pos[d] = sites[3*s+d]/bohrRad;
+      }
+      //Interpolate the long-range potential with a smoothed probe
+      int i0 = (int)ceil((pos[0]-rs)/hx);
+      int i1 = (int)floor((pos[0]+rs)/hx);
+      fx.clear();
+      ix.clear();
+      for (int i=i0;i<=i1;i++)
+      {
+        fx.push_back(HermGau1D(0,g,((i*hx)-pos[0])));
+        ix.push_back(((i%Nx)+Nx)%Nx);
+      }
+      i0 = (int)ceil((pos[1]-rs)/hy);
+      i1 = (int)floor((pos[1]+rs)/hy);
+      fy.clear();
+      iy.clear();
+      for (int i=i0;i<=i1;i++)
+      {
+        fy.push_back(HermGau1D(0,g,((i*hy)-pos[1])));
+        iy.push_back(((i%Ny)+Ny)%Ny);
+      }
+      i0 = (int)ceil((pos[2]-rs)/hz);
+      i1 = (int)floor((pos[2]+rs)/hz);
+      fz.clear();
+      iz.clear();
+      for (int i=i0;i<=i1;i++)
+      {
+        fz.push_back(HermGau1D(0,g,((i*hz)-pos[2])));
+        iz.push_back(((i%Nz)+Nz)%Nz);
+      }
+      double Vlong = 0; //Long-range potential
+      int Nwz = fz.size(); //Window size in z
+      for (unsigned int kx=0;kx<ix.size();kx++)
+      {
+        for (unsigned int ky=0;ky<iy.size();ky++)
+        {
+          double* row = &phi[(ix[kx]*Ny+iy[ky])*Nz]; //Line along z
+          double Vrow = 0; //Sum along the line
+          #pragma omp simd reduction(+:Vrow)
+          for (int kz=0;kz<Nwz;kz++)
+          {
+            Vrow += row[iz[kz]]*fz[kz];
+          }
+          Vlong += fx[kx]*fy[ky]*Vrow;
+        }
+      }
+      Vlong *= norm;
+      //Short-range potential from the neighboring cells
+      int cid[3]; //Cell indices
+      int dMax[3]; //Range of neighboring cells
+      double boxL[3] = {LxB,LyB,LzB}; //Box lengths
+      for (int d=0;d<3;d++)
+      {
+        double frac = pos[d]/boxL[d]; //Fractional coordinate
+        frac -= floor(frac);
+        cid[d] = min((int)(frac*Nc[d]),(Nc[d]-1));
+        dMax[d] = (Nc[d] > 1) ? 1 : 0;
+      }
+      for (int dx=-dMax[0];dx<=dMax[0];dx++)
+      {
+        for (int dy=-dMax[1];dy<=dMax[1];dy++)
+        {
+          for (int dz=-dMax[2];dz<=dMax[2];dz++)
+          {
+            int c2 = (((cid[0]+dx+Nc[0])%Nc[0])*Nc[1]+
+                     ((cid[1]+dy+Nc[1])%Nc[1]))*Nc[2]+
+                     ((cid[2]+dz+Nc[2])%Nc[2]); //Neighboring cell
+            for (int q=cellStart[c2];q<cellStart[c2+1];q++)
+            {
+              int f = cellFuncs[q]; //Function
+              //Minimum image convention
+              double rx = dens.x[f]-pos[0];
+              double ry = dens.y[f]-pos[1];
+              double rz = dens.z[f]-pos[2];
+              boxB.minImage(rx,ry,rz);
+              if (((rx*rx)+(ry*ry)+(rz*rz)) > rc2)
+              {
+                continue;
+              }
+              int ga = funcGroup[f]; //Group
+              if (pairMag[ga].empty())
+              {
+                used.push_back(ga);
+              }
+              X[ga].push_back(rx);
+              Y[ga].push_back(ry);
+              Z[ga].push_back(rz);
+              pairMag[ga].push_back(dens.mag[f]);
+            }
+          }
+        }
+      }
+      double Vshort = 0; //Short-range potential
+      for (unsigned int k=0;k<used.size();k++)
+      {
+        int ga = used[k]; //Group
+        Vshort += GEMEwaldPairs(dens.groupX[ga],dens.groupY[ga],
+                                dens.groupZ[ga],
+                                dens.alpha[dens.groupStart[ga]],0,g,0,
+                                pairMag[ga].size(),&X[ga][0],&Y[ga][0],
+                                &Z[ga][0],&pairMag[ga][0]);
+        X[ga].clear();
+        Y[ga].clear();
+        Z[ga].clear();
+        pairMag[ga].clear();
+      }
+      used.clear();
+      //Save the potential
+      pot[s] = (Vlong+Vshort)*har2eV;
+    }
+  }
+  return;
+};
+
+double GEMGridChargeCoulomb(GEMBatch& dens, vector<double>& charges)
+{
+  //Calculates the periodic Coulomb energy between a packed GEM density and
+  //point-charges packed as (x,y,z,q) in Angstroms with a particle mesh
+  //Ewald sum
+  int Nchrg = charges.size()/4; //Number of charges
+  vector<double> sites(3*Nchrg); //Charge positions
+  for (int j=0;j<Nchrg;j++)
+  {
+    sites[3*j] = charges[4*j];
+    sites[3*j+1] = charges[4*j+1];
+    sites[3*j+2] = charges[4*j+2];
+  }
+  vector<double> pot; //Potential at the charges
+  GEMGridPotential(dens,sites,pot);
+  double Eij = 0; //Energy
+  for (int j=0;j<Nchrg;j++)
+  {
+    Eij += charges[4*j+3]*pot[j];
+  }
+  return Eij;
+};
+
 //Functions to calculate GEM energy
+double GEMCoulombEnergy(vector<QMMMAtom>& QMMMData, int bead)
+{
+  //Calculates the Coulomb energy between the GEM densities of the MM atoms
+  vector<int> MMAtoms; //Atoms with GEM densities
+  for (int i=0;i<Natoms;i++)
+  {
+    if (QMMMData[i].MMRegion and (((int)QMMMData[i].GEM.size()) > bead))
+    {
+      MMAtoms.push_back(i);
+    }
+  }
+  GEMBatch dens; //Packed densities
+  PackGEMDensity(QMMMData,MMAtoms,bead,dens);
+  if (PBCon and ((2*gemEwaldCut) <= min(Lx,min(Ly,Lz))))
+  {
+    //Periodic systems use the particle mesh Ewald sum
+    return GEMGridCoulomb(dens);
+  }
+  return GEMCoulomb(dens,dens,1);
+};
 
+double GEMChargeEnergy(vector<QMMMAtom>& QMMMData, int bead)
+{
+  //Calculates the Coulomb energy between the GEM densities of the MM atoms
+  //and the QM and PB point-charges
+  vector<int> MMAtoms; //Atoms with GEM densities
+  vector<double> charges; //QM charges packed as (x,y,z,q)
+  for (int i=0;i<Natoms;i++)
+  {
+    if (QMMMData[i].MMRegion and (((int)QMMMData[i].GEM.size()) > bead))
+    {
+      MMAtoms.push_back(i);
+    }
+    if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+    {
+      charges.push_back(QMMMData[i].P[bead].x);
+      charges.push_back(QMMMData[i].P[bead].y);
+      charges.push_back(QMMMData[i].P[bead].z);
+      charges.push_back(QMMMData[i].MP[bead].q);
+    }
+  }
+  if (MMAtoms.empty() or charges.empty())
+  {
+    //Nothing to calculate
+    return 0;
+  }
+  GEMBatch dens; //Packed densities
+  PackGEMDensity(QMMMData,MMAtoms,bead,dens);
+  if (PBCon and ((2*gemEwaldCut) <= min(Lx,min(Ly,Lz))))
+  {
+    //Periodic systems use the particle mesh Ewald sum
+    return GEMGridChargeCoulomb(dens,charges);
+  }
+  return GEMChargeCoulomb(dens,charges);
+};
@@ -95,558 +95,400 @@ double HermGau::value(double xi, double yi, double zi)
   double Xij = (xi-x_)/bohrRad; //X distance (a.u.)
   double Yij = (yi-y_)/bohrRad; //Y distance (a.u.)
   double Zij = (zi-z_)/bohrRad; //Z distance (a.u.)
-  //Scale Xij,Yij,Zij by alpha
-  Xij *= alpha_*Xij; //Alpha*Xij^2
-  Yij *= alpha_*Yij; //Alpha*Yij^2
-  Zij *= alpha_*Zij; //Alpha*Zij^2
-  //Calculate the value of the basis function
-  int Ni,signCt;
-  double xVal = 0; //Value of the X component
-  Ni = ((int)floor(((double)powX_)/2)); //Loop length
-  signCt = 1; //Flips the sign during the loop
-  for (int i=0;i<Ni;i++)
+  //Combine values from x,y,z
+  val = mag_*HermGau1D(powX_,alpha_,Xij)*HermGau1D(powY_,alpha_,Yij);
+  val *= HermGau1D(powZ_,alpha_,Zij);
+  return val;
+};
+
+//Definitions for the BoysTable class
+BoysTable::BoysTable()
+{
+  //Tabulate the Boys function for the Taylor series
+  Npts = ((int)floor(boysMaxX/boysStep))+2;
+  Nord = boysMaxOrder+boysTaylor;
+  vals.resize(Npts*Nord);
+  for (int i=0;i<Npts;i++)
   {
-    //Calculate value for iteration i
-    double valTemp; //Temporary storage
-    valTemp = signCt*pow(2*Xij,powX_-(2*i));
-    valTemp /= LICHEMFactorial(i)*LICHEMFactorial(powX_-(2*i));
-    //Update sum and sign
-    xVal += valTemp;
-    signCt *= -1; //Change sign
+    //Calculate the highest order and recurse downwards
+    double x = i*boysStep; //Grid point
+    double expX = exp(-1*x); //Exponential term
+    vals[i*Nord+Nord-1] = BoysSeries(Nord-1,x);
+    for (int n=(Nord-1);n>0;n--)
+    {
+      vals[i*Nord+n-1] = ((2*x*vals[i*Nord+n])+expX)/(2*n-1);
+    }
   }
-  xVal *= exp(-1*Xij); //Add Gaussian
-  xVal *= LICHEMFactorial(powX_);
-  double yVal = 0; //Value of the Y component
-  Ni = ((int)floor(((double)powY_)/2)); //Loop length
-  signCt = 1; //Flips the sign during the loop
-  for (int i=0;i<Ni;i++)
+  return;
+};
+
+BoysTable::~BoysTable()
+{
+  //Generic destructor
+  return;
+};
+
+//Definitions for the GEMBatch class
+GEMBatch::GEMBatch()
+{
+  //Generic constructor
+  Nfuncs = 0;
+  Ngroups = 0;
+  return;
+};
+
+GEMBatch::~GEMBatch()
+{
+  //Generic destructor
+  return;
+};
+
+//Definitions for the GEMNeighborList class
+GEMNeighborList::GEMNeighborList()
+{
+  //Generic constructor
+  bead = -1; //Not built
+  Nsites = 0;
+  box[0] = 0;
+  box[1] = 0;
+  box[2] = 0;
+  Nbuilds = 0;
+  return;
+};
+
+GEMNeighborList::~GEMNeighborList()
+{
+  //Generic destructor
+  return;
+};
+
+//Functions for calculating Gaussian integrals
+double HermGau1D(int t, double alpha, double X)
+{
+  //One dimensional Hermite Gaussian, alpha^(t/2)*H_t(sqrt(alpha)*X)*
+  //exp(-alpha*X^2), which is the t-th derivative with respect to the center
+  double valA = exp(-1*alpha*X*X); //Order n
+  double valB = 0; //Order n-1
+  for (int n=0;n<t;n++)
   {
-    //Calculate value for iteration i
-    double valTemp; //Temporary storage
-    valTemp = signCt*pow(2*Yij,powY_-(2*i));
-    valTemp /= LICHEMFactorial(i)*LICHEMFactorial(powY_-(2*i));
-    //Update sum and sign
-    yVal += valTemp;
-    signCt *= -1; //Change sign
+    //Upward recursion
+    double valC = (2*alpha*X*valA)-(2*alpha*n*valB);
+    valB = valA;
+    valA = valC;
   }
-  yVal *= exp(-1*Yij); //Add Gaussian
-  yVal *= LICHEMFactorial(powY_);
-  double zVal = 0; //Value of the Z component
-  Ni = ((int)floor(((double)powZ_)/2)); //Loop length
-  signCt = 1; //Flips the sign during the loop
-  for (int i=0;i<Ni;i++)
+  return valA;
+};
+
+double HermMoment1D(int t, double alpha, int n, double X)
+{
+  //Integral of x^n over a one dimensional Hermite Gaussian of order t
+  //centered at X, where the order zero Gaussian is normalized to one
+  //NB: The derivatives with respect to the center are moved onto the
+  //moments of the normalized Gaussian, (k-1)!!/(2*alpha)^(k/2)
+  double val = 0; //Final value
+  double gauMom = 1; //Moment k of the normalized Gaussian
+  for (int k=0;k<=(n-t);k+=2)
   {
-    //Calculate value for iteration i
-    double valTemp; //Temporary storage
-    valTemp = signCt*pow(2*Zij,powZ_-(2*i));
-    valTemp /= LICHEMFactorial(i)*LICHEMFactorial(powZ_-(2*i));
-    //Update sum and sign
-    zVal += valTemp;
-    signCt *= -1; //Change sign
+    //Binomial term of the shifted moment, differentiated t times
+    int m = n-k-t; //Power of the center
+    double term = LICHEMFactorial(n)/(LICHEMFactorial(k)*LICHEMFactorial(m));
+    term *= pow(X,m)*gauMom;
+    val += term;
+    gauMom *= (k+1)/(2*alpha);
   }
-  zVal *= exp(-1*Zij); //Add Gaussian
-  zVal *= LICHEMFactorial(powZ_);
-  //Combine values from x,y,z
-  val = mag_*xVal*yVal*zVal;
   return val;
 };
 
-//Functions for calculating Gaussian integrals
-double BoysFunc(int n, double x)
+double BoysSeries(int n, double x)
 {
-  //Recursive Boys function
-  double val = 0.0;
-  if (n == 0)
+  //Boys function from the convergent power series
+  //NB: This is slow, but accurate for all orders and small arguments
+  double term = 1.0/(2*n+1); //Current term of the series
+  double val = term; //Sum of the series
+  int i = 0; //Term counter
+  while (term > (1e-17*val))
   {
-    //Zero order Boys function
-    val = sqrt(pi/(4*x))*erf(sqrt(x));
-    return val;
+    i += 1;
+    term *= 2*x/(2*n+2*i+1);
+    val += term;
   }
-  //Recursively calculate value
-  val = (((2*n-1)*BoysFunc(n-1,x))-exp(-1*x))/(2*x);
+  val *= exp(-1*x);
   return val;
 };
 
-double HermCoul2e(HermGau& Gi, HermGau& Gj)
+void BoysFuncAll(int nMax, double x, double* F)
 {
-  //Recursive two electron Coulomb integral
-  double Eij = 0; //Energy
-  //Combine Gaussians with the Gaussian product rule
-  double aNew = Gi.getAlpha()+Gj.getAlpha(); //New Gaussian coefficient
-  int powX = Gi.xPow()+Gj.xPow(); //New X power
-  int powY = Gi.yPow()+Gj.yPow(); //New Y power
-  int powZ = Gi.zPow()+Gj.zPow(); //New Z power
-  //Update magnitude based on the separation
-  double mu = Gi.getAlpha()*Gj.getAlpha()/aNew; //Smearing parameter
-  Coord posi,posj; //Temporary storage for positions
-  posi.x = Gi.xPos();
-  posi.y = Gi.yPos();
-  posi.z = Gi.zPos();
-  posj.x = Gj.xPos();
-  posj.y = Gj.yPos();
-  posj.z = Gj.zPos();
-  Coord disp = CoordDist2(posi,posj); //Calculate distances
-  double Xij = disp.x/bohrRad; //X distance (a.u.)
-  double Yij = disp.y/bohrRad; //Y distance (a.u.)
-  double Zij = disp.z/bohrRad; //Z distance (a.u.)
-  double Rij2 = Xij*Xij+Yij*Yij+Zij*Zij; //Distance between Gaussians (a.u.)
-  double newMag = Gi.coeff()*Gj.coeff(); //Product of old coefficients
-  newMag *= exp(-mu*Rij2); //Scale based on distance
-  //Create product Gaussian
-  HermGau Gij(newMag,aNew,powX,powY,powZ,Xij,Yij,Zij);
-  //Calculate integrals
-  double Ix = 0; //Integral in the x direction
-  if (Gij.xPow() > 0)
+  //Calculates the Boys function for all orders from 0 to nMax
+  double expX = exp(-1*x); //Exponential term
+  if (x > boysMaxX)
   {
-    //Aspherical Hermite Gaussians
-    vector<double> hermMags; //Magnitude of the Gaussians
-    vector<int> hermOrders; //Order of the Hermite function
-    vector<int> boysOrders; //Order of the Boys function
-    hermMags.push_back(1.0);
-    hermOrders.push_back(Gij.xPow());
-    boysOrders.push_back(0);
-    //Recursion
-    bool contRecurs = 1; //Keeps the while loop going
-    while (contRecurs)
+    //Upward recursion is stable for large arguments
+    F[0] = sqrt(pi/(4*x));
+    for (int n=1;n<=nMax;n++)
     {
-      //Stop recursion unless orders are greater than zero
-      contRecurs = 0;
-      //Create temporary arrays
-      vector<double> newMags; //New Gaussian magnitudes
-      vector<int> newOrders; //New Hermite orders
-      vector<int> newBoys; //New Boys function orders
-      //Loop over Hermite functions
-      for (unsigned int i=0;i<hermOrders.size();i++)
-      {
-        //Create new Hermites
-        if (hermOrders[i] > 0)
-        {
-          contRecurs = 1; //Continue recursion
-          double coeffi; //Temp. coefficient storage
-          //First Hermite
-          coeffi = hermOrders[i]-2;
-          coeffi *= hermMags[i];
-          if ((hermOrders[i]-2) >= 0)
-          {
-            newMags.push_back(coeffi);
-            newOrders.push_back(hermOrders[i]-2);
-            newBoys.push_back(boysOrders[i]+1);
-          }
-          //Second Hermite
-          coeffi = Gij.xPos();
-          coeffi *= hermMags[i];
-          if ((hermOrders[i]-1) >= 0)
-          {
-            newMags.push_back(coeffi);
-            newOrders.push_back(hermOrders[i]-1);
-            newBoys.push_back(boysOrders[i]+1);
-          }
-        }
-      }
-      //Save new magnitudes and orders
-      hermMags = newMags;
-      hermOrders = newOrders;
-      boysOrders = newBoys;
-    }
-    //Calculate X integral
-    for (unsigned int i=0;i<boysOrders.size();i++)
-    {
-      double Itmp; //Temp. storage for integrals
-      Itmp = pow((-1*Gij.getAlpha()),boysOrders[i]);
-      Itmp *= BoysFunc(boysOrders[i],(Gij.getAlpha()*Rij2));
-      Ix += Itmp; //Update integral
+      F[n] = (((2*n-1)*F[n-1])-expX)/(2*x);
     }
+    return;
   }
-  else
+  //Find the highest order
+  if (nMax > boysMaxOrder)
   {
-    //Spherical Hermite Gaussian
-    double Itmp; //Temp. storage for integrals
-    Itmp = pow((-1*Gij.getAlpha()),0);
-    Itmp *= BoysFunc(0,(Gij.getAlpha()*Rij2));
-    Ix += Itmp; //Update integral
+    //Order is not on the grid
+    F[nMax] = BoysSeries(nMax,x);
   }
-  double Iy = 0; //Integral in the y direction
-  if (Gij.yPow() > 0)
+  else
   {
-    //Aspherical Hermite Gaussians
-    vector<double> hermMags; //Magnitude of the Gaussians
-    vector<int> hermOrders; //Order of the Hermite function
-    vector<int> boysOrders; //Order of the Boys function
-    hermMags.push_back(1.0);
-    hermOrders.push_back(Gij.yPow());
-    boysOrders.push_back(0);
-    //Recursion
-    bool contRecurs = 1; //Keeps the while loop going
-    while (contRecurs)
-    {
-      //Stop recursion unless orders are greater than zero
-      contRecurs = 0;
-      //Create temporary arrays
-      vector<double> newMags; //New Gaussian magnitudes
-      vector<int> newOrders; //New Hermite orders
-      vector<int> newBoys; //New Boys function orders
-      //Loop over Hermite functions
-      for (unsigned int i=0;i<hermOrders.size();i++)
-      {
-        //Create new Hermites
-        if (hermOrders[i] > 0)
-        {
-          contRecurs = 1; //Continue recursion
-          double coeffi; //Temp. coefficient storage
-          //First Hermite
-          coeffi = hermOrders[i]-2;
-          coeffi *= hermMags[i];
-          if ((hermOrders[i]-2) >= 0)
-          {
-            newMags.push_back(coeffi);
-            newOrders.push_back(hermOrders[i]-2);
-            newBoys.push_back(boysOrders[i]+1);
-          }
-          //Second Hermite
-          coeffi = Gij.yPos();
-          coeffi *= hermMags[i];
-          if ((hermOrders[i]-1) >= 0)
-          {
-            newMags.push_back(coeffi);
-            newOrders.push_back(hermOrders[i]-1);
-            newBoys.push_back(boysOrders[i]+1);
-          }
-        }
-      }
-      //Save new magnitudes and orders
-      hermMags = newMags;
-      hermOrders = newOrders;
-      boysOrders = newBoys;
-    }
-    //Calculate Y integral
-    for (unsigned int i=0;i<boysOrders.size();i++)
+    //Taylor series from the nearest grid point
+    int pt = (int)((x/boysStep)+0.5); //Nearest grid point
+    double dx = (pt*boysStep)-x; //Negative displacement from the point
+    double* tab = &boysTab.vals[pt*boysTab.Nord+nMax];
+    double val = tab[boysTaylor-1];
+    for (int k=(boysTaylor-1);k>0;k--)
     {
-      double Itmp; //Temp. storage for integrals
-      Itmp = pow((-1*Gij.getAlpha()),boysOrders[i]);
-      Itmp *= BoysFunc(boysOrders[i],(Gij.getAlpha()*Rij2));
-      Iy += Itmp; //Update integral
+      val = tab[k-1]+(dx*val/k);
     }
+    F[nMax] = val;
   }
-  else
+  //Downward recursion is stable for small arguments
+  for (int n=nMax;n>0;n--)
   {
-    //Spherical Hermite Gaussian
-    double Itmp; //Temp. storage for integrals
-    Itmp = pow((-1*Gij.getAlpha()),0);
-    Itmp *= BoysFunc(0,(Gij.getAlpha()*Rij2));
-    Iy += Itmp; //Update integral
+    F[n-1] = ((2*x*F[n])+expX)/(2*n-1);
+  }
+  return;
+};
+
+void BoysFuncBatch(int n, int Nx, double* x, double* F)
+{
+  //Calculates the order n Boys function for an array of arguments
+  if (n > boysMaxOrder)
+  {
+    //Order is not on the grid
+    vector<double> allF(n+1); //Values for all orders
+    for (int i=0;i<Nx;i++)
+    {
+      BoysFuncAll(n,x[i],&allF[0]);
+      F[i] = allF[n];
+    }
+    return;
   }
-  double Iz = 0; //Integral in the z direction
-  if (Gij.zPow() > 0)
+  const double* tab = &boysTab.vals[n]; //Table for order n
+  const int Nord = boysTab.Nord; //Stride between grid points
+  #pragma omp simd
+  for (int i=0;i<Nx;i++)
   {
-    //Aspherical Hermite Gaussians
-    vector<double> hermMags; //Magnitude of the Gaussians
-    vector<int> hermOrders; //Order of the Hermite function
-    vector<int> boysOrders; //Order of the Boys function
-    hermMags.push_back(1.0);
-    hermOrders.push_back(Gij.zPow());
-    boysOrders.push_back(0);
-    //Recursion
-    bool contRecurs = 1; //Keeps the while loop going
-    while (contRecurs)
+    double xi = x[i];
+    double val;
+    if (xi > boysMaxX)
     {
-      //Stop recursion unless orders are greater than zero
-      contRecurs = 0;
-      //Create temporary arrays
-      vector<double> newMags; //New Gaussian magnitudes
-      vector<int> newOrders; //New Hermite orders
-      vector<int> newBoys; //New Boys function orders
-      //Loop over Hermite functions
-      for (unsigned int i=0;i<hermOrders.size();i++)
+      //Upward recursion
+      double expX = exp(-1*xi); //Exponential term
+      val = sqrt(pi/(4*xi));
+      for (int k=1;k<=n;k++)
       {
-        //Create new Hermites
-        if (hermOrders[i] > 0)
-        {
-          contRecurs = 1; //Continue recursion
-          double coeffi; //Temp. coefficient storage
-          //First Hermite
-          coeffi = hermOrders[i]-2;
-          coeffi *= hermMags[i];
-          if ((hermOrders[i]-2) >= 0)
-          {
-            newMags.push_back(coeffi);
-            newOrders.push_back(hermOrders[i]-2);
-            newBoys.push_back(boysOrders[i]+1);
-          }
-          //Second Hermite
-          coeffi = Gij.zPos();
-          coeffi *= hermMags[i];
-          if ((hermOrders[i]-1) >= 0)
-          {
-            newMags.push_back(coeffi);
-            newOrders.push_back(hermOrders[i]-1);
-            newBoys.push_back(boysOrders[i]+1);
-          }
-        }
+        val = (((2*k-1)*val)-expX)/(2*xi);
       }
-      //Save new magnitudes and orders
-      hermMags = newMags;
-      hermOrders = newOrders;
-      boysOrders = newBoys;
     }
-    //Calculate Z integral
-    for (unsigned int i=0;i<boysOrders.size();i++)
+    else
     {
-      double Itmp; //Temp. storage for integrals
-      Itmp = pow((-1*Gij.getAlpha()),boysOrders[i]);
-      Itmp *= BoysFunc(boysOrders[i],(Gij.getAlpha()*Rij2));
-      Iz += Itmp; //Update integral
+      //Taylor series from the nearest grid point
+      int pt = (int)((xi/boysStep)+0.5); //Nearest grid point
+      double dx = (pt*boysStep)-xi; //Negative displacement
+      val = tab[pt*Nord+boysTaylor-1];
+      for (int k=(boysTaylor-1);k>0;k--)
+      {
+        val = tab[pt*Nord+k-1]+(dx*val/k);
+      }
     }
+    F[i] = val;
   }
-  else
-  {
-    //Spherical Hermite Gaussian
-    double Itmp; //Temp. storage for integrals
-    Itmp = pow((-1*Gij.getAlpha()),0);
-    Itmp *= BoysFunc(0,(Gij.getAlpha()*Rij2));
-    Iz += Itmp; //Update integral
-  }
-  //Combine integrals
-  Eij = Ix*Iy*Iz; //Combine the integrals
-  Eij *= Gij.coeff(); //Scale by magnitude
-  //Change units and return
-  Eij *= har2eV;
-  return Eij;
+  return;
 };
 
-double HermCoul1e(HermGau& Gi, double qj, Coord& Posj)
+double BoysFunc(int n, double x)
 {
-  //Recursive one electron Coulomb integral
-  double Eij = 0; //Energy
-  //Create a temporary Gaussian
-  double newMag = Gi.coeff(); //Magnitude
-  double aNew = Gi.getAlpha(); //Gaussian coefficient
-  int powX = Gi.xPow(); //X power
-  int powY = Gi.yPow(); //Y power
-  int powZ = Gi.zPow(); //Z power
-  Coord posi; //Temporary storage for positions
-  posi.x = Gi.xPos();
-  posi.y = Gi.yPos();
-  posi.z = Gi.zPos();
-  Coord disp = CoordDist2(posi,Posj); //Calculate distances
-  double Xij = disp.x/bohrRad; //X distance (a.u.)
-  double Yij = disp.y/bohrRad; //Y distance (a.u.)
-  double Zij = disp.z/bohrRad; //Z distance (a.u.)
-  double Rij2 = Xij*Xij+Yij*Yij+Zij*Zij; //Distance between Gaussians (a.u.)
-  HermGau Gij(newMag,aNew,powX,powY,powZ,Xij,Yij,Zij);
-  //Calculate integrals
-  double Ix = 0; //Integral in the x direction
-  if (Gij.xPow() > 0)
+  //Boys function of order n
+  double val = 0.0;
+  BoysFuncBatch(n,1,&x,&val);
+  return val;
+};
+
+template<int maxL>
+void HermiteRTable(double alpha, double X, double Y, double Z, double* R)
+{
+  //McMurchie-Davidson Hermite Coulomb integrals R_tuv for t+u+v <= maxL
+  //NB: The results are saved as R[(t*NL+u)*NL+v] with NL = hermMaxL+1
+  const int NL = hermMaxL+1; //Stride of the results
+  double Rn[maxL+1][maxL+1][maxL+1][maxL+1]; //Auxiliary integrals R^n_tuv
+  double F[maxL+1]; //Boys function values
+  BoysFuncAll(maxL,(alpha*(X*X+Y*Y+Z*Z)),F);
+  //Initialize the auxiliary integrals
+  double scale = 1; //(-2*alpha)^n
+  for (int n=0;n<=maxL;n++)
   {
-    //Aspherical Hermite Gaussians
-    vector<double> hermMags; //Magnitude of the Gaussians
-    vector<int> hermOrders; //Order of the Hermite function
-    vector<int> boysOrders; //Order of the Boys function
-    hermMags.push_back(1.0);
-    hermOrders.push_back(Gij.xPow());
-    boysOrders.push_back(0);
-    //Recursion
-    bool contRecurs = 1; //Keeps the while loop going
-    while (contRecurs)
+    Rn[n][0][0][0] = scale*F[n];
+    scale *= -2*alpha;
+  }
+  //Downward recursion in n
+  //NB: The loops are split so that each one only recurses in one direction
+  for (int n=(maxL-1);n>=0;n--)
+  {
+    const int L = maxL-n; //Largest total order at this level
+    //Recursion in z
+    Rn[n][0][0][1] = Z*Rn[n+1][0][0][0];
+    for (int v=2;v<=L;v++)
     {
-      //Stop recursion unless orders are greater than zero
-      contRecurs = 0;
-      //Create temporary arrays
-      vector<double> newMags; //New Gaussian magnitudes
-      vector<int> newOrders; //New Hermite orders
-      vector<int> newBoys; //New Boys function orders
-      //Loop over Hermite functions
-      for (unsigned int i=0;i<hermOrders.size();i++)
-      {
-        //Create new Hermites
-        if (hermOrders[i] > 0)
-        {
-          contRecurs = 1; //Continue recursion
-          double coeffi; //Temp. coefficient storage
-          //First Hermite
-          coeffi = hermOrders[i]-2;
-          coeffi *= hermMags[i];
-          if ((hermOrders[i]-2) >= 0)
-          {
-            newMags.push_back(coeffi);
-            newOrders.push_back(hermOrders[i]-2);
-            newBoys.push_back(boysOrders[i]+1);
-          }
-          //Second Hermite
-          coeffi = Gij.xPos();
-          coeffi *= hermMags[i];
-          if ((hermOrders[i]-1) >= 0)
-          {
-            newMags.push_back(coeffi);
-            newOrders.push_back(hermOrders[i]-1);
-            newBoys.push_back(boysOrders[i]+1);
-          }
-        }
-      }
-      //Save new magnitudes and orders
-      hermMags = newMags;
-      hermOrders = newOrders;
-      boysOrders = newBoys;
+      Rn[n][0][0][v] = Z*Rn[n+1][0][0][v-1]+(v-1)*Rn[n+1][0][0][v-2];
     }
-    //Calculate X integral
-    for (unsigned int i=0;i<boysOrders.size();i++)
+    //Recursion in y
+    for (int v=0;v<L;v++)
     {
-      double Itmp; //Temp. storage for integrals
-      Itmp = pow((-1*Gij.getAlpha()),boysOrders[i]);
-      Itmp *= BoysFunc(boysOrders[i],(Gij.getAlpha()*Rij2));
-      Ix += Itmp; //Update integral
+      Rn[n][0][1][v] = Y*Rn[n+1][0][0][v];
     }
-  }
-  else
-  {
-    //Spherical Hermite Gaussian
-    double Itmp; //Temp. storage for integrals
-    Itmp = pow((-1*Gij.getAlpha()),0);
-    Itmp *= BoysFunc(0,(Gij.getAlpha()*Rij2));
-    Ix += Itmp; //Update integral
-  }
-  double Iy = 0; //Integral in the y direction
-  if (Gij.yPow() > 0)
-  {
-    //Aspherical Hermite Gaussians
-    vector<double> hermMags; //Magnitude of the Gaussians
-    vector<int> hermOrders; //Order of the Hermite function
-    vector<int> boysOrders; //Order of the Boys function
-    hermMags.push_back(1.0);
-    hermOrders.push_back(Gij.yPow());
-    boysOrders.push_back(0);
-    //Recursion
-    bool contRecurs = 1; //Keeps the while loop going
-    while (contRecurs)
+    for (int u=2;u<=L;u++)
     {
-      //Stop recursion unless orders are greater than zero
-      contRecurs = 0;
-      //Create temporary arrays
-      vector<double> newMags; //New Gaussian magnitudes
-      vector<int> newOrders; //New Hermite orders
-      vector<int> newBoys; //New Boys function orders
-      //Loop over Hermite functions
-      for (unsigned int i=0;i<hermOrders.size();i++)
+      for (int v=0;v<=(L-u);v++)
       {
-        //Create new Hermites
-        if (hermOrders[i] > 0)
-        {
-          contRecurs = 1; //Continue recursion
-          double coeffi; //Temp. coefficient storage
-          //First Hermite
-          coeffi = hermOrders[i]-2;
-          coeffi *= hermMags[i];
-          if ((hermOrders[i]-2) >= 0)
-          {
-            newMags.push_back(coeffi);
-            newOrders.push_back(hermOrders[i]-2);
-            newBoys.push_back(boysOrders[i]+1);
-          }
-          //Second Hermite
-          coeffi = Gij.yPos();
-          coeffi *= hermMags[i];
-          if ((hermOrders[i]-1) >= 0)
-          {
-            newMags.push_back(coeffi);
-            newOrders.push_back(hermOrders[i]-1);
-            newBoys.push_back(boysOrders[i]+1);
-          }
-        }
+        Rn[n][0][u][v] = Y*Rn[n+1][0][u-1][v]+(u-1)*Rn[n+1][0][u-2][v];
       }
-      //Save new magnitudes and orders
-      hermMags = newMags;
-      hermOrders = newOrders;
-      boysOrders = newBoys;
     }
-    //Calculate Y integral
-    for (unsigned int i=0;i<boysOrders.size();i++)
+    //Recursion in x
+    for (int u=0;u<L;u++)
     {
-      double Itmp; //Temp. storage for integrals
-      Itmp = pow((-1*Gij.getAlpha()),boysOrders[i]);
-      Itmp *= BoysFunc(boysOrders[i],(Gij.getAlpha()*Rij2));
-      Iy += Itmp; //Update integral
+      for (int v=0;v<(L-u);v++)
+      {
+        Rn[n][1][u][v] = X*Rn[n+1][0][u][v];
+      }
     }
-  }
-  else
-  {
-    //Spherical Hermite Gaussian
-    double Itmp; //Temp. storage for integrals
-    Itmp = pow((-1*Gij.getAlpha()),0);
-    Itmp *= BoysFunc(0,(Gij.getAlpha()*Rij2));
-    Iy += Itmp; //Update integral
-  }
-  double Iz = 0; //Integral in the z direction
-  if (Gij.zPow() > 0)
-  {
-    //Aspherical Hermite Gaussians
-    vector<double> hermMags; //Magnitude of the Gaussians
-    vector<int> hermOrders; //Order of the Hermite function
-    vector<int> boysOrders; //Order of the Boys function
-    hermMags.push_back(1.0);
-    hermOrders.push_back(Gij.zPow());
-    boysOrders.push_back(0);
-    //Recursion
-    bool contRecurs = 1; //Keeps the while loop going
-    while (contRecurs)
+    for (int t=2;t<=L;t++)
     {
-      //Stop recursion unless orders are greater than zero
-      contRecurs = 0;
-      //Create temporary arrays
-      vector<double> newMags; //New Gaussian magnitudes
-      vector<int> newOrders; //New Hermite orders
-      vector<int> newBoys; //New Boys function orders
-      //Loop over Hermite functions
-      for (unsigned int i=0;i<hermOrders.size();i++)
+      for (int u=0;u<=(L-t);u++)
       {
-        //Create new Hermites
-        if (hermOrders[i] > 0)
+        for (int v=0;v<=(L-t-u);v++)
         {
-          contRecurs = 1; //Continue recursion
-          double coeffi; //Temp. coefficient storage
-          //First Hermite
-          coeffi = hermOrders[i]-2;
-          coeffi *= hermMags[i];
-          if ((hermOrders[i]-2) >= 0)
-          {
-            newMags.push_back(coeffi);
-            newOrders.push_back(hermOrders[i]-2);
-            newBoys.push_back(boysOrders[i]+1);
-          }
-          //Second Hermite
-          coeffi = Gij.zPos();
-          coeffi *= hermMags[i];
-          if ((hermOrders[i]-1) >= 0)
-          {
-            newMags.push_back(coeffi);
-            newOrders.push_back(hermOrders[i]-1);
-            newBoys.push_back(boysOrders[i]+1);
-          }
+          Rn[n][t][u][v] = X*Rn[n+1][t-1][u][v]+(t-1)*Rn[n+1][t-2][u][v];
         }
       }
-      //Save new magnitudes and orders
-      hermMags = newMags;
-      hermOrders = newOrders;
-      boysOrders = newBoys;
     }
-    //Calculate Z integral
-    for (unsigned int i=0;i<boysOrders.size();i++)
+  }
+  //Save the results
+  for (int t=0;t<=maxL;t++)
+  {
+    for (int u=0;u<=(maxL-t);u++)
     {
-      double Itmp; //Temp. storage for integrals
-      Itmp = pow((-1*Gij.getAlpha()),boysOrders[i]);
-      Itmp *= BoysFunc(boysOrders[i],(Gij.getAlpha()*Rij2));
-      Iz += Itmp; //Update integral
+      for (int v=0;v<=(maxL-t-u);v++)
+      {
+        R[(t*NL+u)*NL+v] = Rn[0][t][u][v];
+      }
     }
   }
-  else
+  return;
+};
+
+void HermiteRTable(int L, double alpha, double X, double Y, double Z,
+                   double* R)
+{
+  //Picks the R_tuv table for the total Hermite order
+  switch (L)
   {
-    //Spherical Hermite Gaussian
-    double Itmp; //Temp. storage for integrals
-    Itmp = pow((-1*Gij.getAlpha()),0);
-    Itmp *= BoysFunc(0,(Gij.getAlpha()*Rij2));
-    Iz += Itmp; //Update integral
+    case 0:
+      HermiteRTable<0>(alpha,X,Y,Z,R);
+      break;
+    case 1:
+      HermiteRTable<1>(alpha,X,Y,Z,R);
+      break;
+    case 2:
+      HermiteRTable<2>(alpha,X,Y,Z,R);
+      break;
+    case 3:
+      HermiteRTable<3>(alpha,X,Y,Z,R);
+      break;
+    case 4:
+      HermiteRTable<4>(alpha,X,Y,Z,R);
+      break;
+    case 5:
+      HermiteRTable<5>(alpha,X,Y,Z,R);
+      break;
+    case 6:
+      HermiteRTable<6>(alpha,X,Y,Z,R);
+      break;
+    case 7:
+      HermiteRTable<7>(alpha,X,Y,Z,R);
+      break;
+    case 8:
+      HermiteRTable<8>(alpha,X,Y,Z,R);
+      break;
+    default:
+      //Order is too large
+      cerr << "Error: Hermite Gaussian order " << L;
+      cerr << " is larger than the maximum (" << hermMaxL << ")!!!";
+      cerr << '\n' << '\n';
+      cerr.flush();
+      exit(0);
   }
-  //Combine integrals
-  Eij = Ix*Iy*Iz; //Combine the integrals
-  Eij *= Gij.coeff()*qj; //Scale by magnitude
+  return;
+};
+
+double HermCoul2e(HermGau& Gi, HermGau& Gj)
+{
+  //Two electron Coulomb integral between Hermite Gaussians
+  const int NL = hermMaxL+1; //Stride of the R_tuv table
+  double R[NL*NL*NL]; //Hermite Coulomb integrals
+  //Find the distance between the Gaussians
+  Coord posi,posj; //Temporary storage for positions
+  posi.x = Gi.xPos();
+  posi.y = Gi.yPos();
+  posi.z = Gi.zPos();
+  posj.x = Gj.xPos();
+  posj.y = Gj.yPos();
+  posj.z = Gj.zPos();
+  Coord disp = CoordDist2(posi,posj); //Calculate distances
+  double Xij = disp.x/bohrRad; //X distance (a.u.)
+  double Yij = disp.y/bohrRad; //Y distance (a.u.)
+  double Zij = disp.z/bohrRad; //Z distance (a.u.)
+  //Calculate the integrals
+  double ai = Gi.getAlpha(); //Exponent of Gaussian i
+  double aj = Gj.getAlpha(); //Exponent of Gaussian j
+  double mu = ai*aj/(ai+aj); //Reduced exponent
+  int powX = Gi.xPow()+Gj.xPow(); //Combined X order
+  int powY = Gi.yPow()+Gj.yPow(); //Combined Y order
+  int powZ = Gi.zPow()+Gj.zPow(); //Combined Z order
+  HermiteRTable((powX+powY+powZ),mu,Xij,Yij,Zij,R);
+  double Eij = R[(powX*NL+powY)*NL+powZ];
+  if (((Gj.xPow()+Gj.yPow()+Gj.zPow())%2) == 1)
+  {
+    //Derivatives on the second center have the opposite sign
+    Eij *= -1;
+  }
+  Eij *= 2*pow(pi,2.5)/(ai*aj*sqrt(ai+aj));
+  Eij *= Gi.coeff()*Gj.coeff(); //Scale by magnitude
+  //Change units and return
+  Eij *= har2eV;
+  return Eij;
+};
+
+double HermCoul1e(HermGau& Gi, double qj, Coord& Posj)
+{
+  //One electron Coulomb integral between a Hermite Gaussian and a charge
+  const int NL = hermMaxL+1; //Stride of the R_tuv table
+  double R[NL*NL*NL]; //Hermite Coulomb integrals
+  //Find the distance between the Gaussian and the charge
+  Coord posi; //Temporary storage for positions
+  posi.x = Gi.xPos();
+  posi.y = Gi.yPos();
+  posi.z = Gi.zPos();
+  Coord disp = CoordDist2(posi,Posj); //Calculate distances
+  double Xij = disp.x/bohrRad; //X distance (a.u.)
+  double Yij = disp.y/bohrRad; //Y distance (a.u.)
+  double Zij = disp.z/bohrRad; //Z distance (a.u.)
+  //Calculate the integral
+  double ai = Gi.getAlpha(); //Exponent of the Gaussian
+  int powX = Gi.xPow(); //X order
+  int powY = Gi.yPow(); //Y order
+  int powZ = Gi.zPow(); //Z order
+  HermiteRTable((powX+powY+powZ),ai,Xij,Yij,Zij,R);
+  double Eij = R[(powX*NL+powY)*NL+powZ];
+  Eij *= 2*pi/ai;
+  Eij *= Gi.coeff()*qj; //Scale by magnitude
   //Change units and return
   Eij *= har2eV;
   return Eij;
@@ -89,6 +89,11 @@ void ReadArgs(int& argc, char**& argv, fstream& xyzFile,
     //Separate a reaction path frame into a trajectory file
     SplitPathTraj(argc,argv);
   }
+  if (dummy == "-GEMcheck")
+  {
+    //Compare the cached GEM multipoles with direct integrals
+    CheckGEMPoles(argc,argv);
+  }
   if ((argc % 2) != 1)
   {
     //Check for help or missing arguments
@@ -260,6 +265,7 @@ void ReadLICHEMInput(fstream& xyzFile, fstream& connectFile,
       //Set ID and regions
       tmp.id = i;
       tmp.NEBActive = 1;
+      tmp.hessActive = 1;
       tmp.QMRegion = 0;
       tmp.MMRegion = 1;
       tmp.PBRegion = 0;
@@ -310,6 +316,8 @@ void ReadLICHEMInput(fstream& xyzFile, fstream& connectFile,
       QMMMData[i].bonds.push_back(atomID); //Add bond
     }
   }
+  //Build the 1-2, 1-3, and 1-4 neighbor lists
+  BuildTopology(QMMMData);
   //Read simulation keywords
   while (regionFile.good() and (!regionFile.eof()))
   {
@@ -332,6 +340,16 @@ void ReadLICHEMInput(fstream& xyzFile, fstream& connectFile,
       //Read the number of replica beads
       regionFile >> QMMMOpts.NBeads;
     }
+    else if (keyword == "bfgs_history:")
+    {
+      //Read the number of stored L-BFGS updates
+      regionFile >> QMMMOpts.BFGSHist;
+    }
+    else if (keyword == "box_angles:")
+    {
+      //Read the box angles for triclinic cells
+      regionFile >> boxAlpha >> boxBeta >> boxGamma;
+    }
     else if (keyword == "box_size:")
     {
       //Read the box size
@@ -365,19 +383,20 @@ void ReadLICHEMInput(fstream& xyzFile, fstream& connectFile,
         //Optimize with the LICHEM steepest descent method
         SteepSim = 1;
       }
-      if ((dummy == "dfp") or (dummy == "bfgs"))
+      if (dummy == "dfp")
       {
         //Optimize with the DFP optimizer
         DFPSim = 1;
-        if (dummy == "bfgs")
-        {
-          //Print BFGS error
-          cerr << "Warning: A BFGS optimizer is not implemented.";
-          cerr << '\n';
-          cerr << " The DFP algorithm will be used instead of BFGS.";
-          cerr << '\n' << '\n';
-          cerr.flush(); //Print error immediately
-        }
+      }
+      if ((dummy == "bfgs") or (dummy == "lbfgs") or (dummy == "l-bfgs"))
+      {
+        //Optimize with the limited-memory BFGS optimizer
+        BFGSSim = 1;
+      }
+      if ((dummy == "ric") or (dummy == "internal"))
+      {
+        //Optimize in redundant internal coordinates
+        RICSim = 1;
       }
       //Reaction pathways
       if ((dummy == "neb") or (dummy == "ci-neb") or (dummy == "cineb"))
@@ -385,6 +404,11 @@ void ReadLICHEMInput(fstream& xyzFile, fstream& connectFile,
         //Optimize a path with climbing image NEB
         NEBSim = 1;
       }
+      if ((dummy == "string") or (dummy == "gsm") or (dummy == "sm"))
+      {
+        //Optimize a path with the growing string method
+        StringSim = 1;
+      }
       //Ensemble sampling
       if (dummy == "pimc")
       {
@@ -397,6 +421,35 @@ void ReadLICHEMInput(fstream& xyzFile, fstream& connectFile,
         FBNEBSim = 1;
       }
     }
+    else if (keyword == "conv_cutoff:")
+    {
+      //Read the cutoff for the neighbor RMS deviation metric
+      regionFile >> QMMMOpts.convCut;
+    }
+    else if (keyword == "conv_metric:")
+    {
+      //Read the type of RMS deviation used in the convergence tests
+      regionFile >> dummy;
+      LICHEMLowerText(dummy);
+      if ((dummy == "matrix") or (dummy == "distance_matrix"))
+      {
+        QMMMOpts.convMetric = "Matrix";
+      }
+      else if ((dummy == "neighbor") or (dummy == "neighbour") or
+              (dummy == "cutoff"))
+      {
+        QMMMOpts.convMetric = "Neighbor";
+      }
+      else if ((dummy == "kabsch") or (dummy == "rmsd"))
+      {
+        QMMMOpts.convMetric = "Kabsch";
+      }
+      else
+      {
+        //Save the unknown value for the error checker
+        QMMMOpts.convMetric = dummy;
+      }
+    }
     else if (keyword == "electrostatics:")
     {
       //Check the type of force field
@@ -428,6 +481,11 @@ void ReadLICHEMInput(fstream& xyzFile, fstream& connectFile,
         }
       }
     }
+    else if (keyword == "embed_tolerance:")
+    {
+      //Read the potential tolerance for compressing distant multipoles
+      regionFile >> QMMMOpts.embedTol;
+    }
     else if (keyword == "ensemble:")
     {
       //Set the thermodynamic ensemble
@@ -449,6 +507,26 @@ void ReadLICHEMInput(fstream& xyzFile, fstream& connectFile,
       //Read the number of equilibration steps
       regionFile >> QMMMOpts.NEq;
     }
+    else if (keyword == "fd_hessian:")
+    {
+      //Calculate Hessians from finite differences of the forces
+      regionFile >> dummy;
+      LICHEMLowerText(dummy);
+      if ((dummy == "yes") or (dummy == "true"))
+      {
+        QMMMOpts.FDHess = 1;
+      }
+    }
+    else if (keyword == "fd_jobs:")
+    {
+      //Read the number of concurrent finite-difference gradients
+      regionFile >> QMMMOpts.FDJobs;
+    }
+    else if (keyword == "fd_stepsize:")
+    {
+      //Read the finite-difference displacement
+      regionFile >> QMMMOpts.FDStep;
+    }
     else if (keyword == "frozen_ends:")
     {
       //Check for inactive NEB end-points
@@ -459,6 +537,65 @@ void ReadLICHEMInput(fstream& xyzFile, fstream& connectFile,
         QMMMOpts.frznEnds = 1;
       }
     }
+    else if (keyword == "gem_basis:")
+    {
+      //Set the Hermite basis set for GEM densities
+      regionFile >> QMMMOpts.GEMBasis;
+    }
+    else if (keyword == "gem_basis_file:")
+    {
+      //Set the data file with the Hermite basis sets
+      regionFile >> QMMMOpts.GEMBasisFile;
+    }
+    else if (keyword == "gem_cube:")
+    {
+      //Write the GEM density to a cube file
+      regionFile >> dummy;
+      LICHEMLowerText(dummy);
+      if ((dummy == "yes") or (dummy == "true"))
+      {
+        QMMMOpts.GEMCube = 1;
+      }
+    }
+    else if (keyword == "gem_debug:")
+    {
+      //Print the GEM Coulomb energies for comparison
+      regionFile >> dummy;
+      LICHEMLowerText(dummy);
+      if ((dummy == "yes") or (dummy == "true"))
+      {
+        QMMMOpts.GEMDebug = 1;
+      }
+    }
+    else if (keyword == "gem_dispersion:")
+    {
+      //Add the GEM dispersion energy between the MM atoms
+      regionFile >> dummy;
+      LICHEMLowerText(dummy);
+      if ((dummy == "yes") or (dummy == "true"))
+      {
+        QMMMOpts.GEMDisp = 1;
+      }
+    }
+    else if (keyword == "hessian_atoms:")
+    {
+      //Read the list of atoms displaced in finite-difference Hessians
+      int numActive;
+      regionFile >> numActive;
+      //Mark all atoms as inactive
+      #pragma omp parallel for schedule(dynamic)
+      for (int i=0;i<Natoms;i++)
+      {
+        QMMMData[i].hessActive = 0;
+      }
+      //Activate the selected atoms
+      for (int i=0;i<numActive;i++)
+      {
+        int atomID;
+        regionFile >> atomID;
+        QMMMData[atomID].hessActive = 1;
+      }
+    }
     else if (keyword == "init_path_chk:")
     {
       //Check for inactive NEB end-points
@@ -479,6 +616,11 @@ void ReadLICHEMInput(fstream& xyzFile, fstream& connectFile,
       //Read the exponent for the LREC smoothing function
       regionFile >> QMMMOpts.LRECPow;
     }
+    else if (keyword == "max_beads:")
+    {
+      //Read the largest number of beads for the growing string
+      regionFile >> QMMMOpts.maxBeads;
+    }
     else if (keyword == "max_opt_steps:")
     {
       //Read maximum number of optimization steps
@@ -489,6 +631,21 @@ void ReadLICHEMInput(fstream& xyzFile, fstream& connectFile,
       //Read the maximum displacement during optimizations
       regionFile >> QMMMOpts.maxStep;
     }
+    else if (keyword == "micro_disp:")
+    {
+      //Read the QM displacement which triggers an MM relaxation
+      regionFile >> QMMMOpts.microDisp;
+    }
+    else if (keyword == "micro_iterations:")
+    {
+      //Relax the MM region after each QM step
+      regionFile >> dummy;
+      LICHEMLowerText(dummy);
+      if ((dummy == "yes") or (dummy == "true"))
+      {
+        QMMMOpts.microIter = 1;
+      }
+    }
     else if (keyword == "mm_opt_cut:")
     {
       //Read MM optimization cutoff
@@ -855,6 +1012,44 @@ void ReadLICHEMInput(fstream& xyzFile, fstream& connectFile,
     }
   }
   Nmm = Natoms-Nqm-Npseudo-Nbound; //Set number of MM atoms
+  //Build the periodic cell for the minimum image convention
+  pbcBox.update();
+  if (TINKER)
+  {
+    //Sort the multipole frames for the rotations
+    BuildMPFrames(QMMMData);
+  }
+  if (GEM and (QMMMOpts.GEMBasis != "N/A"))
+  {
+    //Load the Hermite basis sets once and share them between atoms
+    hermBasisDB.readFile(QMMMOpts.GEMBasisFile);
+    for (int i=0;i<Natoms;i++)
+    {
+      if (QMMMData[i].MMRegion)
+      {
+        //Set up the densities for all beads
+        GEMDen tmp(QMMMData[i].QMTyp,QMMMOpts.GEMBasis);
+        if (TINKER)
+        {
+          //Replace the moments with the cached GEM-DM in the same frame
+          MPole& pole = QMMMData[i].MP[0]; //Multipoles for bead 0
+          tmp.setFrame(pole.chiralFlip,pole.type,pole.atom1,pole.atom2,
+                       pole.atom3);
+          MPole gemPole = tmp.GEMDM(); //GEM multipoles
+          gemPole.IDx = pole.IDx;
+          gemPole.IDy = pole.IDy;
+          gemPole.IDz = pole.IDz;
+          pole = gemPole;
+        }
+        QMMMData[i].GEM.assign(QMMMOpts.NBeads,tmp);
+      }
+    }
+    if (QMMMOpts.GEMDisp)
+    {
+      //Create empty neighbor lists, which are built on the first call
+      gemNbrLists.assign(QMMMOpts.NBeads,GEMNeighborList());
+    }
+  }
   //Replicate atoms
   if (QMMMOpts.NBeads > 1)
   {
@@ -874,7 +1069,7 @@ void ReadLICHEMInput(fstream& xyzFile, fstream& connectFile,
       }
     }
     //Set initial transition state for reaction pathways
-    if (NEBSim)
+    if (NEBSim or StringSim)
     {
       if ((QMMMOpts.NBeads%2) == 0)
       {
@@ -955,7 +1150,7 @@ void ReadLICHEMInput(fstream& xyzFile, fstream& connectFile,
       }
     }
   }
-  else if (NEBSim)
+  else if (NEBSim or StringSim)
   {
     //Exit with an error
     cout << "Error: No initial reaction path found in the restart file!!!";
@@ -1051,15 +1246,15 @@ void LICHEMErrorChecker(QMMMSettings& QMMMOpts)
     //Check LREC cutoff
     if (PBCon)
     {
-      //Find maximum box length
-      double minLen = Lx;
-      if (Ly < minLen)
+      //Find the smallest width of the cell
+      double minLen = pbcBox.ax;
+      if (pbcBox.by < minLen)
       {
-        minLen = Ly;
+        minLen = pbcBox.by;
       }
-      if (Lz < minLen)
+      if (pbcBox.cz < minLen)
       {
-        minLen = Lz;
+        minLen = pbcBox.cz;
       }
       //Check cutoff
       if (QMMMOpts.useLREC and (QMMMOpts.LRECCut > (0.5*minLen)))
@@ -1104,6 +1299,29 @@ void LICHEMErrorChecker(QMMMSettings& QMMMOpts)
     cout << '\n';
     doQuit = 1;
   }
+  //Check the periodic cell
+  if (PBCon and (!(pbcBox.cz > 0)))
+  {
+    //The angles cannot be satisfied with these lengths
+    cout << " Error: The box angles do not form a valid cell.";
+    cout << '\n';
+    doQuit = 1;
+  }
+  if (PBCon and pbcBox.triclinic and GEM)
+  {
+    //The GEM grids and cell lists use orthorhombic boxes
+    cout << " Error: GEM calculations cannot be used with triclinic boxes.";
+    cout << '\n';
+    doQuit = 1;
+  }
+  if (QMMMOpts.GEMDisp and ((!GEM) or (QMMMOpts.GEMBasis == "N/A")))
+  {
+    //The dispersion parameters are stored with the GEM basis sets
+    cout << " Error: GEM dispersion requires the GEM potential and a";
+    cout << " GEM basis set.";
+    cout << '\n';
+    doQuit = 1;
+  }
   //Check threading
   if (Ncpus < 1)
   {
@@ -1209,6 +1427,97 @@ void LICHEMErrorChecker(QMMMSettings& QMMMOpts)
     cout << '\n';
     doQuit = 1;
   }
+  if (BFGSSim and (QMMMOpts.BFGSHist < 1))
+  {
+    //Check the L-BFGS history
+    cout << " Error: The L-BFGS history must store at least one update.";
+    cout << '\n';
+    doQuit = 1;
+  }
+  if (QMMMOpts.microIter and (QMMMOpts.microDisp <= 0))
+  {
+    //Check the microiteration threshold
+    cout << " Error: The microiteration displacement must be positive.";
+    cout << '\n';
+    doQuit = 1;
+  }
+  if ((QMMMOpts.convMetric != "Matrix") and
+     (QMMMOpts.convMetric != "Neighbor") and
+     (QMMMOpts.convMetric != "Kabsch"))
+  {
+    //Check the convergence metric
+    cout << " Error: Unrecognized convergence metric: ";
+    cout << QMMMOpts.convMetric << '\n';
+    cout << "  Options: Matrix, Neighbor, or Kabsch.";
+    cout << '\n';
+    doQuit = 1;
+  }
+  if ((QMMMOpts.convMetric == "Neighbor") and (QMMMOpts.convCut <= 0))
+  {
+    //Check the neighbor cutoff
+    cout << " Error: The convergence cutoff must be positive.";
+    cout << '\n';
+    doQuit = 1;
+  }
+  if ((FreqCalc or QMMMOpts.NEBFreq) and LAMMPS and (!QMMMOpts.FDHess))
+  {
+    //LAMMPS does not provide Hessians
+    cout << " Warning: LAMMPS Hessians are not available.";
+    cout << '\n';
+    cout << " The Hessian will be calculated from finite differences.";
+    cout << '\n';
+    QMMMOpts.FDHess = 1; //Switch to finite differences
+    cout.flush(); //Print warning
+  }
+  if (QMMMOpts.FDHess and (QMMMOpts.FDStep <= 0))
+  {
+    //Check the finite-difference displacement
+    cout << " Error: The finite-difference step size must be positive.";
+    cout << '\n';
+    doQuit = 1;
+  }
+  if (QMMMOpts.FDHess and (QMMMOpts.FDJobs < 1))
+  {
+    //Check the number of concurrent gradients
+    cout << " Error: At least one finite-difference job must be used.";
+    cout << '\n';
+    doQuit = 1;
+  }
+  if (StringSim and (QMMMOpts.NBeads < 3))
+  {
+    //The string needs at least one bead between the end points
+    cout << " Error: The string method requires at least three beads.";
+    cout << '\n';
+    doQuit = 1;
+  }
+  if (StringSim and (QMMMOpts.maxBeads < QMMMOpts.NBeads))
+  {
+    if (QMMMOpts.maxBeads > 0)
+    {
+      //Growing would never be allowed
+      cout << " Warning: The maximum number of beads is smaller than the";
+      cout << " initial path.";
+      cout << '\n';
+      cout << " The string will not grow.";
+      cout << '\n';
+      QMMMOpts.maxBeads = QMMMOpts.NBeads;
+      cout.flush(); //Print warning
+    }
+    else
+    {
+      //Default: allow the string to double its resolution
+      QMMMOpts.maxBeads = 2*QMMMOpts.NBeads-1;
+    }
+  }
+  if (QMMMOpts.microIter and (!BFGSSim))
+  {
+    //Microiterations are only implemented for L-BFGS
+    cout << " Warning: MM microiterations are only used by the L-BFGS";
+    cout << " optimizer.";
+    cout << '\n';
+    QMMMOpts.microIter = 0; //Turn off microiterations
+    cout.flush(); //Print warning
+  }
   if (QMMMOpts.stepScale > 1)
   {
     //Checks the number of threads and continue
@@ -1280,7 +1589,7 @@ void LICHEMPrintSettings(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
       cout << " Frozen atoms: " << Nfreeze << '\n';
     }
   }
-  if (NEBSim)
+  if (NEBSim or StringSim)
   {
     //Print reaction path input for error checking
     cout << " RP beads: " << QMMMOpts.NBeads << '\n';
@@ -1298,7 +1607,14 @@ void LICHEMPrintSettings(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
     {
       cout << "Pure MM";
     }
-    cout << " NEB" << '\n';
+    if (NEBSim)
+    {
+      cout << " NEB" << '\n';
+    }
+    if (StringSim)
+    {
+      cout << " string method" << '\n';
+    }
   }
   if (PIMCSim)
   {
@@ -1360,7 +1676,7 @@ void LICHEMPrintSettings(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
     cout << " Equilibration MC steps: " << QMMMOpts.NEq << '\n';
     cout << " Production MC steps: " << QMMMOpts.NSteps << '\n';
   }
-  if (OptSim or SteepSim or DFPSim)
+  if (OptSim or SteepSim or DFPSim or BFGSSim or RICSim)
   {
     //Print optimization input for error checking
     cout << '\n';
@@ -1398,6 +1714,14 @@ void LICHEMPrintSettings(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
       {
         cout << "LICHEM DFP" << '\n';
       }
+      if (BFGSSim)
+      {
+        cout << "LICHEM L-BFGS" << '\n';
+      }
+      if (RICSim)
+      {
+        cout << "LICHEM redundant internal coordinates" << '\n';
+      }
     }
   }
   if (SinglePoint)
@@ -1499,10 +1823,24 @@ void LICHEMPrintSettings(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
       if (AMOEBA)
       {
         cout << "Polarizable force field" << '\n';
+        if (QMMMOpts.embedTol > 0)
+        {
+          cout << " Multipole compression tolerance: ";
+          cout << LICHEMFormFloat(QMMMOpts.embedTol,12);
+          cout << " a.u." << '\n';
+        }
       }
       if (GEM)
       {
         cout << "Diffuse-charge force field" << '\n';
+        if (QMMMOpts.GEMBasis != "N/A")
+        {
+          cout << " GEM basis set: " << QMMMOpts.GEMBasis << '\n';
+        }
+        if (QMMMOpts.GEMDisp)
+        {
+          cout << " GEM dispersion: Yes" << '\n';
+        }
       }
     }
     //Print PBC information
@@ -1596,7 +1934,8 @@ void LICHEMPrintSettings(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
     cout << " steps" << '\n';
   }
   //Print convergence criteria for optimizations
-  if (OptSim or SteepSim or DFPSim or NEBSim)
+  if (OptSim or SteepSim or DFPSim or BFGSSim or RICSim or NEBSim or
+      StringSim)
   {
     cout << '\n';
     cout << "Optimization settings:" << '\n';
@@ -1610,6 +1949,29 @@ void LICHEMPrintSettings(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
     cout << LICHEMFormFloat(QMMMOpts.maxStep,6);
     cout << " \u212B" << '\n';
     cout << " Max. steps: " << QMMMOpts.maxOptSteps;
+    cout << '\n';
+    cout << " RMS deviation metric: " << QMMMOpts.convMetric;
+    if (QMMMOpts.convMetric == "Neighbor")
+    {
+      cout << " (" << LICHEMFormFloat(QMMMOpts.convCut,8);
+      cout << " \u212B)";
+    }
+    if (BFGSSim)
+    {
+      //Print the size of the L-BFGS history
+      cout << '\n';
+      cout << " L-BFGS history: " << QMMMOpts.BFGSHist;
+      if (QMMMOpts.microIter and QMMM and (Nmm > 0))
+      {
+        //Print microiteration settings
+        cout << '\n';
+        cout << " MM microiterations: Yes";
+        cout << '\n';
+        cout << " Microiteration displacement: ";
+        cout << LICHEMFormFloat(QMMMOpts.microDisp,8);
+        cout << " \u212B";
+      }
+    }
     if (QMMMOpts.useMMCut and (Nmm > 0))
     {
       //Print MM cutoff settings
@@ -1618,12 +1980,20 @@ void LICHEMPrintSettings(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
       cout << LICHEMFormFloat(QMMMOpts.MMOptCut,8);
       cout << " \u212B";
     }
-    if (NEBSim)
+    if (NEBSim or StringSim)
     {
-      //Spring constant for the path
       cout << '\n';
-      cout << " Spring constant: " << QMMMOpts.kSpring;
-      cout << " eV/\u212B\u00B2" << '\n';
+      if (NEBSim)
+      {
+        //Spring constant for the path
+        cout << " Spring constant: " << QMMMOpts.kSpring;
+        cout << " eV/\u212B\u00B2" << '\n';
+      }
+      if (StringSim)
+      {
+        //Growth limit for the string
+        cout << " Max. beads: " << QMMMOpts.maxBeads << '\n';
+      }
       cout << " End points: ";
       if (QMMMOpts.frznEnds)
       {
@@ -1633,9 +2003,11 @@ void LICHEMPrintSettings(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
       {
         cout << "Active";
       }
+      cout << '\n';
+      cout << " Path optimizer: FIRE";
     }
     cout << '\n';
-    if (SteepSim or DFPSim or NEBSim)
+    if (SteepSim or DFPSim or BFGSSim or RICSim or NEBSim or StringSim)
     {
       cout << '\n';
       cout << "QM convergence criteria:" << '\n';
@@ -1662,6 +2034,19 @@ void LICHEMPrintSettings(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
   {
     cout << '\n';
     cout << "Frequency settings:" << '\n';
+    //Hessian type
+    cout << "  Hessian: ";
+    if (QMMMOpts.FDHess)
+    {
+      cout << "Finite-difference (";
+      cout << LICHEMFormFloat(QMMMOpts.FDStep,8);
+      cout << " \u212B, " << QMMMOpts.FDJobs << " concurrent jobs)";
+      cout << '\n';
+    }
+    else
+    {
+      cout << "Analytic" << '\n';
+    }
     //Always removed
     cout << "  Remove low frequencies: Yes";
     cout << '\n';
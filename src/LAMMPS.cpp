@@ -46,8 +46,14 @@ double LAMMPSEnergy(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
   if (PBCon)
   {
     call << "0.0 " << Lx << " xlo xhi" << '\n';
-    call << "0.0 " << Ly << " ylo yhi" << '\n';
-    call << "0.0 " << Lz << " zlo zhi" << '\n';
+    call << "0.0 " << pbcBox.by << " ylo yhi" << '\n';
+    call << "0.0 " << pbcBox.cz << " zlo zhi" << '\n';
+    if (pbcBox.triclinic)
+    {
+      //Tilt factors of the triclinic cell
+      call << pbcBox.bx << " " << pbcBox.cx << " " << pbcBox.cy;
+      call << " xy xz yz" << '\n';
+    }
   }
   else
   {
@@ -79,6 +79,13 @@ int main(int argc, char* argv[])
   }
   //End of section
 
+  //Write the GEM densities for visualization
+  if (GEM and QMMMOpts.GEMCube)
+  {
+    WriteGEMCube(QMMMData,"LICHEM_GEM.cube",0);
+  }
+  //End of section
+
   //Create backup directories
   if (CheckFile("BACKUPQM"))
   {
@@ -168,6 +175,12 @@ int main(int argc, char* argv[])
         Emm += LAMMPSEnergy(QMMMData,QMMMOpts,p);
         MMTime += (unsigned)time(0)-tStart;
       }
+      if (QMMMOpts.GEMDisp)
+      {
+        int tStart = (unsigned)time(0);
+        Emm += GEMDispEnergy(QMMMData,gemNbrLists[p],p);
+        MMTime += (unsigned)time(0)-tStart;
+      }
       //Print the rest of the energies
       if (QMMM or MMonly)
       {
@@ -175,6 +188,26 @@ int main(int argc, char* argv[])
         cout << "  MM energy: " << LICHEMFormFloat(Emm,16) << " eV";
         cout << '\n';
       }
+      if (GEM and QMMMOpts.GEMDebug and (QMMMOpts.GEMBasis != "N/A") and
+         (Nmm > 0))
+      {
+        //Print the frozen density electrostatics
+        //NB: These energies are only for comparison with the GEM multipoles,
+        //so they are not added to the total energy
+        int tStart = (unsigned)time(0);
+        double Egem = GEMCoulombEnergy(QMMMData,p); //MM density energy
+        cout << "  GEM Coulomb energy: ";
+        cout << LICHEMFormFloat(Egem,16) << " eV";
+        cout << '\n';
+        if (QMMM)
+        {
+          Egem = GEMChargeEnergy(QMMMData,p);
+          cout << "  GEM-QM Coulomb energy: ";
+          cout << LICHEMFormFloat(Egem,16) << " eV";
+          cout << '\n';
+        }
+        MMTime += (unsigned)time(0)-tStart;
+      }
       sumE = Eqm+Emm; //Total energy
       if (QMMM)
       {
@@ -198,6 +231,7 @@ int main(int argc, char* argv[])
     int Ndof = 3*(Nqm+Npseudo); //Number of degrees of freedom
     MatrixXd QMMMHess(Ndof,Ndof);
     VectorXd QMMMFreqs(Ndof);
+    vector<MatrixXd> FDHessList; //Saved finite-difference Hessians
     if (QMMMOpts.NBeads == 1)
     {
       cout << "Single-point frequencies:";
@@ -221,38 +255,83 @@ int main(int argc, char* argv[])
         cout << " Frequencies for bead: " << p << '\n';
         cout.flush();
       }
-      if (Gaussian)
+      if (QMMMOpts.FDHess)
       {
-        int tStart = (unsigned)time(0);
-        QMMMHess += GaussianHessian(QMMMData,QMMMOpts,p);
-        QMTime += (unsigned)time(0)-tStart;
-      }
-      if (PSI4)
-      {
-        int tStart = (unsigned)time(0);
-        QMMMHess += PSI4Hessian(QMMMData,QMMMOpts,p);
-        QMTime += (unsigned)time(0)-tStart;
-        //Delete annoying useless files
-        globalSys = system("rm -f psi.* timer.*");
-      }
-      if (NWChem)
-      {
-        int tStart = (unsigned)time(0);
-        QMMMHess += NWChemHessian(QMMMData,QMMMOpts,p);
-        QMTime += (unsigned)time(0)-tStart;
-      }
-      //Calculate MM energy
-      if (TINKER)
-      {
-        int tStart = (unsigned)time(0);
-        QMMMHess += TINKERHessian(QMMMData,QMMMOpts,p);
-        MMTime += (unsigned)time(0)-tStart;
+        //Check for an identical bead
+        int copyBead = -1; //Bead with the same geometry
+        for (int q=0;q<p;q++)
+        {
+          bool sameGeom = 1;
+          for (int i=0;i<Natoms;i++)
+          {
+            if ((QMMMData[i].P[p].x != QMMMData[i].P[q].x) or
+               (QMMMData[i].P[p].y != QMMMData[i].P[q].y) or
+               (QMMMData[i].P[p].z != QMMMData[i].P[q].z))
+            {
+              sameGeom = 0;
+              break;
+            }
+          }
+          if (sameGeom)
+          {
+            copyBead = q;
+            break;
+          }
+        }
+        if (copyBead >= 0)
+        {
+          //Reuse the finite-difference Hessian
+          cout << "  | Reusing the Hessian from bead " << copyBead;
+          cout << '\n';
+          QMMMHess = FDHessList[copyBead];
+        }
+        else
+        {
+          //Calculate the QMMM Hessian from finite differences
+          //NB: The QM and MM gradients run together, so the wall time is
+          //collected as QM time
+          int tStart = (unsigned)time(0);
+          QMMMHess = LICHEMFDHessian(QMMMData,QMMMOpts,p);
+          QMTime += (unsigned)time(0)-tStart;
+        }
+        FDHessList.push_back(QMMMHess);
       }
-      if (LAMMPS)
+      else
       {
-        int tStart = (unsigned)time(0);
-        QMMMHess += LAMMPSHessian(QMMMData,QMMMOpts,p);
-        MMTime += (unsigned)time(0)-tStart;
+        //Calculate the analytic QM and MM Hessians
+        if (Gaussian)
+        {
+          int tStart = (unsigned)time(0);
+          QMMMHess += GaussianHessian(QMMMData,QMMMOpts,p);
+          QMTime += (unsigned)time(0)-tStart;
+        }
+        if (PSI4)
+        {
+          int tStart = (unsigned)time(0);
+          QMMMHess += PSI4Hessian(QMMMData,QMMMOpts,p);
+          QMTime += (unsigned)time(0)-tStart;
+          //Delete annoying useless files
+          globalSys = system("rm -f psi.* timer.*");
+        }
+        if (NWChem)
+        {
+          int tStart = (unsigned)time(0);
+          QMMMHess += NWChemHessian(QMMMData,QMMMOpts,p);
+          QMTime += (unsigned)time(0)-tStart;
+        }
+        //Calculate MM energy
+        if (TINKER)
+        {
+          int tStart = (unsigned)time(0);
+          QMMMHess += TINKERHessian(QMMMData,QMMMOpts,p);
+          MMTime += (unsigned)time(0)-tStart;
+        }
+        if (LAMMPS)
+        {
+          int tStart = (unsigned)time(0);
+          QMMMHess += LAMMPSHessian(QMMMData,QMMMOpts,p);
+          MMTime += (unsigned)time(0)-tStart;
+        }
       }
       //Calculate frequencies
       QMMMFreqs = LICHEMFreq(QMMMData,QMMMHess,QMMMOpts,p,remCt);
@@ -499,8 +578,8 @@ int main(int argc, char* argv[])
   }
   //End of section
 
-  //DFP minimization
-  else if (DFPSim)
+  //DFP, L-BFGS, and internal coordinate minimization
+  else if (DFPSim or BFGSSim or RICSim)
   {
     VectorXd forces; //Dummy array needed for convergence tests
     int optCt = 0; //Counter for optimization steps
@@ -517,7 +596,18 @@ int main(int argc, char* argv[])
     }
     //Print initial structure
     Print_traj(QMMMData,outFile,QMMMOpts);
-    cout << "DFP optimization:" << '\n';
+    if (DFPSim)
+    {
+      cout << "DFP optimization:" << '\n';
+    }
+    if (BFGSSim)
+    {
+      cout << "L-BFGS optimization:" << '\n';
+    }
+    if (RICSim)
+    {
+      cout << "Internal coordinate optimization:" << '\n';
+    }
     cout.flush(); //Print progress
     //Calculate initial energy
     sumE = 0; //Clear old energies
@@ -567,19 +657,26 @@ int main(int argc, char* argv[])
       //Copy structure
       OldQMMMData = QMMMData;
       //Run MM optimization
-      if (TINKER)
+      //NB: With microiterations, L-BFGS relaxes the MM region itself after
+      //the first iteration
+      bool runMMOpt = 1; //Flag to run the full MM optimization
+      if (QMMMOpts.microIter and QMMM and (Nmm > 0) and (optCt > 0))
+      {
+        runMMOpt = 0;
+      }
+      if (TINKER and runMMOpt)
       {
         int tStart = (unsigned)time(0);
         sumE = TINKEROpt(QMMMData,QMMMOpts,0);
         MMTime += (unsigned)time(0)-tStart;
       }
-      if (LAMMPS)
+      if (LAMMPS and runMMOpt)
       {
         int tStart = (unsigned)time(0);
         sumE = LAMMPSOpt(QMMMData,QMMMOpts,0);
         MMTime += (unsigned)time(0)-tStart;
       }
-      if (QMMM)
+      if (QMMM and runMMOpt)
       {
         cout << "    MM optimization complete.";
         cout << '\n';
@@ -587,7 +684,18 @@ int main(int argc, char* argv[])
       }
       cout << '\n';
       //Run QM optimization
-      LICHEMDFP(QMMMData,QMMMOpts,0);
+      if (DFPSim)
+      {
+        LICHEMDFP(QMMMData,QMMMOpts,0);
+      }
+      if (BFGSSim)
+      {
+        LICHEMBFGS(QMMMData,QMMMOpts,0);
+      }
+      if (RICSim)
+      {
+        LICHEMIntOpt(QMMMData,QMMMOpts,0);
+      }
       //Reset tolerance before optimization check
       QMMMOpts.QMOptTol = savedQMOptTol;
       QMMMOpts.MMOptTol = savedMMOptTol;
@@ -659,7 +767,7 @@ int main(int argc, char* argv[])
     if (volProb > 0)
     {
       //Add PV term
-      QMMMOpts.EOld += QMMMOpts.press*Lx*Ly*Lz;
+      QMMMOpts.EOld += QMMMOpts.press*pbcBox.volume();
     }
     Emc = QMMMOpts.EOld; //Needed if equilibration is skipped
     Nct = 0; //Reset counter to zero
@@ -849,12 +957,17 @@ int main(int argc, char* argv[])
     double Nacc = 0; //Number of accepted moves
     double Nrej = 0; //Number of rejected moves
     int acc; //Number of steps accepted along the path
+    int rej; //Number of steps rejected along the path
     vector<VectorXd> allForces; //Stores forces between MC steps
     VectorXd sumE(QMMMOpts.NBeads); //Average energy array
     VectorXd sumE2(QMMMOpts.NBeads); //Average squared energy array
     VectorXd Emc(QMMMOpts.NBeads); //Current MC energy
+    VectorXd beadAcc(QMMMOpts.NBeads); //Accepted moves for each bead
+    VectorXd beadRej(QMMMOpts.NBeads); //Rejected moves for each bead
     sumE.setZero();
     sumE2.setZero();
+    beadAcc.setZero();
+    beadRej.setZero();
     Emc.setIdentity(); //Initial energies should not be zero
     Emc *= hugeNum; //Forces the first step to be accepted
     //Initialize force arrays
@@ -925,10 +1038,10 @@ int main(int argc, char* argv[])
       }
       //Continue simulation
       ct += 1; //Equilibration counts cycles instead of steps
-      acc = FBNEBMCMove(QMMMData,allForces,QMMMOpts,Emc);
+      acc = FBNEBMCMove(QMMMData,allForces,QMMMOpts,Emc,beadAcc,beadRej,rej);
       Nct += acc; //Equilibration counts acceptances instead of steps
       Nacc += acc;
-      Nrej += QMMMOpts.NBeads-acc;
+      Nrej += rej;
     }
     QMMMOpts.NPrint = savedNPrint; //Restore user defined sample rate
     cout << " Equilibration complete." << '\n';
@@ -936,6 +1049,8 @@ int main(int argc, char* argv[])
     Nct = 0; //Reset counter to zero
     Nacc = 0; //Reset counter to zero
     Nrej = 0; //Reset counter to zero
+    beadAcc.setZero(); //Reset counters to zero
+    beadRej.setZero(); //Reset counters to zero
     cout << '\n';
     cout << "Monte Carlo production:" << '\n';
     cout.flush();
@@ -954,7 +1069,7 @@ int main(int argc, char* argv[])
     //Continue simulation
     while (Nacc < QMMMOpts.NSteps)
     {
-      acc = FBNEBMCMove(QMMMData,allForces,QMMMOpts,Emc);
+      acc = FBNEBMCMove(QMMMData,allForces,QMMMOpts,Emc,beadAcc,beadRej,rej);
       //Update statistics
       #pragma omp parallel for schedule(dynamic)
       for (int p=0;p<QMMMOpts.NBeads;p++)
@@ -965,7 +1080,7 @@ int main(int argc, char* argv[])
       //Update counters
       Nct += QMMMOpts.NBeads;
       Nacc += acc;
-      Nrej += QMMMOpts.NBeads;
+      Nrej += rej;
       //Print output
       if ((((Nct/QMMMOpts.NBeads)%QMMMOpts.NPrint) == 0) or
          (Nacc == QMMMOpts.NSteps))
@@ -979,7 +1094,9 @@ int main(int argc, char* argv[])
         {
           cout << "    Bead: ";
           cout << setw(3) << p << " | Energy: ";
-          cout << LICHEMFormFloat(Emc(p),16) << " eV" << '\n';
+          cout << LICHEMFormFloat(Emc(p),16) << " eV";
+          cout << " | Accepted: " << setw(simCharLen) << beadAcc(p);
+          cout << '\n';
         }
         cout.flush(); //Print results
       }
@@ -1004,7 +1121,7 @@ int main(int argc, char* argv[])
     cout << '\n';
     cout << "Monte Carlo statistics:" << '\n';
     cout << " | Acceptance ratio: ";
-    cout << LICHEMFormFloat((Nacc/Nct),6);
+    cout << LICHEMFormFloat((Nacc/(Nrej+Nacc)),6);
     cout << " | Optimized step size: ";
     cout << LICHEMFormFloat(mcStep,6);
     cout << " \u212B";
@@ -1018,16 +1135,38 @@ int main(int argc, char* argv[])
       cout << " +/- " << LICHEMFormFloat(sumE2(p),16);
       cout << " eV" << '\n';
     }
+    cout << " | Bead acceptance ratios:" << '\n';
+    for (int p=0;p<QMMMOpts.NBeads;p++)
+    {
+      cout << "    Bead: ";
+      cout << setw(3) << p << " | Acceptance ratio: ";
+      double beadRatio = 0; //Acceptance ratio of the bead
+      if ((beadAcc(p)+beadRej(p)) > 0)
+      {
+        //Frozen end points have no trial moves
+        beadRatio = beadAcc(p)/(beadAcc(p)+beadRej(p));
+      }
+      cout << LICHEMFormFloat(beadRatio,6);
+      cout << '\n';
+    }
     cout << '\n';
     cout.flush();
   }
   //End of section
 
-  //NEB optimization
-  else if (NEBSim)
+  //NEB and string method optimization
+  else if (NEBSim or StringSim)
   {
     MatrixXd forceStats; //Dummy array needed for convergence tests
     int optCt = 0; //Counter for optimization steps
+    int gradCt = 0; //Counter for string gradient calculations
+    //Saved NEB forces
+    //NB: Beads which do not move keep their forces between QMMM steps
+    MatrixXd pathForces(3*(Nqm+Npseudo),QMMMOpts.NBeads);
+    VectorXd pathE(QMMMOpts.NBeads);
+    vector<int> beadActive(QMMMOpts.NBeads,1); //Beads which changed
+    pathForces.setZero();
+    pathE.setZero();
     //Check number of beads for Climbing image
     if (QMMMOpts.NBeads < 4)
     {
@@ -1047,67 +1186,32 @@ int main(int argc, char* argv[])
     }
     //Print initial structure
     Print_traj(QMMMData,outFile,QMMMOpts);
-    cout << "Nudged elastic band optimization:" << '\n';
+    if (NEBSim)
+    {
+      cout << "Nudged elastic band optimization:" << '\n';
+    }
+    if (StringSim)
+    {
+      cout << "String method optimization:" << '\n';
+    }
     if (QMMMOpts.climb)
     {
-      cout << " | Short path detected. Starting climbing image NEB.";
+      cout << " | Short path detected. Starting climbing image ";
+      if (NEBSim)
+      {
+        cout << "NEB.";
+      }
+      if (StringSim)
+      {
+        cout << "string.";
+      }
       cout << '\n' << '\n';
     }
     cout << " | Opt. step: 0 | Bead energies:";
     cout << '\n';
     cout.flush(); //Print progress
     //Calculate reaction coordinate positions
-    VectorXd reactCoord(QMMMOpts.NBeads); //Reaction coordinate
-    reactCoord.setZero();
-    for (int p=0;p<(QMMMOpts.NBeads-1);p++)
-    {
-      MatrixXd geom1((Nqm+Npseudo),3); //Current replica
-      MatrixXd geom2((Nqm+Npseudo),3); //Next replica
-      VectorXd disp; //Store the displacement
-      //Save geometries
-      int ct = 0; //Reset counter for the number of atoms
-      for (int i=0;i<Natoms;i++)
-      {
-        //Only include QM and PB regions
-        if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
-        {
-          //Save current replica
-          geom1(ct,0) = QMMMData[i].P[p].x;
-          geom1(ct,1) = QMMMData[i].P[p].y;
-          geom1(ct,2) = QMMMData[i].P[p].z;
-          //Save replica p+1
-          geom2(ct,0) = QMMMData[i].P[p+1].x;
-          geom2(ct,1) = QMMMData[i].P[p+1].y;
-          geom2(ct,2) = QMMMData[i].P[p+1].z;
-          ct += 1;
-        }
-      }
-      //Calculate displacement
-      disp = KabschDisplacement(geom1,geom2,(Nqm+Npseudo));
-      //Remove inactive atoms
-      ct = 0; //Reset counter for the number of atoms
-      for (int i=0;i<Natoms;i++)
-      {
-        //Only include QM and PB regions
-        if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
-        {
-          //Only include active atoms in the tangent
-          if (!QMMMData[i].NEBActive)
-          {
-            //Delete distance components
-            disp(ct) = 0;
-            disp(ct+1) = 0;
-            disp(ct+2) = 0;
-          }
-          //Advance counter
-          ct += 3;
-        }
-      }
-      //Update reaction coordinate
-      reactCoord(p+1) = reactCoord(p); //Start from previous bead
-      reactCoord(p+1) += disp.norm(); //Add magnitude of the displacement
-    }
-    reactCoord /= reactCoord.maxCoeff(); //Must be between 0 and 1
+    VectorXd reactCoord = PathReactCoord(QMMMData,QMMMOpts);
     //Calculate initial energies
     QMMMOpts.ETrans = -1*hugeNum; //Locate the initial transition state
     for (int p=0;p<QMMMOpts.NBeads;p++)
@@ -1198,21 +1302,27 @@ int main(int argc, char* argv[])
     }
     //Run optimization
     bool pathDone = 0;
-    int pathStart = 0; //First bead to optimize
-    int pathEnd = QMMMOpts.NBeads; //Last bead to optimize
-    if (QMMMOpts.frznEnds)
-    {
-      //Change the start and end points
-      pathStart = 1;
-      pathEnd = QMMMOpts.NBeads-1;
-    }
     while (!pathDone)
     {
+      //NB: The string method can add beads to the path
+      int pathStart = 0; //First bead to optimize
+      int pathEnd = QMMMOpts.NBeads; //Last bead to optimize
+      if (QMMMOpts.frznEnds)
+      {
+        //Change the start and end points
+        pathStart = 1;
+        pathEnd = QMMMOpts.NBeads-1;
+      }
       //Copy structure
       OldQMMMData = QMMMData;
       //Run MM optimization
       for (int p=pathStart;p<pathEnd;p++)
       {
+        if (NEBSim and (!beadActive[p]))
+        {
+          //The environment of unchanged beads is already optimized
+          continue;
+        }
         if (TINKER)
         {
           int tStart = (unsigned)time(0);
@@ -1234,7 +1344,14 @@ int main(int argc, char* argv[])
       }
       cout << '\n';
       //Run QM optimization
-      LICHEMNEB(QMMMData,QMMMOpts,optCt);
+      if (NEBSim)
+      {
+        LICHEMNEB(QMMMData,pathForces,QMMMOpts,pathE,beadActive,optCt);
+      }
+      if (StringSim)
+      {
+        gradCt += LICHEMString(QMMMData,QMMMOpts,optCt);
+      }
       //Reset tolerance before optimization check
       QMMMOpts.QMOptTol = savedQMOptTol;
       QMMMOpts.MMOptTol = savedMMOptTol;
@@ -1248,6 +1365,11 @@ int main(int argc, char* argv[])
       {
         //Avoid terminating restarts on the loose tolerance step
         pathDone = 0; //Not converged
+        //Optimize all beads with the final tolerance
+        for (int p=pathStart;p<pathEnd;p++)
+        {
+          beadActive[p] = 1;
+        }
       }
     }
     BurstTraj(QMMMData,QMMMOpts);
@@ -1257,7 +1379,17 @@ int main(int argc, char* argv[])
     //Print the reaction barriers
     double dEfor = QMMMOpts.ETrans-QMMMOpts.EReact; //Forward barrier
     double dErev = QMMMOpts.ETrans-QMMMOpts.EProd; //Reverse barrier
-    cout << "NEB Results:" << '\n';
+    if (NEBSim)
+    {
+      cout << "NEB Results:" << '\n';
+    }
+    if (StringSim)
+    {
+      cout << "String method results:" << '\n';
+      cout << " | Beads: " << QMMMOpts.NBeads;
+      cout << " | Bead gradient calculations: " << gradCt;
+      cout << '\n' << '\n';
+    }
     cout << " | Transition state bead: " << QMMMOpts.TSBead;
     cout << '\n' << '\n';
     cout << " | Forward barrier: ";
@@ -1289,39 +1421,49 @@ int main(int argc, char* argv[])
       //Calculate QMMM frequencies
       QMMMHess.setZero(); //Reset Hessian
       QMMMFreqs.setZero(); //Reset frequencies
-      //Calculate QM Hessian
-      if (Gaussian)
-      {
-        int tStart = (unsigned)time(0);
-        QMMMHess += GaussianHessian(QMMMData,QMMMOpts,QMMMOpts.TSBead);
-        QMTime += (unsigned)time(0)-tStart;
-      }
-      if (PSI4)
-      {
-        int tStart = (unsigned)time(0);
-        QMMMHess += PSI4Hessian(QMMMData,QMMMOpts,QMMMOpts.TSBead);
-        QMTime += (unsigned)time(0)-tStart;
-        //Delete annoying useless files
-        globalSys = system("rm -f psi.* timer.*");
-      }
-      if (NWChem)
+      if (QMMMOpts.FDHess)
       {
+        //Calculate the QMMM Hessian from finite differences
         int tStart = (unsigned)time(0);
-        QMMMHess += NWChemHessian(QMMMData,QMMMOpts,QMMMOpts.TSBead);
+        QMMMHess = LICHEMFDHessian(QMMMData,QMMMOpts,QMMMOpts.TSBead);
         QMTime += (unsigned)time(0)-tStart;
       }
-      //Calculate MM Hessian
-      if (TINKER)
-      {
-        int tStart = (unsigned)time(0);
-        QMMMHess += TINKERHessian(QMMMData,QMMMOpts,QMMMOpts.TSBead);
-        MMTime += (unsigned)time(0)-tStart;
-      }
-      if (LAMMPS)
+      else
       {
-        int tStart = (unsigned)time(0);
-        QMMMHess += LAMMPSHessian(QMMMData,QMMMOpts,QMMMOpts.TSBead);
-        MMTime += (unsigned)time(0)-tStart;
+        //Calculate QM Hessian
+        if (Gaussian)
+        {
+          int tStart = (unsigned)time(0);
+          QMMMHess += GaussianHessian(QMMMData,QMMMOpts,QMMMOpts.TSBead);
+          QMTime += (unsigned)time(0)-tStart;
+        }
+        if (PSI4)
+        {
+          int tStart = (unsigned)time(0);
+          QMMMHess += PSI4Hessian(QMMMData,QMMMOpts,QMMMOpts.TSBead);
+          QMTime += (unsigned)time(0)-tStart;
+          //Delete annoying useless files
+          globalSys = system("rm -f psi.* timer.*");
+        }
+        if (NWChem)
+        {
+          int tStart = (unsigned)time(0);
+          QMMMHess += NWChemHessian(QMMMData,QMMMOpts,QMMMOpts.TSBead);
+          QMTime += (unsigned)time(0)-tStart;
+        }
+        //Calculate MM Hessian
+        if (TINKER)
+        {
+          int tStart = (unsigned)time(0);
+          QMMMHess += TINKERHessian(QMMMData,QMMMOpts,QMMMOpts.TSBead);
+          MMTime += (unsigned)time(0)-tStart;
+        }
+        if (LAMMPS)
+        {
+          int tStart = (unsigned)time(0);
+          QMMMHess += LAMMPSHessian(QMMMData,QMMMOpts,QMMMOpts.TSBead);
+          MMTime += (unsigned)time(0)-tStart;
+        }
       }
       //Calculate frequencies
       QMMMFreqs = LICHEMFreq(QMMMData,QMMMHess,QMMMOpts,QMMMOpts.TSBead,remCt);
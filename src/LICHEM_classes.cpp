@@ -38,6 +38,135 @@ double Coord::vecMag()
   return R2;
 };
 
+//PBCBox class function definitions
+PBCBox::PBCBox()
+{
+  //Constructor
+  ax = 0;
+  bx = 0;
+  by = 0;
+  cx = 0;
+  cy = 0;
+  cz = 0;
+  invAx = 0;
+  invBy = 0;
+  invCz = 0;
+  triclinic = 0;
+  return;
+};
+
+PBCBox::~PBCBox()
+{
+  //Generic destructor
+  return;
+};
+
+void PBCBox::update()
+{
+  //Builds the cell vectors from Lx, Ly, Lz, and the box angles
+  //NB: This must be called whenever the box or PBC settings change
+  triclinic = 0;
+  if ((boxAlpha != 90) or (boxBeta != 90) or (boxGamma != 90))
+  {
+    triclinic = 1;
+  }
+  ax = Lx;
+  bx = 0;
+  by = Ly;
+  cx = 0;
+  cy = 0;
+  cz = Lz;
+  if (triclinic)
+  {
+    //Tilt the b and c vectors
+    double cosA = cos(boxAlpha*pi/180);
+    double cosB = cos(boxBeta*pi/180);
+    double cosG = cos(boxGamma*pi/180);
+    double sinG = sin(boxGamma*pi/180);
+    bx = Ly*cosG;
+    by = Ly*sinG;
+    cx = Lz*cosB;
+    cy = Lz*(cosA-(cosB*cosG))/sinG;
+    cz = sqrt((Lz*Lz)-(cx*cx)-(cy*cy));
+  }
+  //Inverse widths, where zero turns off the wrapping
+  invAx = 0;
+  invBy = 0;
+  invCz = 0;
+  if (PBCon)
+  {
+    invAx = 1/ax;
+    invBy = 1/by;
+    invCz = 1/cz;
+  }
+  return;
+};
+
+void PBCBox::minImage(double& dx, double& dy, double& dz)
+{
+  //Branch-free minimum image convention for one displacement
+  //NB: The images are removed along c, b, and then a, which finds the
+  //shortest image for orthorhombic cells, and for triclinic cells when the
+  //distance is less than half of the smallest cell width
+  const double shift = 6755399441055744.0; //1.5*2^52 for rounding
+  double n = ((dz*invCz)+shift)-shift; //Nearest image along c
+  dx -= n*cx;
+  dy -= n*cy;
+  dz -= n*cz;
+  n = ((dy*invBy)+shift)-shift; //Nearest image along b
+  dx -= n*bx;
+  dy -= n*by;
+  n = ((dx*invAx)+shift)-shift; //Nearest image along a
+  dx -= n*ax;
+  return;
+};
+
+void PBCBox::scale(double fac)
+{
+  //Multiply the cell vectors by a unit conversion factor
+  ax *= fac;
+  bx *= fac;
+  by *= fac;
+  cx *= fac;
+  cy *= fac;
+  cz *= fac;
+  invAx /= fac;
+  invBy /= fac;
+  invCz /= fac;
+  return;
+};
+
+double PBCBox::volume()
+{
+  //Return the volume of the cell from the determinant of the cell vectors
+  return ax*by*cz;
+};
+
+void PBCBox::widths(double& wa, double& wb, double& wc)
+{
+  //Return the distances between opposite faces of the cell
+  //NB: Atoms closer than the width along a cell vector cannot be more
+  //than one layer of cells apart in fractional coordinates
+  double vol = volume(); //Volume of the cell
+  double bcX = by*cz; //x component of b cross c
+  double bcY = -1*bx*cz; //y component of b cross c
+  double bcZ = (bx*cy)-(by*cx); //z component of b cross c
+  wa = vol/sqrt((bcX*bcX)+(bcY*bcY)+(bcZ*bcZ));
+  wb = vol/(ax*sqrt((cy*cy)+(cz*cz)));
+  wc = cz;
+  return;
+};
+
+void PBCBox::fracCoords(double x, double y, double z, double& fa,
+                        double& fb, double& fc)
+{
+  //Convert a Cartesian position to fractional coordinates of the cell
+  fc = z/cz;
+  fb = (y-(fc*cy))/by;
+  fa = (x-(fc*cx)-(fb*bx))/ax;
+  return;
+};
+
 //MPole class function definitions
 MPole::MPole()
 {
@@ -51,6 +180,62 @@ MPole::~MPole()
   return;
 };
 
+//MPFrameTable class function definitions
+MPFrameTable::MPFrameTable()
+{
+  //Constructor
+  Nframes = 0;
+  Nblocks = 0;
+  return;
+};
+
+MPFrameTable::~MPFrameTable()
+{
+  //Generic destructor
+  return;
+};
+
+//TopologyTable class function definitions
+TopologyTable::TopologyTable()
+{
+  //Constructor
+  Nnodes = 0;
+  start12.push_back(0);
+  start13.push_back(0);
+  start14.push_back(0);
+  return;
+};
+
+TopologyTable::~TopologyTable()
+{
+  //Generic destructor
+  return;
+};
+
+//FIREState class function definitions
+FIREState::FIREState()
+{
+  //Constructor
+  reset(0.1);
+  return;
+};
+
+FIREState::~FIREState()
+{
+  //Generic destructor
+  return;
+};
+
+void FIREState::reset(double dtStart)
+{
+  //Start from the initial time step
+  dt = dtStart;
+  dtMax = fireDtMax*dtStart;
+  alpha = fireAlpha;
+  downhillCt = 0;
+  return;
+};
+
 //RedMPole class function definitions
 RedMPole::RedMPole()
 {
@@ -64,10 +249,37 @@ RedMPole::~RedMPole()
   return;
 };
 
+//IntCoord class function definitions
+IntCoord::IntCoord()
+{
+  //Constructor
+  type = 0;
+  atom1 = 0;
+  atom2 = 0;
+  atom3 = 0;
+  atom4 = 0;
+  kGuess = 0;
+  return;
+};
+
+IntCoord::~IntCoord()
+{
+  //Generic destructor
+  return;
+};
+
 //OctCharges class function definitions
 OctCharges::OctCharges()
 {
-  //Generic constructor
+  //Constructor
+  gridSet = 0;
+  srcX = 0;
+  srcY = 0;
+  srcZ = 0;
+  for (int j=0;j<10;j++)
+  {
+    srcPoles[j] = 0;
+  }
   return;
 };
 
@@ -81,12 +293,23 @@ OctCharges::~OctCharges()
 GEMDen::GEMDen()
 {
   //Generic constructor
+  chiralFlip_ = 0;
+  type_ = "None";
+  atom1_ = -1;
+  atom2_ = -1;
+  atom3_ = -1;
+  block_ = 0; //Empty block
   return;
 };
 
 GEMDen::GEMDen(string typ, string basName)
 {
   //Fancy constructor
+  chiralFlip_ = 0;
+  type_ = "None";
+  atom1_ = -1;
+  atom2_ = -1;
+  atom3_ = -1;
   setBasis(typ,basName);
   return;
 };
@@ -100,7 +323,7 @@ GEMDen::~GEMDen()
 void GEMDen::setBasis(string typ, string basName)
 {
   //Set the basis set
-  dens_ = HermBasis(typ,basName);
+  block_ = HermBasis(typ,basName);
   return;
 };
 
@@ -115,108 +338,43 @@ void GEMDen::setFrame(bool flip, string frame, int at1, int at2, int at3)
   return;
 };
 
+void GEMDen::getFrame(bool& flip, string& frame, int& at1, int& at2,
+                      int& at3)
+{
+  //Return the local frame of reference
+  flip = chiralFlip_;
+  frame = type_;
+  at1 = atom1_;
+  at2 = atom2_;
+  at3 = atom3_;
+  return;
+};
+
+vector<HermGau>& GEMDen::basis()
+{
+  //Return the density functions
+  //NB: The functions are shared with all atoms using the same basis
+  return hermBasisDB.block(block_);
+};
+
+int GEMDen::blockID()
+{
+  //Return the shared block in the basis set database
+  return block_;
+};
+
 MPole GEMDen::GEMDM()
 {
   //Function to convert GEM density to distributed multipoles
-  MPole dmpole; //Blank set of multipoles
+  //NB: The local frame multipoles only depend on the basis, so they are
+  //cached in the basis set database
+  MPole dmpole = hermBasisDB.blockPoles(block_); //Cached multipoles
   //Save frame of reference
   dmpole.chiralFlip = chiralFlip_;
   dmpole.type = type_;
   dmpole.atom1 = atom1_;
   dmpole.atom2 = atom2_;
   dmpole.atom3 = atom3_;
-  //Initialize multipoles
-  dmpole.q = 0;
-  dmpole.Dx = 0;
-  dmpole.Dy = 0;
-  dmpole.Dz = 0;
-  dmpole.IDx = 0;
-  dmpole.IDy = 0;
-  dmpole.IDz = 0;
-  dmpole.Qxx = 0;
-  dmpole.Qxy = 0;
-  dmpole.Qxz = 0;
-  dmpole.Qyy = 0;
-  dmpole.Qxz = 0;
-  dmpole.Qzz = 0;
-  //Add the nuclear charge from the periodic table
-  dmpole.q += chemTable.revTyping(type_);
-  //Convert Hermite Gaussians to multipoles
-  for (unsigned int i=0;i<dens_.size();i++)
-  {
-    //Check for a monopole
-    if ((dens_[i].xPow() == 0) and (dens_[i].yPow() == 0) and
-       (dens_[i].zPow() == 0))
-    {
-      //Update monopole
-      dmpole.q += dens_[i].coeff();
-      //Update diagonal quadrupole moments
-      dmpole.Qxx += dens_[i].coeff()/(2*dens_[i].getAlpha());
-      dmpole.Qyy += dens_[i].coeff()/(2*dens_[i].getAlpha());
-      dmpole.Qzz += dens_[i].coeff()/(2*dens_[i].getAlpha());
-    }
-    //Check for a dipole
-    if ((dens_[i].xPow() == 1) and (dens_[i].yPow() == 0) and
-       (dens_[i].zPow() == 0))
-    {
-      //Update x dipole
-      dmpole.Dx += dens_[i].coeff();
-    }
-    if ((dens_[i].xPow() == 0) and (dens_[i].yPow() == 1) and
-       (dens_[i].zPow() == 0))
-    {
-      //Update y dipole
-      dmpole.Dy += dens_[i].coeff();
-    }
-    if ((dens_[i].xPow() == 0) and (dens_[i].yPow() == 0) and
-       (dens_[i].zPow() == 1))
-    {
-      //Update z dipole
-      dmpole.Dz += dens_[i].coeff();
-    }
-    //Check for a quadrupole
-    if ((dens_[i].xPow() == 2) and (dens_[i].yPow() == 0) and
-       (dens_[i].zPow() == 0))
-    {
-      //Update xx quadrupole
-      dmpole.Qxx += 2*dens_[i].coeff();
-    }
-    if ((dens_[i].xPow() == 1) and (dens_[i].yPow() == 1) and
-       (dens_[i].zPow() == 0))
-    {
-      //Update xy quadrupole
-      dmpole.Qxy += dens_[i].coeff();
-    }
-    if ((dens_[i].xPow() == 1) and (dens_[i].yPow() == 0) and
-       (dens_[i].zPow() == 1))
-    {
-      //Update xz quadrupole
-      dmpole.Qxz += dens_[i].coeff();
-    }
-    if ((dens_[i].xPow() == 0) and (dens_[i].yPow() == 2) and
-       (dens_[i].zPow() == 0))
-    {
-      //Update xx quadrupole
-      dmpole.Qyy += 2*dens_[i].coeff();
-    }
-    if ((dens_[i].xPow() == 0) and (dens_[i].yPow() == 1) and
-       (dens_[i].zPow() == 1))
-    {
-      //Update yz quadrupole
-      dmpole.Qyz += dens_[i].coeff();
-    }
-    if ((dens_[i].xPow() == 0) and (dens_[i].yPow() == 0) and
-       (dens_[i].zPow() == 2))
-    {
-      //Update yz quadrupole
-      dmpole.Qzz += 2*dens_[i].coeff();
-    }
-  }
-  //Convert to a traceless quadrupole
-  double qTrace = dmpole.Qxx+dmpole.Qyy+dmpole.Qzz;
-  dmpole.Qxx -= qTrace;
-  dmpole.Qyy -= qTrace;
-  dmpole.Qzz -= qTrace;
   //Return GEM multipole
   return dmpole;
 };
@@ -240,6 +398,11 @@ QMMMSettings::QMMMSettings()
   //QM wrapper settings
   func = "N/A";
   basis = "N/A";
+  GEMBasis = "N/A";
+  GEMBasisFile = "GEM_basis.dat";
+  GEMCube = 0;
+  GEMDebug = 0;
+  GEMDisp = 0;
   RAM = 256;
   memMB = 1;
   charge = 0;
@@ -250,6 +413,7 @@ QMMMSettings::QMMMSettings()
   useLREC = 0;
   LRECCut = 1000.0; //Effectively infinite
   LRECPow = 3;
+  embedTol = 0; //Compression is off
   //MM wrapper settings
   useMMCut = 0;
   MMOptCut = 1000.0; //Effectively infinite
@@ -272,14 +436,24 @@ QMMMSettings::QMMMSettings()
   QMOptTol = 5e-4;
   stepScale = 1.0;
   maxStep = 0.1;
+  BFGSHist = 10;
+  convMetric = "Matrix";
+  convCut = 6.0;
+  microIter = 0;
+  microDisp = 0.05;
   //Additional RP settings
   kSpring = 1.0;
   TSBead = 0;
   climb = 0;
+  maxBeads = 0; //Set by the error checker
   frznEnds = 0;
   NEBFreq = 0;
   printNormModes = 0;
   startPathChk = 1; //Speeds up reaction pathways
+  //Frequency settings
+  FDHess = 0;
+  FDStep = 0.005;
+  FDJobs = 1;
   //Temporary energy storage
   EOld = 0.0;
   EReact = 0.0;
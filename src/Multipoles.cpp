@@ -21,9 +21,234 @@
 */
 
 //TINKER routines
+void ReadTINKpoleFile(string fileName, vector<int>& poleTyp,
+                      vector<int>& poleZ, vector<int>& poleX,
+                      vector<int>& poleY, vector<MPole>& poleVals)
+{
+  //Collects the multipole definitions from a TINKER key or parameter file
+  fstream inFile; //Generic file stream
+  string dummy; //Generic string
+  inFile.open(fileName.c_str(),ios_base::in);
+  while ((!inFile.eof()) and inFile.good())
+  {
+    getline(inFile,dummy);
+    stringstream fullLine(dummy);
+    fullLine >> dummy;
+    LICHEMLowerText(dummy);
+    if (dummy == "multipole")
+    {
+      //Read the type, the frame and the charge
+      //NB: Missing frame atoms are not written in the parameter files
+      vector<string> fields; //Remaining fields on the line
+      while (fullLine >> dummy)
+      {
+        fields.push_back(dummy);
+      }
+      if ((fields.size() < 2) or (fields.size() > 5))
+      {
+        //Skip broken definitions
+        continue;
+      }
+      int frame[4] = {0,0,0,0}; //Type and frame definition
+      for (unsigned int j=0;j<(fields.size()-1);j++)
+      {
+        frame[j] = atoi(fields[j].c_str());
+      }
+      MPole pole; //New multipole
+      pole.q = atof(fields[fields.size()-1].c_str());
+      //Read the dipole and quadrupole
+      inFile >> pole.Dx >> pole.Dy >> pole.Dz;
+      inFile >> pole.Qxx;
+      inFile >> pole.Qxy >> pole.Qyy;
+      inFile >> pole.Qxz >> pole.Qyz >> pole.Qzz;
+      pole.IDx = 0;
+      pole.IDy = 0;
+      pole.IDz = 0;
+      //Save the definition
+      poleTyp.push_back(frame[0]);
+      poleZ.push_back(frame[1]);
+      poleX.push_back(frame[2]);
+      poleY.push_back(frame[3]);
+      poleVals.push_back(pole);
+    }
+  }
+  inFile.close();
+  return;
+};
+
 void ExtractTINKpoles(vector<QMMMAtom>& QMMMData, int bead)
 {
   //Parses TINKER parameter files to find multipoles and local frames
+  //NB: The parameters only depend on the atom types, so they are read once
+  //and copied to all of the beads
+  vector<int> poleTyp; //Atom type (or negative atom ID) of each definition
+  vector<int> poleZ; //Z-axis type of each definition
+  vector<int> poleX; //X-axis type of each definition
+  vector<int> poleY; //Y-axis type of each definition
+  vector<MPole> poleVals; //Multipoles of each definition
+  //Read the key file first so that its definitions take priority
+  ReadTINKpoleFile("tinker.key",poleTyp,poleZ,poleX,poleY,poleVals);
+  ReadTINKpoleFile(FindTINKERParams(),poleTyp,poleZ,poleX,poleY,poleVals);
+  //Make a table of the definitions for each type
+  map<int,vector<int> > typePoles; //Definitions by type
+  for (unsigned int j=0;j<poleTyp.size();j++)
+  {
+    typePoles[poleTyp[j]].push_back(j);
+  }
+  //Assign multipoles and frames to the atoms
+  bool allFound = 1; //Flag for missing parameters
+  for (int i=0;i<Natoms;i++)
+  {
+    MPole& pole = QMMMData[i].MP[bead];
+    int def = -1; //Matching definition
+    int kz = -1; //Z-axis atom
+    int kx = -1; //X-axis atom
+    int ky = -1; //Y-axis atom
+    //Check for definitions of specific atoms
+    //NB: These frames use atom IDs instead of types
+    map<int,vector<int> >::iterator atomDefs;
+    atomDefs = typePoles.find(-1*(QMMMData[i].id+1));
+    if (atomDefs != typePoles.end())
+    {
+      def = atomDefs->second[0];
+      kz = abs(poleZ[def])-1;
+      kx = abs(poleX[def])-1;
+      ky = abs(poleY[def])-1;
+    }
+    //Find the 1-3 connected atoms
+    vector<int> bonds13; //Atoms two bonds away
+    if (def < 0)
+    {
+      bonds13.assign(topoTab.list13.begin()+topoTab.start13[i],
+                     topoTab.list13.begin()+topoTab.start13[i+1]);
+    }
+    //Match the frame atoms by type
+    //NB: The x and y axes are first taken from 1-2 connected atoms and
+    //then from 1-3 connected atoms
+    vector<int>& typeDefs = typePoles[QMMMData[i].numTyp];
+    vector<int>& bonds12 = QMMMData[i].bonds;
+    for (int pass=0;(pass<2) and (def < 0);pass++)
+    {
+      vector<int>& bondsXY = (pass == 0) ? bonds12 : bonds13;
+      for (unsigned int j=0;(j<typeDefs.size()) and (def < 0);j++)
+      {
+        int ztyp = abs(poleZ[typeDefs[j]]);
+        int xtyp = abs(poleX[typeDefs[j]]);
+        int ytyp = abs(poleY[typeDefs[j]]);
+        if (ztyp == 0)
+        {
+          //No local frame
+          def = typeDefs[j];
+          continue;
+        }
+        for (unsigned int k=0;(k<bonds12.size()) and (def < 0);k++)
+        {
+          int atZ = bonds12[k];
+          if (QMMMData[atZ].numTyp != ztyp)
+          {
+            continue;
+          }
+          if (xtyp == 0)
+          {
+            //Only the z axis is defined
+            def = typeDefs[j];
+            kz = atZ;
+            continue;
+          }
+          for (unsigned int l=0;(l<bondsXY.size()) and (def < 0);l++)
+          {
+            int atX = bondsXY[l];
+            if ((atX == atZ) or (QMMMData[atX].numTyp != xtyp))
+            {
+              continue;
+            }
+            if (ytyp == 0)
+            {
+              def = typeDefs[j];
+              kz = atZ;
+              kx = atX;
+              continue;
+            }
+            for (unsigned int m=0;(m<bondsXY.size()) and (def < 0);m++)
+            {
+              int atY = bondsXY[m];
+              if ((atY != atZ) and (atY != atX) and
+                 (QMMMData[atY].numTyp == ytyp))
+              {
+                def = typeDefs[j];
+                kz = atZ;
+                kx = atX;
+                ky = atY;
+              }
+            }
+          }
+        }
+      }
+    }
+    if (def < 0)
+    {
+      //Missing parameters
+      allFound = 0;
+      break;
+    }
+    //Save the multipole
+    pole = poleVals[def];
+    pole.atom1 = kz;
+    pole.atom2 = kx;
+    pole.atom3 = ky;
+    //Set the frame type from the signs of the definition
+    int ztyp = poleZ[def];
+    int xtyp = poleX[def];
+    int ytyp = poleY[def];
+    pole.type = "Z-then-X";
+    if (ztyp == 0)
+    {
+      pole.type = "None";
+    }
+    if ((ztyp != 0) and (xtyp == 0))
+    {
+      pole.type = "Z-Only";
+    }
+    if ((ztyp < 0) or (xtyp < 0))
+    {
+      pole.type = "Bisector";
+    }
+    if ((xtyp < 0) and (ytyp < 0))
+    {
+      pole.type = "Z-Bisect";
+    }
+    if ((ztyp < 0) and (xtyp < 0) and (ytyp < 0))
+    {
+      pole.type = "3-Fold";
+    }
+  }
+  if (!allFound)
+  {
+    //Let TINKER assign the frames
+    cout << "Warning: Multipole frames could not be assigned from the";
+    cout << " parameters." << '\n';
+    cout << " Using poledit for the multipoles." << '\n';
+    cout << '\n';
+    cout.flush();
+    PoleditTINKpoles(QMMMData,bead);
+  }
+  //Copy the multipoles to the other beads
+  for (int i=0;i<Natoms;i++)
+  {
+    for (unsigned int j=0;j<QMMMData[i].MP.size();j++)
+    {
+      if (((int)j) != bead)
+      {
+        QMMMData[i].MP[j] = QMMMData[i].MP[bead];
+      }
+    }
+  }
+  return;
+};
+
+void PoleditTINKpoles(vector<QMMMAtom>& QMMMData, int bead)
+{
+  //Runs poledit to find multipoles and local frames
   string dummy; //Generic string
   fstream inFile,outFile; //Generic file streams
   stringstream call; //Stream for system calls and reading/writing files
@@ -165,322 +390,429 @@ void ExtractTINKpoles(vector<QMMMAtom>& QMMMData, int bead)
   return;
 };
 
-void RotateTINKCharges(vector<QMMMAtom>& QMMMData, int bead)
+void BuildMPFrames(vector<QMMMAtom>& QMMMData)
 {
-  //Switches from the local frame of reference to the global frame
-  //of reference
-  #pragma omp parallel for schedule(dynamic) num_threads(Ncpus)
-  for (int i=0;i<Natoms;i++)
+  //Sorts the multipole local frames by type so that the rotations can be
+  //done in branch-free blocks
+  //NB: Frames are only sorted within tiles of atoms, which keeps the
+  //memory access close to the order of the atoms
+  const int tileSize = 4*mpBlock; //Number of atoms in a tile
+  mpFrames.Nframes = 0;
+  mpFrames.Nblocks = 0;
+  mpFrames.blockTyp.clear();
+  mpFrames.blockStart.clear();
+  mpFrames.atom0.clear();
+  mpFrames.atom1.clear();
+  mpFrames.atom2.clear();
+  mpFrames.atom3.clear();
+  for (int tile=0;tile<Natoms;tile+=tileSize)
   {
-    Vector3d vecX,vecY,vecZ; //Local frame vectors
-    //Initialize vectors in the global frame
-    vecX(0) = 1;
-    vecX(1) = 0;
-    vecX(2) = 0;
-    vecY(0) = 0;
-    vecY(1) = 1;
-    vecY(2) = 0;
-    vecZ(0) = 0;
-    vecZ(1) = 0;
-    vecZ(2) = 1;
-    //Rotate the charges
-    if (QMMMData[i].MMRegion)
+    vector<vector<int> > typeAtoms; //Atoms for each frame type
+    typeAtoms.resize(NFrameTypes);
+    for (int i=tile;i<min(tile+tileSize,Natoms);i++)
     {
-      //Find current orientation
-      double x,y,z;
-      if (QMMMData[i].MP[bead].type == "Bisector")
+      //Classify the frame once instead of on every rotation
+      //NB: Unknown types are left in the global frame
+      int frameTyp = FrameNone;
+      string type = QMMMData[i].MP[0].type;
+      if (type == "Bisector")
       {
-        //Find z vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].z;
-        vecZ(0) = -1*x; //Correct the direction
-        vecZ(1) = -1*y; //Correct the direction
-        vecZ(2) = -1*z; //Correct the direction
-        vecZ.normalize();
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].z;
-        vecX(0) = -1*x; //Correct the direction
-        vecX(1) = -1*y; //Correct the direction
-        vecX(2) = -1*z; //Correct the direction
-        vecX.normalize();
-        //Fill in z vector
-        vecZ += vecX;
-        vecZ.normalize();
-        //Find x vector by subtracting overlap
-        vecX -= vecZ*(vecX.dot(vecZ));
-        vecX.normalize();
+        frameTyp = FrameBisector;
       }
-      if (QMMMData[i].MP[bead].type == "Z-then-X")
+      if (type == "Z-then-X")
       {
-        //Find z vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].z;
-        vecZ(0) = -1*x; //Correct the direction
-        vecZ(1) = -1*y; //Correct the direction
-        vecZ(2) = -1*z; //Correct the direction
-        vecZ.normalize();
-        //Find x vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].z;
-        vecX(0) = -1*x; //Correct the direction
-        vecX(1) = -1*y; //Correct the direction
-        vecX(2) = -1*z; //Correct the direction
-        vecX.normalize();
-        //Subtract overlap and normalize
-        vecX -= vecZ*(vecX.dot(vecZ));
-        vecX.normalize();
+        frameTyp = FrameZThenX;
       }
-      if (QMMMData[i].MP[bead].type == "Z-Bisect")
+      if (type == "Z-Bisect")
       {
-        //Find first vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].z;
-        vecZ(0) = -1*x; //Correct the direction
-        vecZ(1) = -1*y; //Correct the direction
-        vecZ(2) = -1*z; //Correct the direction
-        vecZ.normalize();
-        //Find second vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].z;
-        vecX(0) = -1*x; //Correct the direction
-        vecX(1) = -1*y; //Correct the direction
-        vecX(2) = -1*z; //Correct the direction
-        vecX.normalize();
-        //Find third vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom3].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom3].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom3].P[bead].z;
-        vecY(0) = -1*x; //Correct the direction
-        vecY(1) = -1*y; //Correct the direction
-        vecY(2) = -1*z; //Correct the direction
-        vecY.normalize();
-        //Combine vectors
-        vecX += vecY;
-        vecX.normalize();
-        //Subtract overlap and normalize
-        vecX -= vecZ*(vecX.dot(vecZ));
-        vecX.normalize();
+        frameTyp = FrameZBisect;
       }
-      if (QMMMData[i].MP[bead].type == "3-Fold")
+      if (type == "3-Fold")
       {
-        //First vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].z;
-        vecZ(0) = -1*x; //Correct the direction
-        vecZ(1) = -1*y; //Correct the direction
-        vecZ(2) = -1*z; //Correct the direction
-        vecZ.normalize();
-        //Second vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].z;
-        vecX(0) = -1*x; //Correct the direction
-        vecX(1) = -1*y; //Correct the direction
-        vecX(2) = -1*z; //Correct the direction
-        vecX.normalize();
-        //Third vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom3].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom3].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom3].P[bead].z;
-        vecY(0) = -1*x; //Correct the direction
-        vecY(1) = -1*y; //Correct the direction
-        vecY(2) = -1*z; //Correct the direction
-        vecY.normalize();
-        //Combine vectors and normalize
-        vecZ += vecX+vecY;
-        vecZ.normalize();
-        //Find second axis by subtracting overlap and normalizing
-        vecX -= vecZ*(vecX.dot(vecZ));
-        vecX.normalize();
+        frameTyp = Frame3Fold;
       }
-      if (QMMMData[i].MP[bead].type == "Z-Only")
+      if (type == "Z-Only")
       {
-        //Primary vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].z;
-        vecZ(0) = -1*x; //Correct the direction
-        vecZ(1) = -1*y; //Correct the direction
-        vecZ(2) = -1*z; //Correct the direction
-        vecZ.normalize();
-        //Use a global axis for the second vector
-        vecX(0) = 1.0;
-        vecX(1) = 0.0;
-        vecX(2) = 0.0;
-        if (vecZ.dot(vecX) > 0.85)
+        frameTyp = FrameZOnly;
+      }
+      typeAtoms[frameTyp].push_back(i);
+    }
+    //Save the frames in blocks
+    for (int t=0;t<NFrameTypes;t++)
+    {
+      for (unsigned int j=0;j<typeAtoms[t].size();j++)
+      {
+        if ((j%mpBlock) == 0)
         {
-          //Switch to y axis if overlap is large
-          vecX(0) = 0.0;
-          vecX(1) = 1.0;
+          //Start a new block
+          mpFrames.blockTyp.push_back(t);
+          mpFrames.blockStart.push_back(mpFrames.Nframes);
+          mpFrames.Nblocks += 1;
         }
-        //Subtract overlap and normalize
-        vecX -= vecZ*(vecX.dot(vecZ));
-        vecX.normalize();
+        int i = typeAtoms[t][j];
+        mpFrames.atom0.push_back(i);
+        mpFrames.atom1.push_back(QMMMData[i].MP[0].atom1);
+        mpFrames.atom2.push_back(QMMMData[i].MP[0].atom2);
+        mpFrames.atom3.push_back(QMMMData[i].MP[0].atom3);
+        mpFrames.Nframes += 1;
+      }
+    }
+  }
+  mpFrames.blockStart.push_back(mpFrames.Nframes);
+  return;
+};
+
+void RotateTINKPoles(vector<QMMMAtom>& QMMMData, vector<MPole>& globPoles,
+                     int bead)
+{
+  //Rotates the multipoles from the local frames to the global frame
+  //NB: Each block has a single frame type, so the inner loops have no
+  //branches and can be vectorized
+  globPoles.resize(Natoms);
+  #pragma omp parallel for schedule(dynamic) num_threads(Ncpus)
+  for (int b=0;b<mpFrames.Nblocks;b++)
+  {
+    int t = mpFrames.blockTyp[b]; //Frame type
+    int s = mpFrames.blockStart[b]; //First entry in the table
+    int n = mpFrames.blockStart[b+1]-s; //Number of atoms in the block
+    double r1[3][mpBlock]; //Displacements to the z axis atoms
+    double r2[3][mpBlock]; //Displacements to the x axis atoms
+    double r3[3][mpBlock]; //Displacements to the y axis atoms
+    double vecX[3][mpBlock]; //Local x axes
+    double vecY[3][mpBlock]; //Local y axes
+    double vecZ[3][mpBlock]; //Local z axes
+    double dip[3][mpBlock]; //Dipoles (x,y,z)
+    double quad[6][mpBlock]; //Quadrupoles (xx,xy,xz,yy,yz,zz)
+    //Gather the positions and local frame multipoles
+    for (int k=0;k<n;k++)
+    {
+      int i = mpFrames.atom0[s+k];
+      Coord& pos = QMMMData[i].P[bead];
+      if (t != FrameNone)
+      {
+        Coord& pos1 = QMMMData[mpFrames.atom1[s+k]].P[bead];
+        r1[0][k] = pos.x-pos1.x;
+        r1[1][k] = pos.y-pos1.y;
+        r1[2][k] = pos.z-pos1.z;
+      }
+      if ((t != FrameNone) and (t != FrameZOnly))
+      {
+        Coord& pos2 = QMMMData[mpFrames.atom2[s+k]].P[bead];
+        r2[0][k] = pos.x-pos2.x;
+        r2[1][k] = pos.y-pos2.y;
+        r2[2][k] = pos.z-pos2.z;
+      }
+      if ((t == FrameZBisect) or (t == Frame3Fold))
+      {
+        Coord& pos3 = QMMMData[mpFrames.atom3[s+k]].P[bead];
+        r3[0][k] = pos.x-pos3.x;
+        r3[1][k] = pos.y-pos3.y;
+        r3[2][k] = pos.z-pos3.z;
       }
-      if (QMMMData[i].MP[bead].type == "None")
+      MPole& pole = QMMMData[i].MP[bead];
+      dip[0][k] = pole.Dx;
+      dip[1][k] = pole.Dy;
+      dip[2][k] = pole.Dz;
+      quad[0][k] = pole.Qxx;
+      quad[1][k] = pole.Qxy;
+      quad[2][k] = pole.Qxz;
+      quad[3][k] = pole.Qyy;
+      quad[4][k] = pole.Qyz;
+      quad[5][k] = pole.Qzz;
+    }
+    //Find the z axis and a trial x axis
+    if (t == FrameNone)
+    {
+      //Keep the global frame
+      #pragma omp simd
+      for (int k=0;k<n;k++)
       {
-        QMMMData[i].PC[bead].q1 = 0;
-        QMMMData[i].PC[bead].q2 = 0;
-        QMMMData[i].PC[bead].q3 = 0;
-        QMMMData[i].PC[bead].q4 = 0;
-        QMMMData[i].PC[bead].q5 = 0;
-        QMMMData[i].PC[bead].q6 = 0;
+        vecX[0][k] = 1;
+        vecX[1][k] = 0;
+        vecX[2][k] = 0;
+        vecZ[0][k] = 0;
+        vecZ[1][k] = 0;
+        vecZ[2][k] = 1;
+      }
+    }
+    else
+    {
+      #pragma omp simd
+      for (int k=0;k<n;k++)
+      {
+        //Point the z axis at the first atom
+        double norm = sqrt(r1[0][k]*r1[0][k]+r1[1][k]*r1[1][k]
+                      +r1[2][k]*r1[2][k]);
+        vecZ[0][k] = -1*r1[0][k]/norm;
+        vecZ[1][k] = -1*r1[1][k]/norm;
+        vecZ[2][k] = -1*r1[2][k]/norm;
+      }
+    }
+    if ((t != FrameNone) and (t != FrameZOnly))
+    {
+      #pragma omp simd
+      for (int k=0;k<n;k++)
+      {
+        //Point the x axis at the second atom
+        double norm = sqrt(r2[0][k]*r2[0][k]+r2[1][k]*r2[1][k]
+                      +r2[2][k]*r2[2][k]);
+        vecX[0][k] = -1*r2[0][k]/norm;
+        vecX[1][k] = -1*r2[1][k]/norm;
+        vecX[2][k] = -1*r2[2][k]/norm;
+      }
+    }
+    if ((t == FrameZBisect) or (t == Frame3Fold))
+    {
+      #pragma omp simd
+      for (int k=0;k<n;k++)
+      {
+        //Point the y axis at the third atom
+        double norm = sqrt(r3[0][k]*r3[0][k]+r3[1][k]*r3[1][k]
+                      +r3[2][k]*r3[2][k]);
+        vecY[0][k] = -1*r3[0][k]/norm;
+        vecY[1][k] = -1*r3[1][k]/norm;
+        vecY[2][k] = -1*r3[2][k]/norm;
+      }
+    }
+    if (t == FrameBisector)
+    {
+      #pragma omp simd
+      for (int k=0;k<n;k++)
+      {
+        //Bisect the two bonds
+        vecZ[0][k] += vecX[0][k];
+        vecZ[1][k] += vecX[1][k];
+        vecZ[2][k] += vecX[2][k];
+        double norm = sqrt(vecZ[0][k]*vecZ[0][k]+vecZ[1][k]*vecZ[1][k]
+                      +vecZ[2][k]*vecZ[2][k]);
+        vecZ[0][k] /= norm;
+        vecZ[1][k] /= norm;
+        vecZ[2][k] /= norm;
+      }
+    }
+    if (t == FrameZBisect)
+    {
+      #pragma omp simd
+      for (int k=0;k<n;k++)
+      {
+        //Bisect the second and third bonds
+        vecX[0][k] += vecY[0][k];
+        vecX[1][k] += vecY[1][k];
+        vecX[2][k] += vecY[2][k];
+        double norm = sqrt(vecX[0][k]*vecX[0][k]+vecX[1][k]*vecX[1][k]
+                      +vecX[2][k]*vecX[2][k]);
+        vecX[0][k] /= norm;
+        vecX[1][k] /= norm;
+        vecX[2][k] /= norm;
+      }
+    }
+    if (t == Frame3Fold)
+    {
+      #pragma omp simd
+      for (int k=0;k<n;k++)
+      {
+        //Combine all three bonds
+        vecZ[0][k] += vecX[0][k]+vecY[0][k];
+        vecZ[1][k] += vecX[1][k]+vecY[1][k];
+        vecZ[2][k] += vecX[2][k]+vecY[2][k];
+        double norm = sqrt(vecZ[0][k]*vecZ[0][k]+vecZ[1][k]*vecZ[1][k]
+                      +vecZ[2][k]*vecZ[2][k]);
+        vecZ[0][k] /= norm;
+        vecZ[1][k] /= norm;
+        vecZ[2][k] /= norm;
+      }
+    }
+    if (t == FrameZOnly)
+    {
+      #pragma omp simd
+      for (int k=0;k<n;k++)
+      {
+        //Use a global axis for the second vector
+        //NB: Switch to the y axis if the overlap is large
+        double swapAxis = (vecZ[0][k] > 0.85) ? 1.0 : 0.0;
+        vecX[0][k] = 1.0-swapAxis;
+        vecX[1][k] = swapAxis;
+        vecX[2][k] = 0.0;
       }
-      //Fill in y vector
-      vecY = vecX.cross(vecZ);
-      vecY.normalize();
-      //Rotate to the global frame
-      MPole newPoles;
-      //Add monopoles
-      newPoles.q = QMMMData[i].MP[bead].q;
-      //Rotate dipoles
-      newPoles.Dx = 0; //X component
-      newPoles.Dx += QMMMData[i].MP[bead].Dx*vecX(0);
-      newPoles.Dx += QMMMData[i].MP[bead].Dy*vecY(0);
-      newPoles.Dx += QMMMData[i].MP[bead].Dz*vecZ(0);
-      newPoles.Dy = 0; //Y component
-      newPoles.Dy += QMMMData[i].MP[bead].Dx*vecX(1);
-      newPoles.Dy += QMMMData[i].MP[bead].Dy*vecY(1);
-      newPoles.Dy += QMMMData[i].MP[bead].Dz*vecZ(1);
-      newPoles.Dz = 0; //Z component
-      newPoles.Dz += QMMMData[i].MP[bead].Dx*vecX(2);
-      newPoles.Dz += QMMMData[i].MP[bead].Dy*vecY(2);
-      newPoles.Dz += QMMMData[i].MP[bead].Dz*vecZ(2);
+    }
+    if (t != FrameNone)
+    {
+      #pragma omp simd
+      for (int k=0;k<n;k++)
+      {
+        //Subtract the overlap from the x axis and normalize
+        double ovLap = vecX[0][k]*vecZ[0][k]+vecX[1][k]*vecZ[1][k]
+                       +vecX[2][k]*vecZ[2][k];
+        vecX[0][k] -= vecZ[0][k]*ovLap;
+        vecX[1][k] -= vecZ[1][k]*ovLap;
+        vecX[2][k] -= vecZ[2][k]*ovLap;
+        double norm = sqrt(vecX[0][k]*vecX[0][k]+vecX[1][k]*vecX[1][k]
+                      +vecX[2][k]*vecX[2][k]);
+        vecX[0][k] /= norm;
+        vecX[1][k] /= norm;
+        vecX[2][k] /= norm;
+      }
+    }
+    #pragma omp simd
+    for (int k=0;k<n;k++)
+    {
+      //Fill in the y axis
+      vecY[0][k] = vecX[1][k]*vecZ[2][k]-vecX[2][k]*vecZ[1][k];
+      vecY[1][k] = vecX[2][k]*vecZ[0][k]-vecX[0][k]*vecZ[2][k];
+      vecY[2][k] = vecX[0][k]*vecZ[1][k]-vecX[1][k]*vecZ[0][k];
+      double norm = sqrt(vecY[0][k]*vecY[0][k]+vecY[1][k]*vecY[1][k]
+                    +vecY[2][k]*vecY[2][k]);
+      vecY[0][k] /= norm;
+      vecY[1][k] /= norm;
+      vecY[2][k] /= norm;
+    }
+    #pragma omp simd
+    for (int k=0;k<n;k++)
+    {
+      //Rotate the dipoles
+      double Dx = dip[0][k];
+      double Dy = dip[1][k];
+      double Dz = dip[2][k];
+      for (int a=0;a<3;a++)
+      {
+        dip[a][k] = Dx*vecX[a][k]+Dy*vecY[a][k]+Dz*vecZ[a][k];
+      }
+      //Rotate the quadrupoles (Q' = R.Q.R^T)
+      //NB: The columns of R are the local axes
+      double Qxx = quad[0][k];
+      double Qxy = quad[1][k];
+      double Qxz = quad[2][k];
+      double Qyy = quad[3][k];
+      double Qyz = quad[4][k];
+      double Qzz = quad[5][k];
+      double QR[3][3]; //Q.R^T
+      for (int a=0;a<3;a++)
+      {
+        QR[0][a] = Qxx*vecX[a][k]+Qxy*vecY[a][k]+Qxz*vecZ[a][k];
+        QR[1][a] = Qxy*vecX[a][k]+Qyy*vecY[a][k]+Qyz*vecZ[a][k];
+        QR[2][a] = Qxz*vecX[a][k]+Qyz*vecY[a][k]+Qzz*vecZ[a][k];
+      }
+      quad[0][k] = vecX[0][k]*QR[0][0]+vecY[0][k]*QR[1][0]
+                   +vecZ[0][k]*QR[2][0];
+      quad[1][k] = vecX[0][k]*QR[0][1]+vecY[0][k]*QR[1][1]
+                   +vecZ[0][k]*QR[2][1];
+      quad[2][k] = vecX[0][k]*QR[0][2]+vecY[0][k]*QR[1][2]
+                   +vecZ[0][k]*QR[2][2];
+      quad[3][k] = vecX[1][k]*QR[0][1]+vecY[1][k]*QR[1][1]
+                   +vecZ[1][k]*QR[2][1];
+      quad[4][k] = vecX[1][k]*QR[0][2]+vecY[1][k]*QR[1][2]
+                   +vecZ[1][k]*QR[2][2];
+      quad[5][k] = vecX[2][k]*QR[0][2]+vecY[2][k]*QR[1][2]
+                   +vecZ[2][k]*QR[2][2];
+    }
+    //Save the global frame multipoles
+    for (int k=0;k<n;k++)
+    {
+      int i = mpFrames.atom0[s+k];
+      MPole& pole = QMMMData[i].MP[bead];
+      MPole& newPoles = globPoles[i];
+      newPoles.q = pole.q;
       //Add induced dipoles (Already in global frame)
-      newPoles.Dx += QMMMData[i].MP[bead].IDx;
-      newPoles.Dy += QMMMData[i].MP[bead].IDy;
-      newPoles.Dz += QMMMData[i].MP[bead].IDz;
+      newPoles.Dx = dip[0][k]+pole.IDx;
+      newPoles.Dy = dip[1][k]+pole.IDy;
+      newPoles.Dz = dip[2][k]+pole.IDz;
       newPoles.IDx = 0;
       newPoles.IDy = 0;
       newPoles.IDz = 0;
-      //Rotate quadrupoles (This looks awful, but it works)
-      //NB: This is a hard coded matrix rotation
-      newPoles.Qxx = 0; //XX component
-      newPoles.Qxx += vecX(0)*vecX(0)*QMMMData[i].MP[bead].Qxx;
-      newPoles.Qxx += vecX(0)*vecY(0)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qxx += vecX(0)*vecZ(0)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qxx += vecY(0)*vecX(0)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qxx += vecY(0)*vecY(0)*QMMMData[i].MP[bead].Qyy;
-      newPoles.Qxx += vecY(0)*vecZ(0)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qxx += vecZ(0)*vecX(0)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qxx += vecZ(0)*vecY(0)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qxx += vecZ(0)*vecZ(0)*QMMMData[i].MP[bead].Qzz;
-      newPoles.Qxy = 0; //XY component
-      newPoles.Qxy += vecX(0)*vecX(1)*QMMMData[i].MP[bead].Qxx;
-      newPoles.Qxy += vecX(0)*vecY(1)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qxy += vecX(0)*vecZ(1)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qxy += vecY(0)*vecX(1)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qxy += vecY(0)*vecY(1)*QMMMData[i].MP[bead].Qyy;
-      newPoles.Qxy += vecY(0)*vecZ(1)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qxy += vecZ(0)*vecX(1)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qxy += vecZ(0)*vecY(1)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qxy += vecZ(0)*vecZ(1)*QMMMData[i].MP[bead].Qzz;
-      newPoles.Qxz = 0; //XZ component
-      newPoles.Qxz += vecX(0)*vecX(2)*QMMMData[i].MP[bead].Qxx;
-      newPoles.Qxz += vecX(0)*vecY(2)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qxz += vecX(0)*vecZ(2)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qxz += vecY(0)*vecX(2)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qxz += vecY(0)*vecY(2)*QMMMData[i].MP[bead].Qyy;
-      newPoles.Qxz += vecY(0)*vecZ(2)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qxz += vecZ(0)*vecX(2)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qxz += vecZ(0)*vecY(2)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qxz += vecZ(0)*vecZ(2)*QMMMData[i].MP[bead].Qzz;
-      newPoles.Qyy = 0; //YY component
-      newPoles.Qyy += vecX(1)*vecX(1)*QMMMData[i].MP[bead].Qxx;
-      newPoles.Qyy += vecX(1)*vecY(1)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qyy += vecX(1)*vecZ(1)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qyy += vecY(1)*vecX(1)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qyy += vecY(1)*vecY(1)*QMMMData[i].MP[bead].Qyy;
-      newPoles.Qyy += vecY(1)*vecZ(1)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qyy += vecZ(1)*vecX(1)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qyy += vecZ(1)*vecY(1)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qyy += vecZ(1)*vecZ(1)*QMMMData[i].MP[bead].Qzz;
-      newPoles.Qyz = 0; //YZ component
-      newPoles.Qyz += vecX(1)*vecX(2)*QMMMData[i].MP[bead].Qxx;
-      newPoles.Qyz += vecX(1)*vecY(2)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qyz += vecX(1)*vecZ(2)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qyz += vecY(1)*vecX(2)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qyz += vecY(1)*vecY(2)*QMMMData[i].MP[bead].Qyy;
-      newPoles.Qyz += vecY(1)*vecZ(2)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qyz += vecZ(1)*vecX(2)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qyz += vecZ(1)*vecY(2)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qyz += vecZ(1)*vecZ(2)*QMMMData[i].MP[bead].Qzz;
-      newPoles.Qzz = 0; //ZZ component
-      newPoles.Qzz += vecX(2)*vecX(2)*QMMMData[i].MP[bead].Qxx;
-      newPoles.Qzz += vecX(2)*vecY(2)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qzz += vecX(2)*vecZ(2)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qzz += vecY(2)*vecX(2)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qzz += vecY(2)*vecY(2)*QMMMData[i].MP[bead].Qyy;
-      newPoles.Qzz += vecY(2)*vecZ(2)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qzz += vecZ(2)*vecX(2)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qzz += vecZ(2)*vecY(2)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qzz += vecZ(2)*vecZ(2)*QMMMData[i].MP[bead].Qzz;
-      //switch to point-charges
-      QMMMData[i].PC[bead] = SphHarm2Charges(Cart2SphHarm(newPoles));
+      newPoles.Qxx = quad[0][k];
+      newPoles.Qxy = quad[1][k];
+      newPoles.Qxz = quad[2][k];
+      newPoles.Qyy = quad[3][k];
+      newPoles.Qyz = quad[4][k];
+      newPoles.Qzz = quad[5][k];
+    }
+  }
+  return;
+};
+
+void RotateTINKCharges(vector<QMMMAtom>& QMMMData, int bead)
+{
+  //Switches from the local frame of reference to the global frame
+  //of reference
+  vector<MPole> globPoles; //Multipoles in the global frame
+  RotateTINKPoles(QMMMData,globPoles,bead);
+  #pragma omp parallel for schedule(dynamic) num_threads(Ncpus)
+  for (int i=0;i<Natoms;i++)
+  {
+    //Convert the charges
+    if (QMMMData[i].MMRegion)
+    {
+      OctCharges& PCGrid = QMMMData[i].PC[bead];
+      MPole& newPoles = globPoles[i];
+      double poles[10]; //Global frame multipoles
+      poles[0] = newPoles.q;
+      poles[1] = newPoles.Dx;
+      poles[2] = newPoles.Dy;
+      poles[3] = newPoles.Dz;
+      poles[4] = newPoles.Qxx;
+      poles[5] = newPoles.Qxy;
+      poles[6] = newPoles.Qxz;
+      poles[7] = newPoles.Qyy;
+      poles[8] = newPoles.Qyz;
+      poles[9] = newPoles.Qzz;
+      //Check if the saved grid can be reused
+      bool newGrid = !PCGrid.gridSet;
+      for (int j=0;j<10;j++)
+      {
+        if (abs(poles[j]-PCGrid.srcPoles[j]) > mpGridTol)
+        {
+          newGrid = 1;
+        }
+      }
+      //Find the displacement of the grid
+      double dx = QMMMData[i].P[bead].x;
+      double dy = QMMMData[i].P[bead].y;
+      double dz = QMMMData[i].P[bead].z;
+      if (newGrid)
+      {
+        //switch to point-charges
+        PCGrid = SphHarm2Charges(Cart2SphHarm(newPoles));
+        PCGrid.gridSet = 1;
+        for (int j=0;j<10;j++)
+        {
+          PCGrid.srcPoles[j] = poles[j];
+        }
+      }
+      else
+      {
+        //Only move the old grid
+        dx -= PCGrid.srcX;
+        dy -= PCGrid.srcY;
+        dz -= PCGrid.srcZ;
+      }
+      PCGrid.srcX = QMMMData[i].P[bead].x;
+      PCGrid.srcY = QMMMData[i].P[bead].y;
+      PCGrid.srcZ = QMMMData[i].P[bead].z;
       //Translate charges to the atom's location in the global frame
-      QMMMData[i].PC[bead].x1 += QMMMData[i].P[bead].x;
-      QMMMData[i].PC[bead].y1 += QMMMData[i].P[bead].y;
-      QMMMData[i].PC[bead].z1 += QMMMData[i].P[bead].z;
-      QMMMData[i].PC[bead].x2 += QMMMData[i].P[bead].x;
-      QMMMData[i].PC[bead].y2 += QMMMData[i].P[bead].y;
-      QMMMData[i].PC[bead].z2 += QMMMData[i].P[bead].z;
-      QMMMData[i].PC[bead].x3 += QMMMData[i].P[bead].x;
-      QMMMData[i].PC[bead].y3 += QMMMData[i].P[bead].y;
-      QMMMData[i].PC[bead].z3 += QMMMData[i].P[bead].z;
-      QMMMData[i].PC[bead].x4 += QMMMData[i].P[bead].x;
-      QMMMData[i].PC[bead].y4 += QMMMData[i].P[bead].y;
-      QMMMData[i].PC[bead].z4 += QMMMData[i].P[bead].z;
-      QMMMData[i].PC[bead].x5 += QMMMData[i].P[bead].x;
-      QMMMData[i].PC[bead].y5 += QMMMData[i].P[bead].y;
-      QMMMData[i].PC[bead].z5 += QMMMData[i].P[bead].z;
-      QMMMData[i].PC[bead].x6 += QMMMData[i].P[bead].x;
-      QMMMData[i].PC[bead].y6 += QMMMData[i].P[bead].y;
-      QMMMData[i].PC[bead].z6 += QMMMData[i].P[bead].z;
+      PCGrid.x1 += dx;
+      PCGrid.y1 += dy;
+      PCGrid.z1 += dz;
+      PCGrid.x2 += dx;
+      PCGrid.y2 += dy;
+      PCGrid.z2 += dz;
+      PCGrid.x3 += dx;
+      PCGrid.y3 += dy;
+      PCGrid.z3 += dz;
+      PCGrid.x4 += dx;
+      PCGrid.y4 += dy;
+      PCGrid.z4 += dz;
+      PCGrid.x5 += dx;
+      PCGrid.y5 += dy;
+      PCGrid.z5 += dz;
+      PCGrid.x6 += dx;
+      PCGrid.y6 += dy;
+      PCGrid.z6 += dz;
     }
     else
     {
       //Set other charges to zero
       //NB: This makes sure that variables are not undefined
+      QMMMData[i].PC[bead].gridSet = 0;
       QMMMData[i].PC[bead].q1 = 0;
       QMMMData[i].PC[bead].q2 = 0;
       QMMMData[i].PC[bead].q3 = 0;
@@ -562,25 +894,59 @@ void WriteTINKMPole(vector<QMMMAtom>& QMMMData, fstream& outFile, int i,
 };
 
 //General routines
-void WriteChargeFile(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
-                     int bead)
+void BuildMMField(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
+                  int bead, vector<double>& MMField)
 {
-  //Function to write a file for the MM charges
-  stringstream call; //Generic stream
-  fstream outFile; //Stream for the charge file
-  bool firstCharge = 1; //Always write the first charge
+  //Collects the MM point-charges for the QM calculations
+  //NB: The charges are packed as (x,y,z,q) in the QM distance units
+  MMField.clear();
+  if (!(CHRG or AMOEBA))
+  {
+    //No point-charges to add
+    return;
+  }
+  bool firstCharge = 1; //Never return an empty list
+  if (PSI4)
+  {
+    //NB: Only Gaussian and NWChem need a non-empty list
+    firstCharge = 0;
+  }
   //Check units
   double uConv = 1; //Units conversion constant
   if (QMMMOpts.unitsQM == "Bohr")
   {
     uConv = 1.0/bohrRad;
   }
+  //Check for multipole compression
+  bool useEmbed = 0; //Flag to compress distant AMOEBA multipoles
+  double embedTol = 0; //Tolerance for the potential (e/Ang)
+  if (AMOEBA and (QMMMOpts.embedTol > 0))
+  {
+    useEmbed = 1;
+    embedTol = QMMMOpts.embedTol/bohrRad;
+  }
   //Find the center of mass
   Coord QMCOM; //QM region center of mass
-  if (PBCon or QMMMOpts.useLREC)
+  double QMRad = 0; //Largest distance between the QM atoms and the COM
+  if (PBCon or QMMMOpts.useLREC or useEmbed)
   {
     QMCOM = FindQMCOM(QMMMData,QMMMOpts,bead);
   }
+  if (useEmbed)
+  {
+    for (int i=0;i<Natoms;i++)
+    {
+      if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+      {
+        Coord distCent = CoordDist2(QMMMData[i].P[bead],QMCOM);
+        double R = sqrt(distCent.vecMag());
+        if (R > QMRad)
+        {
+          QMRad = R;
+        }
+      }
+    }
+  }
   //Initialize charges
   if (AMOEBA)
   {
@@ -589,297 +955,246 @@ void WriteChargeFile(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
       //Set up current multipoles
       RotateTINKCharges(QMMMData,bead);
     }
+    MMField.reserve(24*Nmm);
   }
-  //Write charge file
-  if (Gaussian or NWChem)
+  else
   {
-    //Save file
-    call.str("");
-    call << "MMCharges_" << bead << ".txt";
-    outFile.open(call.str().c_str(),ios_base::out);
-    for (int i=0;i<Natoms;i++)
+    MMField.reserve(4*Nmm);
+  }
+  //Collect the charges
+  double LRECBox = QMMMOpts.LRECCut; //Half-width of the LREC screening box
+  int firstMM = -1; //Index of the first MM atom
+  int Nfull = 0; //Number of charges without compression
+  for (int i=0;i<Natoms;i++)
+  {
+    if (QMMMData[i].MMRegion)
     {
-      if (QMMMData[i].MMRegion)
+      if (firstMM < 0)
+      {
+        firstMM = i;
+      }
+      //Check PBC (minimum image convention)
+      Coord distCent; //Distance from QM COM
+      double xShft = 0;
+      double yShft = 0;
+      double zShft = 0;
+      if (PBCon or QMMMOpts.useLREC or useEmbed)
       {
-        //Check PBC (minimum image convention)
-        Coord distCent; //Distance from QM COM
-        double xShft = 0;
-        double yShft = 0;
-        double zShft = 0;
-        if (PBCon or QMMMOpts.useLREC)
+        //Initialize displacements
+        double dx,dy,dz; //Starting displacements
+        dx = QMMMData[i].P[bead].x-QMCOM.x;
+        dy = QMMMData[i].P[bead].y-QMCOM.y;
+        dz = QMMMData[i].P[bead].z-QMCOM.z;
+        distCent = CoordDist2(QMMMData[i].P[bead],QMCOM);
+        //Calculate the shift in positions
+        //NB: Generally this work out to be +/- {Lx,Ly,Lz}
+        if (PBCon)
         {
-          //Initialize displacements
-          double dx,dy,dz; //Starting displacements
-          dx = QMMMData[i].P[bead].x-QMCOM.x;
-          dy = QMMMData[i].P[bead].y-QMCOM.y;
-          dz = QMMMData[i].P[bead].z-QMCOM.z;
-          distCent = CoordDist2(QMMMData[i].P[bead],QMCOM);
-          //Calculate the shift in positions
-          //NB: Generally this work out to be +/- {Lx,Ly,Lz}
-          if (PBCon)
-          {
-            xShft = distCent.x-dx;
-            yShft = distCent.y-dy;
-            zShft = distCent.z-dz;
-          }
+          xShft = distCent.x-dx;
+          yShft = distCent.y-dy;
+          zShft = distCent.z-dz;
         }
-        //Check for long-range corrections
-        double scrq = 1;
-        if (QMMMOpts.useLREC)
+      }
+      //Check for long-range corrections
+      double scrq = 1;
+      if (QMMMOpts.useLREC)
+      {
+        //Skip sites outside of the box around the QM COM
+        if ((abs(distCent.x) > LRECBox) or (abs(distCent.y) > LRECBox) or
+           (abs(distCent.z) > LRECBox))
         {
-          //Use the long-range correction
-          scrq = LRECFunction(distCent,QMMMOpts);
+          continue;
         }
-        if ((scrq > 0) or firstCharge)
+        //Use the long-range correction
+        scrq = LRECFunction(distCent,QMMMOpts);
+      }
+      if (scrq > 0)
+      {
+        if (CHRG)
         {
-          if (CHRG)
+          //Add charges
+          MMField.push_back((QMMMData[i].P[bead].x+xShft)*uConv);
+          MMField.push_back((QMMMData[i].P[bead].y+yShft)*uConv);
+          MMField.push_back((QMMMData[i].P[bead].z+zShft)*uConv);
+          MMField.push_back(QMMMData[i].MP[bead].q*scrq);
+        }
+        if (AMOEBA)
+        {
+          //Add multipoles
+          OctCharges& PCGrid = QMMMData[i].PC[bead];
+          double gridX[6] = {PCGrid.x1,PCGrid.x2,PCGrid.x3,
+                             PCGrid.x4,PCGrid.x5,PCGrid.x6};
+          double gridY[6] = {PCGrid.y1,PCGrid.y2,PCGrid.y3,
+                             PCGrid.y4,PCGrid.y5,PCGrid.y6};
+          double gridZ[6] = {PCGrid.z1,PCGrid.z2,PCGrid.z3,
+                             PCGrid.z4,PCGrid.z5,PCGrid.z6};
+          double gridQ[6] = {PCGrid.q1,PCGrid.q2,PCGrid.q3,
+                             PCGrid.q4,PCGrid.q5,PCGrid.q6};
+          Nfull += 6;
+          if (useEmbed)
           {
-            //Add charges
-            firstCharge = 0; //Skips writing the remaining zeros
-            double tmpX,tmpY,tmpZ,tmpQ; //Temporary storage
-            tmpX = (QMMMData[i].P[bead].x+xShft)*uConv;
-            tmpY = (QMMMData[i].P[bead].y+yShft)*uConv;
-            tmpZ = (QMMMData[i].P[bead].z+zShft)*uConv;
-            tmpQ = QMMMData[i].MP[bead].q*scrq;
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpX,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpY,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpZ,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpQ,16);
-            outFile << '\n';
+            //Collect the moments of the octahedral charges
+            double x = QMMMData[i].P[bead].x;
+            double y = QMMMData[i].P[bead].y;
+            double z = QMMMData[i].P[bead].z;
+            double q = 0; //Monopole
+            double dip[3] = {0,0,0}; //Dipole
+            double quad[3][3] = {{0,0,0},{0,0,0},{0,0,0}}; //Traceless quad.
+            for (int j=0;j<6;j++)
+            {
+              double s[3] = {gridX[j]-x,gridY[j]-y,gridZ[j]-z};
+              double s2 = s[0]*s[0]+s[1]*s[1]+s[2]*s[2];
+              q += gridQ[j];
+              for (int k=0;k<3;k++)
+              {
+                dip[k] += gridQ[j]*s[k];
+                for (int l=0;l<3;l++)
+                {
+                  quad[k][l] += 1.5*gridQ[j]*s[k]*s[l];
+                }
+                quad[k][k] -= 0.5*gridQ[j]*s2;
+              }
+            }
+            double dipMag = 0; //Size of the dipole
+            double quadMag = 0; //Size of the quadrupole
+            for (int k=0;k<3;k++)
+            {
+              dipMag += dip[k]*dip[k];
+              for (int l=0;l<3;l++)
+              {
+                quadMag += quad[k][l]*quad[k][l];
+              }
+            }
+            dipMag = sqrt(dipMag);
+            quadMag = sqrt(quadMag);
+            //Estimate the error at the edge of the QM region
+            double R = sqrt(distCent.vecMag())-QMRad;
+            double pd = 0.25*bohrRad; //Displacement of the dipole charges
+            if (R > pd)
+            {
+              double R2 = R*R;
+              double R3 = R2*R;
+              if (((dipMag/R2)+(quadMag/R3)) <= embedTol)
+              {
+                //Far-field: Replace the multipole with a monopole
+                MMField.push_back((x+xShft)*uConv);
+                MMField.push_back((y+yShft)*uConv);
+                MMField.push_back((z+zShft)*uConv);
+                MMField.push_back(q*scrq);
+                continue;
+              }
+              if (((quadMag+abs(q)*pd*pd)/R3) <= embedTol)
+              {
+                //Mid-field: Replace the multipole with two charges
+                //NB: The pair keeps the monopole and dipole exactly
+                double ux = 0;
+                double uy = 0;
+                double uz = 1;
+                if (dipMag > 0)
+                {
+                  ux = dip[0]/dipMag;
+                  uy = dip[1]/dipMag;
+                  uz = dip[2]/dipMag;
+                }
+                double qp = 0.5*(q+(dipMag/pd)); //Charge along the dipole
+                double qn = 0.5*(q-(dipMag/pd)); //Charge against the dipole
+                MMField.push_back((x+pd*ux+xShft)*uConv);
+                MMField.push_back((y+pd*uy+yShft)*uConv);
+                MMField.push_back((z+pd*uz+zShft)*uConv);
+                MMField.push_back(qp*scrq);
+                MMField.push_back((x-pd*ux+xShft)*uConv);
+                MMField.push_back((y-pd*uy+yShft)*uConv);
+                MMField.push_back((z-pd*uz+zShft)*uConv);
+                MMField.push_back(qn*scrq);
+                continue;
+              }
+            }
           }
-          if (AMOEBA)
+          //Near-field: Add all of the octahedral charges
+          for (int j=0;j<6;j++)
           {
-            //Add multipoles
-            firstCharge = 0; //Skips writing the remaining zeros
-            double tmpX,tmpY,tmpZ,tmpQ; //Temporary storage
-            //Charge 1
-            tmpX = (QMMMData[i].PC[bead].x1+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y1+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z1+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q1*scrq;
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpX,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpY,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpZ,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpQ,16);
-            outFile << '\n';
-            //Charge 2
-            tmpX = (QMMMData[i].PC[bead].x2+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y2+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z2+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q2*scrq;
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpX,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpY,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpZ,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpQ,16);
-            outFile << '\n';
-            //Charge 3
-            tmpX = (QMMMData[i].PC[bead].x3+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y3+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z3+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q3*scrq;
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpX,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpY,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpZ,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpQ,16);
-            outFile << '\n';
-            //Charge 4
-            tmpX = (QMMMData[i].PC[bead].x4+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y4+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z4+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q4*scrq;
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpX,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpY,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpZ,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpQ,16);
-            outFile << '\n';
-            //Charge 5
-            tmpX = (QMMMData[i].PC[bead].x5+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y5+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z5+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q5*scrq;
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpX,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpY,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpZ,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpQ,16);
-            outFile << '\n';
-            //Charge 6
-            tmpX = (QMMMData[i].PC[bead].x6+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y6+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z6+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q6*scrq;
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpX,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpY,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpZ,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpQ,16);
-            outFile << '\n';
+            MMField.push_back((gridX[j]+xShft)*uConv);
+            MMField.push_back((gridY[j]+yShft)*uConv);
+            MMField.push_back((gridZ[j]+zShft)*uConv);
+            MMField.push_back(gridQ[j]*scrq);
           }
         }
       }
     }
   }
-  if (PSI4)
+  if (useEmbed and (!embedPrinted))
   {
-    //Save file
-    call.str("");
-    call << "MMCharges_" << bead << ".txt";
-    outFile.open(call.str().c_str(),ios_base::out);
-    for (int i=0;i<Natoms;i++)
+    //Report the size of the compressed field once
+    #pragma omp critical (MMFieldLock)
     {
-      if (QMMMData[i].MMRegion)
+      if (!embedPrinted)
       {
-        //Check PBC (minimum image convention)
-        Coord distCent; //Distance from QM COM
-        double xShft = 0;
-        double yShft = 0;
-        double zShft = 0;
-        if (PBCon or QMMMOpts.useLREC)
-        {
-          //Initialize displacements
-          double dx,dy,dz; //Starting displacements
-          dx = QMMMData[i].P[bead].x-QMCOM.x;
-          dy = QMMMData[i].P[bead].y-QMCOM.y;
-          dz = QMMMData[i].P[bead].z-QMCOM.z;
-          distCent = CoordDist2(QMMMData[i].P[bead],QMCOM);
-          //Calculate the shift in positions
-          //NB: Generally this work out to be +/- {Lx,Ly,Lz}
-          if (PBCon)
-          {
-            xShft = distCent.x-dx;
-            yShft = distCent.y-dy;
-            zShft = distCent.z-dz;
-          }
-        }
-        //Check for long-range corrections
-        double scrq = 1;
-        if (QMMMOpts.useLREC)
+        embedPrinted = 1;
+        int Nsent = MMField.size()/4; //Number of charges in the field
+        cout << "MM embedding: " << Nsent << " of " << Nfull;
+        cout << " point-charges";
+        if (Nsent > 0)
         {
-          //Use the long-range correction
-          scrq = LRECFunction(distCent,QMMMOpts);
-        }
-        if (scrq > 0)
-        {
-          if (CHRG)
-          {
-            //Add charge
-            double tmpX,tmpY,tmpZ,tmpQ; //Temporary storage
-            tmpX = (QMMMData[i].P[bead].x+xShft)*uConv;
-            tmpY = (QMMMData[i].P[bead].y+yShft)*uConv;
-            tmpZ = (QMMMData[i].P[bead].z+zShft)*uConv;
-            tmpQ = QMMMData[i].MP[bead].q*scrq;
-            outFile << "Chrgfield.extern.addCharge(";
-            outFile << LICHEMFormFloat(tmpQ,16) << ",";
-            outFile << LICHEMFormFloat(tmpX,16) << ",";
-            outFile << LICHEMFormFloat(tmpY,16) << ",";
-            outFile << LICHEMFormFloat(tmpZ,16) << ")";
-            outFile << '\n';
-          }
-          if (AMOEBA)
-          {
-            //Add multipoles
-            double tmpX,tmpY,tmpZ,tmpQ; //Temporary storage
-            //Charge 1
-            tmpX = (QMMMData[i].PC[bead].x1+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y1+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z1+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q1*scrq;
-            outFile << "Chrgfield.extern.addCharge(";
-            outFile << LICHEMFormFloat(tmpQ,16) << ",";
-            outFile << LICHEMFormFloat(tmpX,16) << ",";
-            outFile << LICHEMFormFloat(tmpY,16) << ",";
-            outFile << LICHEMFormFloat(tmpZ,16) << ")";
-            outFile << '\n';
-            //Charge 2
-            tmpX = (QMMMData[i].PC[bead].x2+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y2+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z2+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q2*scrq;
-            outFile << "Chrgfield.extern.addCharge(";
-            outFile << LICHEMFormFloat(tmpQ,16) << ",";
-            outFile << LICHEMFormFloat(tmpX,16) << ",";
-            outFile << LICHEMFormFloat(tmpY,16) << ",";
-            outFile << LICHEMFormFloat(tmpZ,16) << ")";
-            outFile << '\n';
-            //Charge 3
-            tmpX = (QMMMData[i].PC[bead].x3+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y3+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z3+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q3*scrq;
-            outFile << "Chrgfield.extern.addCharge(";
-            outFile << LICHEMFormFloat(tmpQ,16) << ",";
-            outFile << LICHEMFormFloat(tmpX,16) << ",";
-            outFile << LICHEMFormFloat(tmpY,16) << ",";
-            outFile << LICHEMFormFloat(tmpZ,16) << ")";
-            outFile << '\n';
-            //Charge 4
-            tmpX = (QMMMData[i].PC[bead].x4+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y4+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z4+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q4*scrq;
-            outFile << "Chrgfield.extern.addCharge(";
-            outFile << LICHEMFormFloat(tmpQ,16) << ",";
-            outFile << LICHEMFormFloat(tmpX,16) << ",";
-            outFile << LICHEMFormFloat(tmpY,16) << ",";
-            outFile << LICHEMFormFloat(tmpZ,16) << ")";
-            outFile << '\n';
-            //Charge 5
-            tmpX = (QMMMData[i].PC[bead].x5+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y5+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z5+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q5*scrq;
-            outFile << "Chrgfield.extern.addCharge(";
-            outFile << LICHEMFormFloat(tmpQ,16) << ",";
-            outFile << LICHEMFormFloat(tmpX,16) << ",";
-            outFile << LICHEMFormFloat(tmpY,16) << ",";
-            outFile << LICHEMFormFloat(tmpZ,16) << ")";
-            outFile << '\n';
-            //Charge 6
-            tmpX = (QMMMData[i].PC[bead].x6+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y6+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z6+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q6*scrq;
-            outFile << "Chrgfield.extern.addCharge(";
-            outFile << LICHEMFormFloat(tmpQ,16) << ",";
-            outFile << LICHEMFormFloat(tmpX,16) << ",";
-            outFile << LICHEMFormFloat(tmpY,16) << ",";
-            outFile << LICHEMFormFloat(tmpZ,16) << ")";
-            outFile << '\n';
-          }
+          cout << " (QM field cost reduced ";
+          cout << LICHEMFormFloat(((double)Nfull)/Nsent,6) << "x)";
         }
+        cout << '\n' << '\n';
+        cout.flush();
       }
     }
   }
-  //Write to files
-  outFile.flush();
-  outFile.close();
-  //Return to the QM calculations
+  if (MMField.empty() and firstCharge and (firstMM >= 0))
+  {
+    //Add a single zero charge on the first MM atom
+    MMField.push_back(QMMMData[firstMM].P[bead].x*uConv);
+    MMField.push_back(QMMMData[firstMM].P[bead].y*uConv);
+    MMField.push_back(QMMMData[firstMM].P[bead].z*uConv);
+    MMField.push_back(0);
+  }
+  return;
+};
+
+void SaveMMField(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
+                 int bead)
+{
+  //Saves the MM field of a bead for the following QM calculations
+  vector<double> MMField; //Packed point-charges
+  BuildMMField(QMMMData,QMMMOpts,bead,MMField);
+  #pragma omp critical (MMFieldLock)
+  {
+    savedFields[bead].swap(MMField);
+  }
+  return;
+};
+
+void GetMMField(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
+                int bead, vector<double>& MMField)
+{
+  //Retrieves the saved MM field of a bead or builds a new one
+  bool fieldSaved = 0; //Flag for a saved field
+  #pragma omp critical (MMFieldLock)
+  {
+    map<int,vector<double> >::iterator field = savedFields.find(bead);
+    if (field != savedFields.end())
+    {
+      MMField = field->second;
+      fieldSaved = 1;
+    }
+  }
+  if (!fieldSaved)
+  {
+    BuildMMField(QMMMData,QMMMOpts,bead,MMField);
+  }
+  return;
+};
+
+void ClearMMField(int bead)
+{
+  //Removes the saved MM field of a bead
+  #pragma omp critical (MMFieldLock)
+  {
+    savedFields.erase(bead);
+  }
   return;
 };
 
@@ -951,281 +1266,12 @@ void ExtractGlobalPoles(int& argc, char**& argv)
   //Rotate multipoles
   if (TINKER)
   {
-    #pragma omp parallel for schedule(dynamic) num_threads(Ncpus)
+    vector<MPole> globPoles; //Multipoles in the global frame
+    RotateTINKPoles(QMMMData,globPoles,bead);
     for (int i=0;i<Natoms;i++)
     {
-      Vector3d vecX,vecY,vecZ; //Local frame vectors
-      //Initialize vectors in the global frame
-      vecX(0) = 1;
-      vecX(1) = 0;
-      vecX(2) = 0;
-      vecY(0) = 0;
-      vecY(1) = 1;
-      vecY(2) = 0;
-      vecZ(0) = 0;
-      vecZ(1) = 0;
-      vecZ(2) = 1;
-      //Find current orientation and rotate multipoles
-      double x,y,z;
-      if (QMMMData[i].MP[bead].type == "Bisector")
-      {
-        //Find z vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].z;
-        vecZ(0) = -1*x; //Correct the direction
-        vecZ(1) = -1*y; //Correct the direction
-        vecZ(2) = -1*z; //Correct the direction
-        vecZ.normalize();
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].z;
-        vecX(0) = -1*x; //Correct the direction
-        vecX(1) = -1*y; //Correct the direction
-        vecX(2) = -1*z; //Correct the direction
-        vecX.normalize();
-        //Fill in z vector
-        vecZ += vecX;
-        vecZ.normalize();
-        //Find x vector by subtracting overlap
-        vecX -= vecZ*(vecX.dot(vecZ));
-        vecX.normalize();
-      }
-      if (QMMMData[i].MP[bead].type == "Z-then-X")
-      {
-        //Find z vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].z;
-        vecZ(0) = -1*x; //Correct the direction
-        vecZ(1) = -1*y; //Correct the direction
-        vecZ(2) = -1*z; //Correct the direction
-        vecZ.normalize();
-        //Find x vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].z;
-        vecX(0) = -1*x; //Correct the direction
-        vecX(1) = -1*y; //Correct the direction
-        vecX(2) = -1*z; //Correct the direction
-        vecX.normalize();
-        //Subtract overlap and normalize
-        vecX -= vecZ*(vecX.dot(vecZ));
-        vecX.normalize();
-      }
-      if (QMMMData[i].MP[bead].type == "Z-Bisect")
-      {
-        //Find first vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].z;
-        vecZ(0) = -1*x; //Correct the direction
-        vecZ(1) = -1*y; //Correct the direction
-        vecZ(2) = -1*z; //Correct the direction
-        vecZ.normalize();
-        //Find second vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].z;
-        vecX(0) = -1*x; //Correct the direction
-        vecX(1) = -1*y; //Correct the direction
-        vecX(2) = -1*z; //Correct the direction
-        vecX.normalize();
-        //Find third vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom3].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom3].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom3].P[bead].z;
-        vecY(0) = -1*x; //Correct the direction
-        vecY(1) = -1*y; //Correct the direction
-        vecY(2) = -1*z; //Correct the direction
-        vecY.normalize();
-        //Combine vectors
-        vecX += vecY;
-        vecX.normalize();
-        //Subtract overlap and normalize
-        vecX -= vecZ*(vecX.dot(vecZ));
-        vecX.normalize();
-      }
-      if (QMMMData[i].MP[bead].type == "3-Fold")
-      {
-        //First vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].z;
-        vecZ(0) = -1*x; //Correct the direction
-        vecZ(1) = -1*y; //Correct the direction
-        vecZ(2) = -1*z; //Correct the direction
-        vecZ.normalize();
-        //Second vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom2].P[bead].z;
-        vecX(0) = -1*x; //Correct the direction
-        vecX(1) = -1*y; //Correct the direction
-        vecX(2) = -1*z; //Correct the direction
-        vecX.normalize();
-        //Third vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom3].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom3].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom3].P[bead].z;
-        vecY(0) = -1*x; //Correct the direction
-        vecY(1) = -1*y; //Correct the direction
-        vecY(2) = -1*z; //Correct the direction
-        vecY.normalize();
-        //Combine vectors and normalize
-        vecZ += vecX+vecY;
-        vecZ.normalize();
-        //Find second axis by subtracting overlap and normalizing
-        vecX -= vecZ*(vecX.dot(vecZ));
-        vecX.normalize();
-      }
-      if (QMMMData[i].MP[bead].type == "Z-Only")
-      {
-        //Primary vector
-        x = QMMMData[i].P[bead].x;
-        x -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].x;
-        y = QMMMData[i].P[bead].y;
-        y -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].y;
-        z = QMMMData[i].P[bead].z;
-        z -= QMMMData[QMMMData[i].MP[bead].atom1].P[bead].z;
-        vecZ(0) = -1*x; //Correct the direction
-        vecZ(1) = -1*y; //Correct the direction
-        vecZ(2) = -1*z; //Correct the direction
-        vecZ.normalize();
-        //Use a global axis for the second vector
-        vecX(0) = 1.0;
-        vecX(1) = 0.0;
-        vecX(2) = 0.0;
-        if (vecZ.dot(vecX) > 0.85)
-        {
-          //Switch to y axis if overlap is large
-          vecX(0) = 0.0;
-          vecX(1) = 1.0;
-        }
-        //Subtract overlap and normalize
-        vecX -= vecZ*(vecX.dot(vecZ));
-        vecX.normalize();
-      }
-      //Fill in y vector
-      vecY = vecX.cross(vecZ);
-      vecY.normalize();
-      //Rotate to the global frame
-      MPole newPoles;
-      //Add monopoles
-      newPoles.q = QMMMData[i].MP[bead].q;
-      //Rotate dipoles
-      newPoles.Dx = 0; //X component
-      newPoles.Dx += QMMMData[i].MP[bead].Dx*vecX(0);
-      newPoles.Dx += QMMMData[i].MP[bead].Dy*vecY(0);
-      newPoles.Dx += QMMMData[i].MP[bead].Dz*vecZ(0);
-      newPoles.Dy = 0; //Y component
-      newPoles.Dy += QMMMData[i].MP[bead].Dx*vecX(1);
-      newPoles.Dy += QMMMData[i].MP[bead].Dy*vecY(1);
-      newPoles.Dy += QMMMData[i].MP[bead].Dz*vecZ(1);
-      newPoles.Dz = 0; //Z component
-      newPoles.Dz += QMMMData[i].MP[bead].Dx*vecX(2);
-      newPoles.Dz += QMMMData[i].MP[bead].Dy*vecY(2);
-      newPoles.Dz += QMMMData[i].MP[bead].Dz*vecZ(2);
-      //Add induced dipoles (Already in global frame)
-      newPoles.Dx += QMMMData[i].MP[bead].IDx;
-      newPoles.Dy += QMMMData[i].MP[bead].IDy;
-      newPoles.Dz += QMMMData[i].MP[bead].IDz;
-      newPoles.IDx = 0;
-      newPoles.IDy = 0;
-      newPoles.IDz = 0;
-      //Rotate quadrupoles (This looks awful, but it works)
-      newPoles.Qxx = 0; //XX component
-      newPoles.Qxx += vecX(0)*vecX(0)*QMMMData[i].MP[bead].Qxx;
-      newPoles.Qxx += vecX(0)*vecY(0)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qxx += vecX(0)*vecZ(0)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qxx += vecY(0)*vecX(0)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qxx += vecY(0)*vecY(0)*QMMMData[i].MP[bead].Qyy;
-      newPoles.Qxx += vecY(0)*vecZ(0)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qxx += vecZ(0)*vecX(0)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qxx += vecZ(0)*vecY(0)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qxx += vecZ(0)*vecZ(0)*QMMMData[i].MP[bead].Qzz;
-      newPoles.Qxy = 0; //XY component
-      newPoles.Qxy += vecX(0)*vecX(1)*QMMMData[i].MP[bead].Qxx;
-      newPoles.Qxy += vecX(0)*vecY(1)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qxy += vecX(0)*vecZ(1)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qxy += vecY(0)*vecX(1)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qxy += vecY(0)*vecY(1)*QMMMData[i].MP[bead].Qyy;
-      newPoles.Qxy += vecY(0)*vecZ(1)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qxy += vecZ(0)*vecX(1)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qxy += vecZ(0)*vecY(1)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qxy += vecZ(0)*vecZ(1)*QMMMData[i].MP[bead].Qzz;
-      newPoles.Qxz = 0; //XZ component
-      newPoles.Qxz += vecX(0)*vecX(2)*QMMMData[i].MP[bead].Qxx;
-      newPoles.Qxz += vecX(0)*vecY(2)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qxz += vecX(0)*vecZ(2)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qxz += vecY(0)*vecX(2)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qxz += vecY(0)*vecY(2)*QMMMData[i].MP[bead].Qyy;
-      newPoles.Qxz += vecY(0)*vecZ(2)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qxz += vecZ(0)*vecX(2)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qxz += vecZ(0)*vecY(2)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qxz += vecZ(0)*vecZ(2)*QMMMData[i].MP[bead].Qzz;
-      newPoles.Qyy = 0; //YY component
-      newPoles.Qyy += vecX(1)*vecX(1)*QMMMData[i].MP[bead].Qxx;
-      newPoles.Qyy += vecX(1)*vecY(1)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qyy += vecX(1)*vecZ(1)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qyy += vecY(1)*vecX(1)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qyy += vecY(1)*vecY(1)*QMMMData[i].MP[bead].Qyy;
-      newPoles.Qyy += vecY(1)*vecZ(1)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qyy += vecZ(1)*vecX(1)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qyy += vecZ(1)*vecY(1)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qyy += vecZ(1)*vecZ(1)*QMMMData[i].MP[bead].Qzz;
-      newPoles.Qyz = 0; //YZ component
-      newPoles.Qyz += vecX(1)*vecX(2)*QMMMData[i].MP[bead].Qxx;
-      newPoles.Qyz += vecX(1)*vecY(2)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qyz += vecX(1)*vecZ(2)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qyz += vecY(1)*vecX(2)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qyz += vecY(1)*vecY(2)*QMMMData[i].MP[bead].Qyy;
-      newPoles.Qyz += vecY(1)*vecZ(2)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qyz += vecZ(1)*vecX(2)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qyz += vecZ(1)*vecY(2)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qyz += vecZ(1)*vecZ(2)*QMMMData[i].MP[bead].Qzz;
-      newPoles.Qzz = 0; //ZZ component
-      newPoles.Qzz += vecX(2)*vecX(2)*QMMMData[i].MP[bead].Qxx;
-      newPoles.Qzz += vecX(2)*vecY(2)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qzz += vecX(2)*vecZ(2)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qzz += vecY(2)*vecX(2)*QMMMData[i].MP[bead].Qxy;
-      newPoles.Qzz += vecY(2)*vecY(2)*QMMMData[i].MP[bead].Qyy;
-      newPoles.Qzz += vecY(2)*vecZ(2)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qzz += vecZ(2)*vecX(2)*QMMMData[i].MP[bead].Qxz;
-      newPoles.Qzz += vecZ(2)*vecY(2)*QMMMData[i].MP[bead].Qyz;
-      newPoles.Qzz += vecZ(2)*vecZ(2)*QMMMData[i].MP[bead].Qzz;
       //Save the global frame multipoles
-      QMMMData[i].MP[bead] = newPoles;
+      QMMMData[i].MP[bead] = globPoles[i];
     }
   }
   //Calculate the total charge
@@ -1294,12 +1340,13 @@ RedMPole Cart2SphHarm(MPole& pole)
   QPole(2,2) = pole.Qzz;
   //Change out of a.u.
   QPole *= bohrRad*bohrRad; //NB: TINKER also divides by 3
-  EigenSolver<Matrix3d> QTensor; //There might be a better method
-  QTensor.compute(QPole);
+  //NB: The closed-form solver avoids the iterations of a general solver
+  SelfAdjointEigenSolver<Matrix3d> QTensor;
+  QTensor.computeDirect(QPole);
   Vector3d SHTensor;
-  SHTensor = QTensor.eigenvalues().real();
+  SHTensor = QTensor.eigenvalues();
   //Save vector
-  Matrix3d vec = QTensor.eigenvectors().real();
+  Matrix3d vec = QTensor.eigenvectors();
   SHPole.vecX(0) = vec(0,0);
   SHPole.vecX(1) = vec(1,0);
   SHPole.vecX(2) = vec(2,0);
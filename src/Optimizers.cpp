@@ -43,35 +43,8 @@ bool OptConverged(vector<QMMMAtom>& QMMMData, vector<QMMMAtom>& oldQMMMData,
       maxForce = abs(forces.minCoeff());
     }
     RMSForce = sqrt(forces.squaredNorm()/Ndof);
-    #pragma omp parallel for schedule(dynamic) reduction(+:RMSDiff)
-    for (int i=0;i<Natoms;i++)
-    {
-      //Calculate QM-QM distance matrix
-      double RMSTemp = 0; //Store a local sum
-      if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
-      {
-        for (int j=0;j<i;j++)
-        {
-          if (QMMMData[j].QMRegion or QMMMData[j].PBRegion)
-          {
-            double RNew = 0;
-            double ROld = 0;
-            RNew = CoordDist2(QMMMData[i].P[bead],
-                              QMMMData[j].P[bead]).vecMag();
-            ROld = CoordDist2(oldQMMMData[i].P[bead],
-                              oldQMMMData[j].P[bead]).vecMag();
-            RNew = sqrt(RNew);
-            ROld = sqrt(ROld);
-            //Update local sum
-            RMSTemp += (RNew-ROld)*(RNew-ROld);
-          }
-        }
-      }
-      //Update sum
-      RMSDiff += RMSTemp;
-    }
-    RMSDiff /= (Nqm+Npseudo)*(Nqm+Npseudo-1)/2;
-    RMSDiff = sqrt(RMSDiff);
+    //Calculate RMS displacement
+    RMSDiff = ConvRMSDev(QMMMData,oldQMMMData,QMMMOpts,bead,1);
     //Print progress
     cout << "    QM step: " << stepCt;
     cout << " | RMS dev: " << LICHEMFormFloat(RMSDiff,12);
@@ -127,29 +100,8 @@ bool OptConverged(vector<QMMMAtom>& QMMMData, vector<QMMMAtom>& oldQMMMData,
       sumE += LAMMPSEnergy(QMMMData,QMMMOpts,bead);
       MMTime += (unsigned)time(0)-tStart;
     }
-    //Calculate RMS displacement (distance matrix)
-    #pragma omp parallel for schedule(dynamic) reduction(+:RMSDiff)
-    for (int i=0;i<Natoms;i++)
-    {
-      double RMSTemp = 0; //Store a local sum
-      for (int j=0;j<i;j++)
-      {
-        double RNew = 0;
-        double ROld = 0;
-        RNew = CoordDist2(QMMMData[i].P[bead],
-                          QMMMData[j].P[bead]).vecMag();
-        ROld = CoordDist2(oldQMMMData[i].P[bead],
-                          oldQMMMData[j].P[bead]).vecMag();
-        RNew = sqrt(RNew);
-        ROld = sqrt(ROld);
-        //Update local sum
-        RMSTemp += (RNew-ROld)*(RNew-ROld);
-      }
-      //Update sum
-      RMSDiff += RMSTemp;
-    }
-    RMSDiff /= (Natoms-Nfreeze)*(Natoms-Nfreeze-1)/2;
-    RMSDiff = sqrt(RMSDiff);
+    //Calculate RMS displacement
+    RMSDiff = ConvRMSDev(QMMMData,oldQMMMData,QMMMOpts,bead,0);
     //Print progress
     cout << " | Opt. step: ";
     cout << stepCt << " | Energy: ";
@@ -172,6 +124,482 @@ bool OptConverged(vector<QMMMAtom>& QMMMData, vector<QMMMAtom>& oldQMMMData,
   return optDone;
 };
 
+//Internal coordinate functions
+vector<IntCoord> BuildIntCoords(vector<QMMMAtom>& QMMMData, int bead)
+{
+  //Function to build redundant internal coordinates for the QM and PB atoms
+  double linTol = 175.0*pi/180.0; //Largest angle before a bend is linear
+  double kBond = 0.50*har2eV/(bohrRad*bohrRad); //Model stretch (eV/Ang^2)
+  double kBend = 0.20*har2eV; //Model bend (eV/rad^2)
+  double kTors = 0.10*har2eV; //Model torsion (eV/rad^2)
+  double kCart = 0.05*har2eV/(bohrRad*bohrRad); //Model anchor (eV/Ang^2)
+  vector<IntCoord> intCoords; //Final list of coordinates
+  vector<int> qmIDs; //Atom IDs of the QM and PB atoms
+  vector<vector<int> > qmBonds; //Bonds within the QM region
+  for (int i=0;i<Natoms;i++)
+  {
+    if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+    {
+      qmIDs.push_back(i);
+    }
+  }
+  int Nq = (int)qmIDs.size(); //Number of QM and PB atoms
+  qmBonds.resize(Nq);
+  //Find bonds
+  for (int i=0;i<Nq;i++)
+  {
+    for (int j=0;j<i;j++)
+    {
+      if (Bonded(QMMMData,qmIDs[i],qmIDs[j]))
+      {
+        IntCoord newCoord; //Bond stretch
+        newCoord.type = 1;
+        newCoord.atom1 = j;
+        newCoord.atom2 = i;
+        newCoord.kGuess = kBond;
+        intCoords.push_back(newCoord);
+        qmBonds[i].push_back(j);
+        qmBonds[j].push_back(i);
+      }
+    }
+  }
+  //Connect separate fragments with their shortest distances
+  vector<int> fragID(Nq,-1); //Fragment of each atom
+  int Nfrags = 0; //Number of fragments
+  for (int i=0;i<Nq;i++)
+  {
+    if (fragID[i] < 0)
+    {
+      //Label a new fragment
+      vector<int> atStack; //Atoms to visit
+      atStack.push_back(i);
+      fragID[i] = Nfrags;
+      while (atStack.size() > 0)
+      {
+        int atID = atStack.back();
+        atStack.pop_back();
+        for (unsigned int j=0;j<qmBonds[atID].size();j++)
+        {
+          int bondID = qmBonds[atID][j];
+          if (fragID[bondID] < 0)
+          {
+            fragID[bondID] = Nfrags;
+            atStack.push_back(bondID);
+          }
+        }
+      }
+      Nfrags += 1;
+    }
+  }
+  while (Nfrags > 1)
+  {
+    //Find the closest atoms between the first fragment and any other
+    int bestI = 0; //Atom in the first fragment
+    int bestJ = 0; //Atom in another fragment
+    double bestR = hugeNum; //Shortest squared distance
+    for (int i=0;i<Nq;i++)
+    {
+      for (int j=0;j<Nq;j++)
+      {
+        if ((fragID[i] == 0) and (fragID[j] != 0))
+        {
+          double rij = CoordDist2(QMMMData[qmIDs[i]].P[bead],
+                                  QMMMData[qmIDs[j]].P[bead]).vecMag();
+          if (rij < bestR)
+          {
+            bestR = rij;
+            bestI = i;
+            bestJ = j;
+          }
+        }
+      }
+    }
+    //Add the interfragment distance and merge the fragments
+    IntCoord newCoord; //Interfragment stretch
+    newCoord.type = 1;
+    newCoord.atom1 = bestI;
+    newCoord.atom2 = bestJ;
+    newCoord.kGuess = kCart;
+    intCoords.push_back(newCoord);
+    int oldFrag = fragID[bestJ]; //Fragment being merged
+    for (int i=0;i<Nq;i++)
+    {
+      if (fragID[i] == oldFrag)
+      {
+        fragID[i] = 0;
+      }
+      else if (fragID[i] == (Nfrags-1))
+      {
+        //Keep the fragment labels contiguous
+        fragID[i] = oldFrag;
+      }
+    }
+    Nfrags -= 1;
+  }
+  //Find angles and dihedrals
+  VectorXd qmPos(3*Nq); //Positions of the QM and PB atoms
+  for (int i=0;i<Nq;i++)
+  {
+    qmPos(3*i) = QMMMData[qmIDs[i]].P[bead].x;
+    qmPos(3*i+1) = QMMMData[qmIDs[i]].P[bead].y;
+    qmPos(3*i+2) = QMMMData[qmIDs[i]].P[bead].z;
+  }
+  for (int i=0;i<Nq;i++)
+  {
+    //Angles centered on atom i
+    for (unsigned int j=0;j<qmBonds[i].size();j++)
+    {
+      for (unsigned int k=0;k<j;k++)
+      {
+        IntCoord newCoord; //Angle bend
+        newCoord.type = 2;
+        newCoord.atom1 = qmBonds[i][k];
+        newCoord.atom2 = i;
+        newCoord.atom3 = qmBonds[i][j];
+        newCoord.kGuess = kBend;
+        vector<IntCoord> tmp(1,newCoord);
+        if (IntCoordValues(tmp,qmPos)(0) < linTol)
+        {
+          intCoords.push_back(newCoord);
+        }
+      }
+    }
+  }
+  for (int i=0;i<Nq;i++)
+  {
+    //Dihedrals around the bond i-j
+    for (unsigned int j=0;j<qmBonds[i].size();j++)
+    {
+      int atom2 = i;
+      int atom3 = qmBonds[i][j];
+      if (atom3 < atom2)
+      {
+        //Avoid counting the bond twice
+        continue;
+      }
+      for (unsigned int k=0;k<qmBonds[atom2].size();k++)
+      {
+        int atom1 = qmBonds[atom2][k];
+        for (unsigned int l=0;l<qmBonds[atom3].size();l++)
+        {
+          int atom4 = qmBonds[atom3][l];
+          if ((atom1 == atom3) or (atom4 == atom2) or (atom1 == atom4))
+          {
+            //Not a proper dihedral
+            continue;
+          }
+          //Skip dihedrals with linear angles
+          IntCoord newCoord; //Torsion
+          vector<IntCoord> tmp(2,newCoord);
+          tmp[0].type = 2;
+          tmp[0].atom1 = atom1;
+          tmp[0].atom2 = atom2;
+          tmp[0].atom3 = atom3;
+          tmp[1].type = 2;
+          tmp[1].atom1 = atom2;
+          tmp[1].atom2 = atom3;
+          tmp[1].atom3 = atom4;
+          VectorXd angs = IntCoordValues(tmp,qmPos);
+          if ((angs(0) < linTol) and (angs(1) < linTol))
+          {
+            newCoord.type = 3;
+            newCoord.atom1 = atom1;
+            newCoord.atom2 = atom2;
+            newCoord.atom3 = atom3;
+            newCoord.atom4 = atom4;
+            newCoord.kGuess = kTors;
+            intCoords.push_back(newCoord);
+          }
+        }
+      }
+    }
+  }
+  //Anchor the QM region to the MM environment
+  vector<int> anchors; //Atoms with Cartesian coordinates
+  if (QMMM or (Nq < 3))
+  {
+    for (int i=0;i<Nq;i++)
+    {
+      //Pseudobond atoms connect the QM region to the MM region
+      if (QMMMData[qmIDs[i]].PBRegion)
+      {
+        anchors.push_back(i);
+      }
+    }
+    for (int i=0;i<Nq;i++)
+    {
+      //Make sure that the rigid body motion is defined
+      if ((anchors.size() < 3) and (!QMMMData[qmIDs[i]].PBRegion))
+      {
+        anchors.push_back(i);
+      }
+    }
+  }
+  for (unsigned int i=0;i<anchors.size();i++)
+  {
+    for (int j=0;j<3;j++)
+    {
+      IntCoord newCoord; //Cartesian position
+      newCoord.type = 0;
+      newCoord.atom1 = anchors[i];
+      newCoord.atom2 = j;
+      newCoord.kGuess = kCart;
+      intCoords.push_back(newCoord);
+    }
+  }
+  return intCoords;
+};
+
+MatrixXd IntCoordGInv(MatrixXd& BMat)
+{
+  //Function to calculate the generalized inverse of G = B*B^T
+  double eigTol = 1e-8; //Smallest eigenvalue in the inverse
+  SelfAdjointEigenSolver<MatrixXd> GSolver; //Eigensolver for G
+  GSolver.compute(BMat*BMat.transpose());
+  VectorXd GVals = GSolver.eigenvalues(); //Eigenvalues of G
+  for (int i=0;i<GVals.size();i++)
+  {
+    //Invert the non-zero eigenvalues
+    if (GVals(i) > eigTol)
+    {
+      GVals(i) = 1/GVals(i);
+    }
+    else
+    {
+      GVals(i) = 0;
+    }
+  }
+  MatrixXd GInv = GSolver.eigenvectors()*GVals.asDiagonal();
+  GInv *= GSolver.eigenvectors().transpose();
+  return GInv;
+};
+
+VectorXd IntCoordValues(vector<IntCoord>& intCoords, VectorXd& qmPos)
+{
+  //Function to calculate the values of internal coordinates
+  int Nint = (int)intCoords.size(); //Number of coordinates
+  VectorXd qVals(Nint); //Coordinate values (Ang or radians)
+  #pragma omp parallel for schedule(dynamic)
+  for (int i=0;i<Nint;i++)
+  {
+    IntCoord& ic = intCoords[i];
+    if (ic.type == 0)
+    {
+      //Cartesian position
+      qVals(i) = qmPos(3*ic.atom1+ic.atom2);
+    }
+    else if (ic.type == 1)
+    {
+      //Bond length
+      Vector3d u = qmPos.segment<3>(3*ic.atom1)-qmPos.segment<3>(3*ic.atom2);
+      qVals(i) = u.norm();
+    }
+    else if (ic.type == 2)
+    {
+      //Bond angle
+      Vector3d u = qmPos.segment<3>(3*ic.atom1)-qmPos.segment<3>(3*ic.atom2);
+      Vector3d v = qmPos.segment<3>(3*ic.atom3)-qmPos.segment<3>(3*ic.atom2);
+      double cosAng = u.dot(v)/(u.norm()*v.norm());
+      if (cosAng > 1)
+      {
+        cosAng = 1;
+      }
+      if (cosAng < -1)
+      {
+        cosAng = -1;
+      }
+      qVals(i) = acos(cosAng);
+    }
+    else
+    {
+      //Dihedral angle
+      Vector3d F = qmPos.segment<3>(3*ic.atom1)-qmPos.segment<3>(3*ic.atom2);
+      Vector3d G = qmPos.segment<3>(3*ic.atom2)-qmPos.segment<3>(3*ic.atom3);
+      Vector3d H = qmPos.segment<3>(3*ic.atom4)-qmPos.segment<3>(3*ic.atom3);
+      Vector3d A = F.cross(G);
+      Vector3d B = H.cross(G);
+      qVals(i) = atan2(B.cross(A).dot(G)/G.norm(),A.dot(B));
+    }
+  }
+  return qVals;
+};
+
+MatrixXd WilsonBMatrix(vector<IntCoord>& intCoords, VectorXd& qmPos)
+{
+  //Function to calculate the derivatives of the internal coordinates
+  int Nint = (int)intCoords.size(); //Number of coordinates
+  int Ndof = (int)qmPos.size(); //Number of Cartesian coordinates
+  MatrixXd BMat(Nint,Ndof); //Wilson B matrix
+  BMat.setZero();
+  #pragma omp parallel for schedule(dynamic)
+  for (int i=0;i<Nint;i++)
+  {
+    IntCoord& ic = intCoords[i];
+    if (ic.type == 0)
+    {
+      //Cartesian position
+      BMat(i,3*ic.atom1+ic.atom2) = 1;
+    }
+    else if (ic.type == 1)
+    {
+      //Bond length
+      Vector3d u = qmPos.segment<3>(3*ic.atom1)-qmPos.segment<3>(3*ic.atom2);
+      u.normalize();
+      BMat.block<1,3>(i,3*ic.atom1) = u.transpose();
+      BMat.block<1,3>(i,3*ic.atom2) = -u.transpose();
+    }
+    else if (ic.type == 2)
+    {
+      //Bond angle
+      Vector3d u = qmPos.segment<3>(3*ic.atom1)-qmPos.segment<3>(3*ic.atom2);
+      Vector3d v = qmPos.segment<3>(3*ic.atom3)-qmPos.segment<3>(3*ic.atom2);
+      double uLen = u.norm();
+      double vLen = v.norm();
+      u /= uLen;
+      v /= vLen;
+      double cosAng = u.dot(v);
+      double sinAng = sqrt(abs(1-cosAng*cosAng));
+      if (sinAng < 1e-6)
+      {
+        //Avoid dividing by zero for linear angles
+        sinAng = 1e-6;
+      }
+      Vector3d dA = (cosAng*u-v)/(uLen*sinAng);
+      Vector3d dC = (cosAng*v-u)/(vLen*sinAng);
+      BMat.block<1,3>(i,3*ic.atom1) = dA.transpose();
+      BMat.block<1,3>(i,3*ic.atom3) = dC.transpose();
+      BMat.block<1,3>(i,3*ic.atom2) = -(dA+dC).transpose();
+    }
+    else
+    {
+      //Dihedral angle
+      Vector3d F = qmPos.segment<3>(3*ic.atom1)-qmPos.segment<3>(3*ic.atom2);
+      Vector3d G = qmPos.segment<3>(3*ic.atom2)-qmPos.segment<3>(3*ic.atom3);
+      Vector3d H = qmPos.segment<3>(3*ic.atom4)-qmPos.segment<3>(3*ic.atom3);
+      Vector3d A = F.cross(G);
+      Vector3d B = H.cross(G);
+      double GLen = G.norm();
+      double A2 = A.squaredNorm();
+      double B2 = B.squaredNorm();
+      if ((A2 < 1e-12) or (B2 < 1e-12))
+      {
+        //Undefined dihedral, leave the derivatives as zero
+        continue;
+      }
+      Vector3d dA = -(GLen/A2)*A;
+      Vector3d dD = (GLen/B2)*B;
+      Vector3d dMid = (F.dot(G)/(A2*GLen))*A-(H.dot(G)/(B2*GLen))*B;
+      BMat.block<1,3>(i,3*ic.atom1) = dA.transpose();
+      BMat.block<1,3>(i,3*ic.atom2) = (-dA+dMid).transpose();
+      BMat.block<1,3>(i,3*ic.atom3) = (-dD-dMid).transpose();
+      BMat.block<1,3>(i,3*ic.atom4) = dD.transpose();
+    }
+  }
+  return BMat;
+};
+
+//Force functions
+double LICHEMForces(vector<QMMMAtom>& QMMMData, VectorXd& forces,
+                    QMMMSettings& QMMMOpts, int bead, bool timeCalcs)
+{
+  //Calculates the QMMM energy and the forces on the QM and PB atoms
+  //NB: Concurrent calls (timeCalcs = 0) do not update the timers or delete
+  //the PSI4 scratch files, since both are shared between the beads
+  double E = 0; //QMMM energy
+  int tStart = (unsigned)time(0); //Start of the QM or MM calculation
+  forces.setZero();
+  //Calculate forces (QM part)
+  if (Gaussian)
+  {
+    E += GaussianForces(QMMMData,forces,QMMMOpts,bead);
+  }
+  if (PSI4)
+  {
+    E += PSI4Forces(QMMMData,forces,QMMMOpts,bead);
+    if (timeCalcs)
+    {
+      //Delete annoying useless files
+      globalSys = system("rm -f psi.* timer.*");
+    }
+  }
+  if (NWChem)
+  {
+    E += NWChemForces(QMMMData,forces,QMMMOpts,bead);
+  }
+  if (timeCalcs)
+  {
+    QMTime += (unsigned)time(0)-tStart;
+    tStart = (unsigned)time(0);
+  }
+  //Calculate forces (MM part)
+  if (TINKER)
+  {
+    E += TINKERForces(QMMMData,forces,QMMMOpts,bead);
+    if (AMOEBA or QMMMOpts.useImpSolv)
+    {
+      //Forces from MM polarization
+      E += TINKERPolForces(QMMMData,forces,QMMMOpts,bead);
+    }
+  }
+  if (LAMMPS)
+  {
+    E += LAMMPSForces(QMMMData,forces,QMMMOpts,bead);
+  }
+  if (timeCalcs)
+  {
+    MMTime += (unsigned)time(0)-tStart;
+  }
+  return E;
+};
+
+//Microiteration functions
+void MicroIterMM(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
+                 double QMDisp, int bead)
+{
+  //Relaxes the MM region around a fixed QM region
+  //NB: The QM charges from the last QM gradient are used in the MM wrapper,
+  //and the tolerance is loosened when the QM atoms take large steps
+  double microTolMax = 0.25; //Loosest MM tolerance during microiterations
+  if (QMDisp < QMMMOpts.microDisp)
+  {
+    //The QM atoms barely moved, so the MM region is still relaxed
+    return;
+  }
+  //Adapt the MM tolerance to the size of the QM step
+  double savedMMOptTol = QMMMOpts.MMOptTol; //Save value from input
+  double microTol = QMMMOpts.MMOptTol*(QMDisp/QMMMOpts.microDisp);
+  if (microTol > microTolMax)
+  {
+    microTol = microTolMax;
+  }
+  if (microTol < savedMMOptTol)
+  {
+    microTol = savedMMOptTol;
+  }
+  QMMMOpts.MMOptTol = microTol;
+  //Run MM optimization
+  if (TINKER)
+  {
+    int tStart = (unsigned)time(0);
+    TINKEROpt(QMMMData,QMMMOpts,bead);
+    MMTime += (unsigned)time(0)-tStart;
+  }
+  if (LAMMPS)
+  {
+    int tStart = (unsigned)time(0);
+    LAMMPSOpt(QMMMData,QMMMOpts,bead);
+    MMTime += (unsigned)time(0)-tStart;
+  }
+  QMMMOpts.MMOptTol = savedMMOptTol;
+  cout << "    MM microiterations complete. Tolerance: ";
+  cout << LICHEMFormFloat(microTol,8);
+  cout << '\n';
+  cout.flush();
+  //Update the MM charges for the QM wrappers
+  SaveMMField(QMMMData,QMMMOpts,bead);
+  return;
+};
+
 //Optimizer functions
 void LICHEMSteepest(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
                     int bead)
@@ -185,7 +613,7 @@ void LICHEMSteepest(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
   //Initialize charges
   if (Nmm > 0)
   {
-    WriteChargeFile(QMMMData,QMMMOpts,bead);
+    SaveMMField(QMMMData,QMMMOpts,bead);
   }
   //Initialize QM trajectory file
   call.str("");
@@ -302,8 +730,8 @@ void LICHEMSteepest(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
   //Clean up files
   call.str("");
   call << "rm -f QMOpt_" << bead << ".xyz";
-  call << " MMCharges_" << bead << ".txt";
   globalSys = system(call.str().c_str());
+  ClearMMField(bead);
   //Finish and return
   return;
 };
@@ -321,7 +749,7 @@ void LICHEMDFP(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts, int bead)
   //Initialize charges
   if (Nmm > 0)
   {
-    WriteChargeFile(QMMMData,QMMMOpts,bead);
+    SaveMMField(QMMMData,QMMMOpts,bead);
   }
   //Initialize QM trajectory file
   call.str("");
@@ -588,9 +1016,594 @@ void LICHEMDFP(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts, int bead)
   //Clean up files
   call.str("");
   call << "rm -f QMOpt_" << bead << ".xyz";
-  call << " MMCharges_" << bead << ".txt";
   globalSys = system(call.str().c_str());
+  ClearMMField(bead);
   //Finish and return
   return;
 };
 
+
+void LICHEMBFGS(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts, int bead)
+{
+  //A limited-memory BFGS optimizer with a backtracking line search
+  //NB: Only the last BFGSHist displacement/gradient pairs are stored, so the
+  //memory is O(m*Ndof) instead of the O(Ndof^2) inverse Hessian of DFP
+  stringstream call; //Stream for system calls and reading/writing files
+  int stepCt = 0; //Counter for optimization steps
+  fstream qmFile; //QM trajectory file
+  int Ndof = 3*(Nqm+Npseudo); //Number of QM and PB degrees of freedom
+  int Nhist = QMMMOpts.BFGSHist; //Maximum number of stored updates
+  int maxLineSteps = 6; //Maximum number of energy evaluations per line
+  double armijoTol = 1e-4; //Sufficient decrease parameter
+  double curvTol = 1e-10; //Smallest accepted curvature (s.y)
+  double sdScale = 0.01; //Scale factor for SD steps
+  int gradCt = 0; //Number of QM gradient calculations
+  bool useMicro = 0; //Flag to relax the MM region after each QM step
+  if (QMMMOpts.microIter and QMMM and (Nmm > 0))
+  {
+    useMicro = 1;
+  }
+  //Initialize charges
+  if (Nmm > 0)
+  {
+    SaveMMField(QMMMData,QMMMOpts,bead);
+  }
+  //Initialize QM trajectory file
+  call.str("");
+  call << "QMOpt_" << bead << ".xyz";
+  qmFile.open(call.str().c_str(),ios_base::out);
+  //Create L-BFGS arrays
+  MatrixXd sHist(Ndof,Nhist); //Previous displacements
+  MatrixXd yHist(Ndof,Nhist); //Previous changes in the gradient
+  VectorXd rhoHist(Nhist); //Inverse curvatures, 1/(s.y)
+  VectorXd alphaHist(Nhist); //Two-loop recursion coefficients
+  VectorXd optVec(Ndof); //Search direction
+  VectorXd forces(Ndof); //Forces
+  VectorXd oldForces(Ndof); //Forces at the start of the line search
+  VectorXd microPos(Ndof); //QM positions from the last MM relaxation
+  //Initialize arrays
+  sHist.setZero();
+  yHist.setZero();
+  rhoHist.setZero();
+  alphaHist.setZero();
+  optVec.setZero();
+  forces.setZero();
+  oldForces.setZero();
+  if (useMicro)
+  {
+    //Save the QM positions around the relaxed MM region
+    int ct = 0; //Counter
+    for (int i=0;i<Natoms;i++)
+    {
+      if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+      {
+        microPos(ct) = QMMMData[i].P[bead].x;
+        microPos(ct+1) = QMMMData[i].P[bead].y;
+        microPos(ct+2) = QMMMData[i].P[bead].z;
+        ct += 3;
+      }
+    }
+  }
+  //Initialize optimization variables
+  int histCt = 0; //Number of stored updates
+  int histPos = 0; //Position of the next update in the circular buffer
+  double E = 0; //Energy
+  double EOld = 0; //Energy at the start of the line search
+  double vecMax = 0; //Maximum atomic displacement
+  bool optDone = 0; //Flag to end the optimization
+  //Calculate forces
+  E = LICHEMForces(QMMMData,forces,QMMMOpts,bead,1);
+  //Output initial RMS force
+  vecMax = sqrt(forces.squaredNorm()/Ndof);
+  cout << "    QM step: 0";
+  cout << " | RMS force: " << LICHEMFormFloat(vecMax,12);
+  cout << " eV/\u212B";
+  cout << '\n' << '\n';
+  cout.flush();
+  //Optimize structure
+  while ((!optDone) and (stepCt < QMMMOpts.maxOptSteps))
+  {
+    //Copy old structure, energy, and forces
+    vector<QMMMAtom> oldQMMMData = QMMMData;
+    EOld = E;
+    oldForces = forces;
+    //Determine the search direction (two-loop recursion)
+    bool sdStep = 0; //Flag for a steepest descent step
+    optVec = forces; //Negative gradient
+    for (int i=0;i<histCt;i++)
+    {
+      //Loop from the newest to the oldest update
+      int k = (histPos-1-i+Nhist)%Nhist; //Position in the buffer
+      alphaHist(k) = rhoHist(k)*sHist.col(k).dot(optVec);
+      optVec -= alphaHist(k)*yHist.col(k);
+    }
+    if (histCt > 0)
+    {
+      //Scale the guess inverse Hessian with the newest curvature
+      int k = (histPos-1+Nhist)%Nhist; //Newest update
+      optVec *= 1/(rhoHist(k)*yHist.col(k).squaredNorm());
+    }
+    else
+    {
+      //Small steepest descent step
+      cout << "    Performing a steepest descent step...";
+      cout << '\n';
+      optVec *= sdScale*QMMMOpts.stepScale;
+      sdStep = 1;
+    }
+    for (int i=histCt-1;i>=0;i--)
+    {
+      //Loop from the oldest to the newest update
+      int k = (histPos-1-i+Nhist)%Nhist; //Position in the buffer
+      double betaVal = rhoHist(k)*yHist.col(k).dot(optVec);
+      optVec += (alphaHist(k)-betaVal)*sHist.col(k);
+    }
+    //Check that the direction goes down hill
+    double slope = optVec.dot(oldForces); //Decrease along the direction
+    if (slope <= 0)
+    {
+      //Discard the history and take a steepest descent step
+      cout << "    Potentially unstable Hessian.";
+      cout << " Discarding the L-BFGS history...";
+      cout << '\n';
+      histCt = 0;
+      histPos = 0;
+      optVec = sdScale*QMMMOpts.stepScale*oldForces;
+      slope = optVec.dot(oldForces);
+      sdStep = 1;
+    }
+    //Check step size
+    vecMax = 0;
+    for (int i=0;i<(Nqm+Npseudo);i++)
+    {
+      //Find the largest atomic displacement
+      double dispAtom = 0; //Displacement of a single atom
+      dispAtom += optVec(3*i)*optVec(3*i);
+      dispAtom += optVec(3*i+1)*optVec(3*i+1);
+      dispAtom += optVec(3*i+2)*optVec(3*i+2);
+      dispAtom = sqrt(dispAtom);
+      if (dispAtom > vecMax)
+      {
+        vecMax = dispAtom;
+      }
+    }
+    if (vecMax > QMMMOpts.maxStep)
+    {
+      //Scale step size
+      optVec *= (QMMMOpts.maxStep/vecMax);
+      slope *= (QMMMOpts.maxStep/vecMax);
+    }
+    //Backtracking line search
+    double lineStep = 1; //Fraction of the search direction
+    bool lineDone = 0; //Flag to end the line search
+    bool lineFail = 0; //Flag for a failed line search
+    int lineCt = 0; //Number of energy evaluations
+    while (!lineDone)
+    {
+      //Update positions
+      int ct = 0; //Counter
+      for (int i=0;i<Natoms;i++)
+      {
+        //Move QM atoms
+        if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+        {
+          QMMMData[i].P[bead].x = oldQMMMData[i].P[bead].x;
+          QMMMData[i].P[bead].y = oldQMMMData[i].P[bead].y;
+          QMMMData[i].P[bead].z = oldQMMMData[i].P[bead].z;
+          QMMMData[i].P[bead].x += lineStep*optVec(ct);
+          QMMMData[i].P[bead].y += lineStep*optVec(ct+1);
+          QMMMData[i].P[bead].z += lineStep*optVec(ct+2);
+          ct += 3;
+        }
+      }
+      //Calculate forces
+      E = LICHEMForces(QMMMData,forces,QMMMOpts,bead,1);
+      lineCt += 1;
+      gradCt += 1;
+      //Check the Armijo condition
+      if (E <= (EOld-armijoTol*lineStep*slope))
+      {
+        //Sufficient decrease
+        lineDone = 1;
+      }
+      else if (lineCt >= maxLineSteps)
+      {
+        //Reject the step and restart from the previous structure
+        cout << "    Line search failed.";
+        if (sdStep)
+        {
+          cout << " Stopping the optimization...";
+          optDone = 1;
+        }
+        else
+        {
+          cout << " Discarding the L-BFGS history...";
+        }
+        cout << '\n';
+        QMMMData = oldQMMMData;
+        E = EOld;
+        forces = oldForces;
+        if (Nmm > 0)
+        {
+          //Restore the MM charges for the QM wrappers
+          SaveMMField(QMMMData,QMMMOpts,bead);
+        }
+        histCt = 0;
+        histPos = 0;
+        lineDone = 1;
+        lineFail = 1;
+      }
+      else
+      {
+        //Minimize a quadratic fit to the energy along the line
+        double newStep; //Trial step from the quadratic fit
+        newStep = slope*lineStep*lineStep;
+        newStep /= 2*(E-EOld+slope*lineStep);
+        //Keep the new step inside a safe interval
+        if (newStep < (0.1*lineStep))
+        {
+          newStep = 0.1*lineStep;
+        }
+        if (newStep > (0.5*lineStep))
+        {
+          newStep = 0.5*lineStep;
+        }
+        lineStep = newStep;
+        cout << "    Energy did not decrease. Reducing the step size...";
+        cout << '\n';
+      }
+    }
+    stepCt += 1;
+    if (lineFail)
+    {
+      //The structure did not change
+      continue;
+    }
+    //Print structure
+    Print_traj(QMMMData,qmFile,QMMMOpts);
+    //Update the L-BFGS history
+    VectorXd sVec = lineStep*optVec; //Displacement
+    VectorXd yVec = oldForces-forces; //Change in the gradient
+    double sDotY = sVec.dot(yVec); //Curvature along the step
+    if (sDotY > curvTol)
+    {
+      //Save the update in the circular buffer
+      sHist.col(histPos) = sVec;
+      yHist.col(histPos) = yVec;
+      rhoHist(histPos) = 1/sDotY;
+      histPos = (histPos+1)%Nhist;
+      if (histCt < Nhist)
+      {
+        histCt += 1;
+      }
+    }
+    if (useMicro)
+    {
+      //Find the largest QM displacement since the last MM relaxation
+      double QMDisp = 0; //Maximum atomic displacement
+      int ct = 0; //Counter
+      for (int i=0;i<Natoms;i++)
+      {
+        if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+        {
+          double dx = QMMMData[i].P[bead].x-microPos(ct);
+          double dy = QMMMData[i].P[bead].y-microPos(ct+1);
+          double dz = QMMMData[i].P[bead].z-microPos(ct+2);
+          double dispAtom = sqrt(dx*dx+dy*dy+dz*dz); //Atomic displacement
+          if (dispAtom > QMDisp)
+          {
+            QMDisp = dispAtom;
+          }
+          ct += 3;
+        }
+      }
+      if (QMDisp >= QMMMOpts.microDisp)
+      {
+        //Relax the MM region around the accepted QM structure
+        MicroIterMM(QMMMData,QMMMOpts,QMDisp,bead);
+        ct = 0; //Reset counter
+        for (int i=0;i<Natoms;i++)
+        {
+          if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+          {
+            microPos(ct) = QMMMData[i].P[bead].x;
+            microPos(ct+1) = QMMMData[i].P[bead].y;
+            microPos(ct+2) = QMMMData[i].P[bead].z;
+            ct += 3;
+          }
+        }
+        //Update the energy and forces for the new MM structure
+        //NB: The next line search compares energies on the same MM structure
+        E = LICHEMForces(QMMMData,forces,QMMMOpts,bead,1);
+        gradCt += 1;
+      }
+    }
+    //Check convergence
+    optDone = OptConverged(QMMMData,oldQMMMData,forces,stepCt,QMMMOpts,bead,1);
+  }
+  if (useMicro)
+  {
+    //Relax the MM region at the input tolerance around the final structure
+    MicroIterMM(QMMMData,QMMMOpts,QMMMOpts.microDisp,bead);
+  }
+  //Print the cost of the optimization
+  cout << "    QM gradient calculations: " << (gradCt+1);
+  cout << '\n' << '\n';
+  cout.flush();
+  //Clean up files
+  call.str("");
+  call << "rm -f QMOpt_" << bead << ".xyz";
+  globalSys = system(call.str().c_str());
+  ClearMMField(bead);
+  //Finish and return
+  return;
+};
+
+void LICHEMIntOpt(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts, int bead)
+{
+  //A quasi-Newton optimizer in redundant internal coordinates
+  //NB: Steps are taken in the space of bonds, angles, and dihedrals built
+  //from the connectivity, starting from a diagonal model Hessian
+  stringstream call; //Stream for system calls and reading/writing files
+  int stepCt = 0; //Counter for optimization steps
+  fstream qmFile; //QM trajectory file
+  int Ndof = 3*(Nqm+Npseudo); //Number of QM and PB degrees of freedom
+  int maxBackSteps = 25; //Maximum iterations for the back-transformation
+  double backTol = 1e-6; //Convergence of the back-transformation (Ang)
+  double curvTol = 1e-10; //Smallest accepted curvature (s.y)
+  double redunK = 1000.0; //Force constant for the redundant space
+  double minTrust = 0.05*QMMMOpts.maxStep; //Smallest trust radius
+  double trustRad = QMMMOpts.stepScale*QMMMOpts.maxStep; //Trust radius
+  int gradCt = 0; //Number of QM gradient calculations
+  if (trustRad < minTrust)
+  {
+    trustRad = minTrust;
+  }
+  //Initialize charges
+  if (Nmm > 0)
+  {
+    SaveMMField(QMMMData,QMMMOpts,bead);
+  }
+  //Initialize QM trajectory file
+  call.str("");
+  call << "QMOpt_" << bead << ".xyz";
+  qmFile.open(call.str().c_str(),ios_base::out);
+  //Build the internal coordinates
+  vector<IntCoord> intCoords = BuildIntCoords(QMMMData,bead);
+  int Nint = (int)intCoords.size(); //Number of internal coordinates
+  int Nbonds = 0; //Number of bond stretches
+  int Nangles = 0; //Number of angle bends
+  int Ntors = 0; //Number of dihedrals
+  int Ncart = 0; //Number of Cartesian anchors
+  for (int i=0;i<Nint;i++)
+  {
+    if (intCoords[i].type == 0)
+    {
+      Ncart += 1;
+    }
+    if (intCoords[i].type == 1)
+    {
+      Nbonds += 1;
+    }
+    if (intCoords[i].type == 2)
+    {
+      Nangles += 1;
+    }
+    if (intCoords[i].type == 3)
+    {
+      Ntors += 1;
+    }
+  }
+  cout << "    Internal coordinates: " << Nint;
+  cout << " (" << Nbonds << " bonds, " << Nangles << " angles, ";
+  cout << Ntors << " dihedrals, " << Ncart << " Cartesian)";
+  cout << '\n';
+  //Create optimization arrays
+  VectorXd qmPos(Ndof); //Cartesian positions of the QM and PB atoms
+  VectorXd forces(Ndof); //Cartesian forces
+  VectorXd oldForces(Ndof); //Forces from the previous step
+  VectorXd intGrad(Nint); //Gradient in internal coordinates
+  VectorXd intVals(Nint); //Values of the internal coordinates
+  MatrixXd intHess(Nint,Nint); //Hessian in internal coordinates
+  MatrixXd BMat; //Wilson B matrix
+  MatrixXd GInv; //Generalized inverse of B*B^T
+  MatrixXd proj; //Projector onto the non-redundant space
+  //Initialize arrays
+  forces.setZero();
+  oldForces.setZero();
+  intHess.setZero();
+  for (int i=0;i<Nint;i++)
+  {
+    //Diagonal model Hessian
+    intHess(i,i) = intCoords[i].kGuess;
+  }
+  int ct = 0; //Counter
+  for (int i=0;i<Natoms;i++)
+  {
+    if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+    {
+      qmPos(ct) = QMMMData[i].P[bead].x;
+      qmPos(ct+1) = QMMMData[i].P[bead].y;
+      qmPos(ct+2) = QMMMData[i].P[bead].z;
+      ct += 3;
+    }
+  }
+  //Initialize optimization variables
+  double E = 0; //Energy
+  double EOld = 0; //Energy from the previous step
+  bool optDone = 0; //Flag to end the optimization
+  //Calculate forces
+  E = LICHEMForces(QMMMData,forces,QMMMOpts,bead,1);
+  //Output initial RMS force
+  double RMSForce = sqrt(forces.squaredNorm()/Ndof); //Initial RMS force
+  cout << "    QM step: 0";
+  cout << " | RMS force: " << LICHEMFormFloat(RMSForce,12);
+  cout << " eV/\u212B";
+  cout << '\n' << '\n';
+  cout.flush();
+  //Transform the initial gradient
+  BMat = WilsonBMatrix(intCoords,qmPos);
+  GInv = IntCoordGInv(BMat);
+  proj = (BMat*BMat.transpose())*GInv;
+  intGrad = -1*GInv*(BMat*forces);
+  intVals = IntCoordValues(intCoords,qmPos);
+  //Optimize structure
+  while ((!optDone) and (stepCt < QMMMOpts.maxOptSteps))
+  {
+    //Copy old structure, energy, and forces
+    vector<QMMMAtom> oldQMMMData = QMMMData;
+    VectorXd oldIntGrad = intGrad; //Internal gradient before the step
+    VectorXd oldIntVals = intVals; //Internal coordinates before the step
+    EOld = E;
+    oldForces = forces;
+    //Determine the step in internal coordinates
+    MatrixXd projHess(Nint,Nint); //Hessian in the non-redundant space
+    projHess = proj*intHess*proj;
+    projHess += redunK*(MatrixXd::Identity(Nint,Nint)-proj);
+    VectorXd intStep = -1*projHess.ldlt().solve(proj*intGrad);
+    intStep = proj*intStep;
+    double stepMax = intStep.cwiseAbs().maxCoeff(); //Largest change
+    if (stepMax > trustRad)
+    {
+      //Scale step size
+      intStep *= (trustRad/stepMax);
+    }
+    //Transform the step back to Cartesian coordinates
+    VectorXd intTarget = intVals+intStep; //Target coordinates
+    VectorXd newPos = qmPos; //New Cartesian positions
+    VectorXd firstPos = qmPos; //Positions from the linear transformation
+    bool backDone = 0; //Flag for a converged back-transformation
+    for (int k=0;(k<maxBackSteps) and (!backDone);k++)
+    {
+      VectorXd intDiff = intTarget-IntCoordValues(intCoords,newPos);
+      for (int i=0;i<Nint;i++)
+      {
+        //Keep dihedral changes between -pi and pi
+        if (intCoords[i].type == 3)
+        {
+          while (intDiff(i) > pi)
+          {
+            intDiff(i) -= 2*pi;
+          }
+          while (intDiff(i) < -pi)
+          {
+            intDiff(i) += 2*pi;
+          }
+        }
+      }
+      VectorXd cartStep; //Cartesian displacement
+      if (k == 0)
+      {
+        cartStep = BMat.transpose()*(GInv*intDiff);
+        newPos += cartStep;
+        firstPos = newPos;
+      }
+      else
+      {
+        //Use the B matrix for the current structure
+        MatrixXd BTmp = WilsonBMatrix(intCoords,newPos);
+        cartStep = BTmp.transpose()*(IntCoordGInv(BTmp)*intDiff);
+        newPos += cartStep;
+      }
+      if (sqrt(cartStep.squaredNorm()/Ndof) < backTol)
+      {
+        backDone = 1;
+      }
+    }
+    if (!backDone)
+    {
+      //Fall back to the linear transformation
+      cout << "    Back-transformation did not converge.";
+      cout << " Using a linear step...";
+      cout << '\n';
+      newPos = firstPos;
+    }
+    //Update positions
+    ct = 0; //Reset counter
+    for (int i=0;i<Natoms;i++)
+    {
+      //Move QM atoms
+      if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+      {
+        QMMMData[i].P[bead].x = newPos(ct);
+        QMMMData[i].P[bead].y = newPos(ct+1);
+        QMMMData[i].P[bead].z = newPos(ct+2);
+        ct += 3;
+      }
+    }
+    //Calculate forces
+    E = LICHEMForces(QMMMData,forces,QMMMOpts,bead,1);
+    gradCt += 1;
+    stepCt += 1;
+    //Check the energy
+    if ((E > EOld) and (trustRad > minTrust))
+    {
+      //Reject the step and shrink the trust radius
+      cout << "    Energy did not decrease. Reducing the step size...";
+      cout << '\n';
+      QMMMData = oldQMMMData;
+      forces = oldForces;
+      E = EOld;
+      trustRad *= 0.50;
+      if (trustRad < minTrust)
+      {
+        trustRad = minTrust;
+      }
+      continue;
+    }
+    //Accept the step
+    qmPos = newPos;
+    //Update the B matrix and internal gradient for the new structure
+    BMat = WilsonBMatrix(intCoords,qmPos);
+    GInv = IntCoordGInv(BMat);
+    proj = (BMat*BMat.transpose())*GInv;
+    intGrad = -1*GInv*(BMat*forces);
+    intVals = IntCoordValues(intCoords,qmPos);
+    //Update the Hessian (BFGS)
+    VectorXd sVec = intVals-oldIntVals; //Change in the coordinates
+    for (int i=0;i<Nint;i++)
+    {
+      if (intCoords[i].type == 3)
+      {
+        while (sVec(i) > pi)
+        {
+          sVec(i) -= 2*pi;
+        }
+        while (sVec(i) < -pi)
+        {
+          sVec(i) += 2*pi;
+        }
+      }
+    }
+    VectorXd yVec = intGrad-oldIntGrad; //Change in the gradient
+    double sDotY = sVec.dot(yVec); //Curvature along the step
+    VectorXd HsVec = intHess*sVec; //Hessian times the step
+    double sHs = sVec.dot(HsVec); //Curvature of the model
+    if ((sDotY > curvTol) and (sHs > curvTol))
+    {
+      intHess += (yVec*yVec.transpose())/sDotY;
+      intHess -= (HsVec*HsVec.transpose())/sHs;
+    }
+    //Increase the trust radius
+    trustRad *= 1.20;
+    if (trustRad > QMMMOpts.maxStep)
+    {
+      trustRad = QMMMOpts.maxStep;
+    }
+    //Print structure
+    Print_traj(QMMMData,qmFile,QMMMOpts);
+    //Check convergence
+    optDone = OptConverged(QMMMData,oldQMMMData,forces,stepCt,QMMMOpts,bead,1);
+  }
+  //Print the cost of the optimization
+  cout << "    QM gradient calculations: " << (gradCt+1);
+  cout << '\n' << '\n';
+  cout.flush();
+  //Clean up files
+  call.str("");
+  call << "rm -f QMOpt_" << bead << ".xyz";
+  globalSys = system(call.str().c_str());
+  ClearMMField(bead);
+  //Finish and return
+  return;
+};
@@ -102,6 +102,13 @@ double Get_PI_Epot(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
       Es += LAMMPSEnergy(QMMMData,QMMMOpts,p);
       times_mm += (unsigned)time(0)-t_mm_start;
     }
+    if (QMMMOpts.GEMDisp)
+    {
+      //NB: The neighbor list of the bead is reused between MC steps
+      t_mm_start = (unsigned)time(0);
+      Es += GEMDispEnergy(QMMMData,gemNbrLists[p],p);
+      times_mm += (unsigned)time(0)-t_mm_start;
+    }
     //Add temp variables to the totals
     E += Es;
     QMTime += times_qm;
@@ -221,6 +228,8 @@ bool MCMove(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts, double& Emc)
       Ly += 2*(randNum-0.5)*mcStep;
       Lz += 2*(randNum-0.5)*mcStep;
     }
+    //Update the periodic cell
+    pbcBox.update();
     //Decide how to scale the centroids
     bool scaleRing = 0; //Shift the ring
     randNum = (((double)rand())/((double)RAND_MAX));
@@ -440,7 +449,7 @@ bool MCMove(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts, double& Emc)
   if (QMMMOpts.ensemble == "NPT")
   {
     //Add PV energy term
-    ENew += QMMMOpts.press*Lx*Ly*Lz;
+    ENew += QMMMOpts.press*pbcBox.volume();
   }
   //Accept or reject
   double dE = QMMMOpts.beta*(ENew-EOld);
@@ -472,6 +481,7 @@ bool MCMove(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts, double& Emc)
     Lx = LxSave;
     Ly = LySave;
     Lz = LzSave;
+    pbcBox.update();
   }
   //Return decision
   return acc;
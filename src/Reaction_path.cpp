@@ -16,7 +16,15 @@
  the work is published.
 
  References for NEB:
- 
+ Henkelman et al., J. Chem. Phys., 113, 22, 9901, (2000)
+ Henkelman and Jonsson, J. Chem. Phys., 113, 22, 9978, (2000)
+
+ Reference for FIRE:
+ Bitzek et al., Phys. Rev. Lett., 97, 17, 170201, (2006)
+
+ References for the string method:
+ E et al., J. Chem. Phys., 126, 16, 164103, (2007)
+ Peters et al., J. Chem. Phys., 120, 17, 7877, (2004)
 
  References for global DFP:
  
@@ -27,7 +35,17 @@
 void CheckNEBTangent(VectorXd& tangent)
 {
   //Check if the tangent is reasonable
-  
+  double tanNorm = tangent.norm(); //Length of the tangent
+  if ((tanNorm < 1e-10) or (tanNorm != tanNorm))
+  {
+    //Remove zero length and undefined tangents
+    tangent.setZero();
+  }
+  else
+  {
+    //Normalize the tangent
+    tangent /= tanNorm;
+  }
   return;
 };
 
@@ -35,49 +53,1499 @@ VectorXd CINEBTangent(VectorXd& distp1, VectorXd& distm1,
                       QMMMSettings& QMMMOpts, int bead)
 {
   //Calculate climbing image nudged elastic band tangents
-  
+  //NB: The climbing image is the highest energy bead, so the tangent
+  //bisects the displacements to both neighbors
   //Initialize tangent and structures
   VectorXd QMTangent(3*(Nqm+Npseudo));
-  
+  QMTangent.setZero();
+  //Add the normalized displacements
+  if (distp1.norm() > 0)
+  {
+    QMTangent += distp1/distp1.norm();
+  }
+  if (distm1.norm() > 0)
+  {
+    QMTangent += distm1/distm1.norm();
+  }
+  CheckNEBTangent(QMTangent);
   return QMTangent;
 };
 
-VectorXd NEBTangent(VectorXd& distp1, VectorXd& distm1,
+VectorXd NEBTangent(VectorXd& distp1, VectorXd& distm1, VectorXd& pathE,
                     QMMMSettings& QMMMOpts, int bead)
 {
   //Calculate nudged elastic band tangents
-  
+  //NB: The tangent points towards the neighboring bead with the higher
+  //energy, and it is mixed at extrema to avoid kinks in the path
   //Initialize tangent and structures
   VectorXd QMTangent(3*(Nqm+Npseudo));
-  
+  double Ep1 = pathE(bead+1); //Energy of the next bead
+  double Em1 = pathE(bead-1); //Energy of the previous bead
+  double E = pathE(bead); //Energy of the current bead
+  if ((Ep1 > E) and (E > Em1))
+  {
+    //Uphill towards the next bead
+    QMTangent = distp1;
+  }
+  else if ((Ep1 < E) and (E < Em1))
+  {
+    //Uphill towards the previous bead
+    QMTangent = distm1;
+  }
+  else
+  {
+    //Energy weighted tangent at an extremum
+    double dEMax = abs(Ep1-E); //Largest energy difference
+    double dEMin = abs(Em1-E); //Smallest energy difference
+    if (dEMax < dEMin)
+    {
+      dEMax = abs(Em1-E);
+      dEMin = abs(Ep1-E);
+    }
+    if (Ep1 > Em1)
+    {
+      QMTangent = dEMax*distp1+dEMin*distm1;
+    }
+    else
+    {
+      QMTangent = dEMin*distp1+dEMax*distm1;
+    }
+  }
+  CheckNEBTangent(QMTangent);
   return QMTangent;
 };
 
+void PathDisplacements(vector<QMMMAtom>& QMMMData, VectorXd& distp1,
+                       VectorXd& distm1, int bead)
+{
+  //Calculate the displacements to the neighboring beads
+  //NB: For isolated QM regions the neighbors are superimposed on the
+  //current bead, and the components of inactive atoms are removed
+  MatrixXd geom((Nqm+Npseudo),3); //Current bead
+  MatrixXd geomp1((Nqm+Npseudo),3); //Next bead
+  MatrixXd geomm1((Nqm+Npseudo),3); //Previous bead
+  int ct = 0; //Counter for the number of atoms
+  for (int i=0;i<Natoms;i++)
+  {
+    //Only include QM and PB regions
+    if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+    {
+      geom(ct,0) = QMMMData[i].P[bead].x;
+      geom(ct,1) = QMMMData[i].P[bead].y;
+      geom(ct,2) = QMMMData[i].P[bead].z;
+      geomp1(ct,0) = QMMMData[i].P[bead+1].x;
+      geomp1(ct,1) = QMMMData[i].P[bead+1].y;
+      geomp1(ct,2) = QMMMData[i].P[bead+1].z;
+      geomm1(ct,0) = QMMMData[i].P[bead-1].x;
+      geomm1(ct,1) = QMMMData[i].P[bead-1].y;
+      geomm1(ct,2) = QMMMData[i].P[bead-1].z;
+      ct += 1;
+    }
+  }
+  //Calculate displacements
+  if (QMMM or PBCon)
+  {
+    //The environment fixes the orientation of the QM region
+    for (int i=0;i<(Nqm+Npseudo);i++)
+    {
+      for (int j=0;j<3;j++)
+      {
+        distp1(3*i+j) = geomp1(i,j)-geom(i,j);
+        distm1(3*i+j) = geom(i,j)-geomm1(i,j);
+      }
+    }
+  }
+  else
+  {
+    //Superimpose the neighbors (KabschDisplacement moves both structures)
+    MatrixXd geomTmp = geom; //Copy of the current bead
+    distp1 = -1*KabschDisplacement(geomTmp,geomp1,(Nqm+Npseudo));
+    geomTmp = geom;
+    distm1 = KabschDisplacement(geomTmp,geomm1,(Nqm+Npseudo));
+  }
+  //Remove inactive atoms
+  ct = 0; //Reset counter for the number of atoms
+  for (int i=0;i<Natoms;i++)
+  {
+    //Only include QM and PB regions
+    if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+    {
+      //Only include active atoms in the tangent
+      if (!QMMMData[i].NEBActive)
+      {
+        for (int j=0;j<3;j++)
+        {
+          distp1(ct+j) = 0;
+          distm1(ct+j) = 0;
+        }
+      }
+      ct += 3;
+    }
+  }
+  return;
+};
+
+//Path analysis functions
+VectorXd PathReactCoord(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
+{
+  //Calculate the normalized reaction coordinate of each bead
+  VectorXd reactCoord(QMMMOpts.NBeads); //Reaction coordinate
+  reactCoord.setZero();
+  for (int p=0;p<(QMMMOpts.NBeads-1);p++)
+  {
+    MatrixXd geom1((Nqm+Npseudo),3); //Current replica
+    MatrixXd geom2((Nqm+Npseudo),3); //Next replica
+    VectorXd disp; //Store the displacement
+    //Save geometries
+    int ct = 0; //Reset counter for the number of atoms
+    for (int i=0;i<Natoms;i++)
+    {
+      //Only include QM and PB regions
+      if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+      {
+        //Save current replica
+        geom1(ct,0) = QMMMData[i].P[p].x;
+        geom1(ct,1) = QMMMData[i].P[p].y;
+        geom1(ct,2) = QMMMData[i].P[p].z;
+        //Save replica p+1
+        geom2(ct,0) = QMMMData[i].P[p+1].x;
+        geom2(ct,1) = QMMMData[i].P[p+1].y;
+        geom2(ct,2) = QMMMData[i].P[p+1].z;
+        ct += 1;
+      }
+    }
+    //Calculate displacement
+    disp = KabschDisplacement(geom1,geom2,(Nqm+Npseudo));
+    //Remove inactive atoms
+    ct = 0; //Reset counter for the number of atoms
+    for (int i=0;i<Natoms;i++)
+    {
+      //Only include QM and PB regions
+      if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+      {
+        //Only include active atoms in the tangent
+        if (!QMMMData[i].NEBActive)
+        {
+          //Delete distance components
+          disp(ct) = 0;
+          disp(ct+1) = 0;
+          disp(ct+2) = 0;
+        }
+        //Advance counter
+        ct += 3;
+      }
+    }
+    //Update reaction coordinate
+    reactCoord(p+1) = reactCoord(p); //Start from previous bead
+    reactCoord(p+1) += disp.norm(); //Add magnitude of the displacement
+  }
+  if (reactCoord.maxCoeff() > 0)
+  {
+    reactCoord /= reactCoord.maxCoeff(); //Must be between 0 and 1
+  }
+  return reactCoord;
+};
+
+MatrixXd PathCoords(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts)
+{
+  //Collect the QM and PB coordinates of all beads
+  MatrixXd pathGeom(3*(Nqm+Npseudo),QMMMOpts.NBeads); //Bead coordinates
+  int ct = 0; //Counter for QM and PB atoms
+  for (int i=0;i<Natoms;i++)
+  {
+    if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+    {
+      for (int p=0;p<QMMMOpts.NBeads;p++)
+      {
+        pathGeom(ct,p) = QMMMData[i].P[p].x;
+        pathGeom(ct+1,p) = QMMMData[i].P[p].y;
+        pathGeom(ct+2,p) = QMMMData[i].P[p].z;
+      }
+      ct += 3;
+    }
+  }
+  return pathGeom;
+};
+
+double PathCoordDev(MatrixXd& geom1, MatrixXd& geom2, int bead1, int bead2)
+{
+  //Calculate the RMS deviation between two columns of bead coordinates
+  double RMSDev = (geom1.col(bead1)-geom2.col(bead2)).squaredNorm();
+  RMSDev = sqrt(RMSDev/(Nqm+Npseudo));
+  return RMSDev;
+};
+
+void PathReparam(vector<QMMMAtom>& QMMMData, VectorXd& arcFrac,
+                 int firstBead, int lastBead)
+{
+  //Redistribute the beads between firstBead and lastBead along the path
+  //NB: The beads are placed at their target fractions of the arc length
+  //on the piecewise linear path, and the two end beads are not moved
+  int Nseg = lastBead-firstBead; //Number of path segments
+  int Ndof = 3*(Nqm+Npseudo); //Number of QM and PB degrees of freedom
+  if (Nseg < 2)
+  {
+    //No beads between the end points
+    return;
+  }
+  //Save the QM and PB coordinates
+  MatrixXd geom(Ndof,(Nseg+1)); //Coordinates of the beads
+  VectorXd activeDOF(Ndof); //Components included in the arc length
+  int ct = 0; //Counter for QM and PB atoms
+  for (int i=0;i<Natoms;i++)
+  {
+    //Only include QM and PB regions
+    if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+    {
+      for (int p=0;p<=Nseg;p++)
+      {
+        geom(ct,p) = QMMMData[i].P[firstBead+p].x;
+        geom(ct+1,p) = QMMMData[i].P[firstBead+p].y;
+        geom(ct+2,p) = QMMMData[i].P[firstBead+p].z;
+      }
+      for (int j=0;j<3;j++)
+      {
+        activeDOF(ct+j) = 0;
+        if (QMMMData[i].NEBActive)
+        {
+          activeDOF(ct+j) = 1;
+        }
+      }
+      ct += 3;
+    }
+  }
+  //Calculate the arc length
+  VectorXd arcLen(Nseg+1); //Arc length at each bead
+  arcLen(0) = 0;
+  for (int p=0;p<Nseg;p++)
+  {
+    VectorXd disp = geom.col(p+1)-geom.col(p); //Segment displacement
+    arcLen(p+1) = arcLen(p)+disp.cwiseProduct(activeDOF).norm();
+  }
+  double fracRange = arcFrac(lastBead)-arcFrac(firstBead);
+  if ((arcLen(Nseg) < 1e-10) or (fracRange <= 0))
+  {
+    //The path is too short to reparameterize
+    return;
+  }
+  //Interpolate the new positions
+  MatrixXd newGeom = geom; //Reparameterized coordinates
+  int seg = 0; //Current path segment
+  for (int p=1;p<Nseg;p++)
+  {
+    //Arc length of the target position
+    double target = (arcFrac(firstBead+p)-arcFrac(firstBead))/fracRange;
+    target *= arcLen(Nseg);
+    while ((seg < (Nseg-1)) and (arcLen(seg+1) < target))
+    {
+      seg += 1;
+    }
+    double segLen = arcLen(seg+1)-arcLen(seg); //Length of the segment
+    double wt = 0; //Interpolation weight
+    if (segLen > 1e-10)
+    {
+      wt = (target-arcLen(seg))/segLen;
+    }
+    newGeom.col(p) = (1-wt)*geom.col(seg)+wt*geom.col(seg+1);
+  }
+  //Update the coordinates
+  ct = 0; //Reset counter for QM and PB atoms
+  for (int i=0;i<Natoms;i++)
+  {
+    if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+    {
+      if (!QMMMData[i].frozen)
+      {
+        for (int p=1;p<Nseg;p++)
+        {
+          QMMMData[i].P[firstBead+p].x = newGeom(ct,p);
+          QMMMData[i].P[firstBead+p].y = newGeom(ct+1,p);
+          QMMMData[i].P[firstBead+p].z = newGeom(ct+2,p);
+        }
+      }
+      ct += 3;
+    }
+  }
+  return;
+};
+
+int PathGrowthBead(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
+                   VectorXd& pathE)
+{
+  //Locate the segment of the string which needs another bead
+  //NB: Segments are refined when the path turns by more than 30 degrees
+  //at either end, or when the energy changes by more than a quarter of
+  //the barrier near the top of the path
+  int newBead = -1; //Position of the new bead
+  int Ndof = 3*(Nqm+Npseudo); //Number of QM and PB degrees of freedom
+  int Nbeads = QMMMOpts.NBeads; //Number of beads on the path
+  double maxAng = 30*pi/180; //Largest turning angle on a resolved path
+  double bestScore = 1; //Segments with larger scores are refined
+  double EMin = pathE.minCoeff(); //Lowest energy on the path
+  double dERange = pathE.maxCoeff()-EMin; //Energy span of the path
+  //Calculate the turning angle at each bead
+  VectorXd turnAng(Nbeads);
+  turnAng.setZero();
+  for (int p=1;p<(Nbeads-1);p++)
+  {
+    VectorXd distp1(Ndof); //Displacement to the next bead
+    VectorXd distm1(Ndof); //Displacement from the previous bead
+    PathDisplacements(QMMMData,distp1,distm1,p);
+    double distNorm = distp1.norm()*distm1.norm();
+    if (distNorm > 1e-10)
+    {
+      double cosAng = distp1.dot(distm1)/distNorm;
+      if (cosAng > 1)
+      {
+        cosAng = 1;
+      }
+      if (cosAng < -1)
+      {
+        cosAng = -1;
+      }
+      turnAng(p) = acos(cosAng);
+    }
+  }
+  //Score the segments
+  for (int p=0;p<(Nbeads-1);p++)
+  {
+    double score = turnAng(p); //Curvature score
+    if (turnAng(p+1) > score)
+    {
+      score = turnAng(p+1);
+    }
+    score /= maxAng;
+    if (dERange > 0)
+    {
+      //Energy score weighted by the height of the segment
+      double EHigh = pathE(p); //Highest energy of the segment
+      if (pathE(p+1) > EHigh)
+      {
+        EHigh = pathE(p+1);
+      }
+      double EScore = abs(pathE(p+1)-pathE(p))/(0.25*dERange);
+      EScore *= (EHigh-EMin)/dERange;
+      if (EScore > score)
+      {
+        score = EScore;
+      }
+    }
+    if (score > bestScore)
+    {
+      //Save the segment
+      bestScore = score;
+      newBead = p+1;
+    }
+  }
+  return newBead;
+};
+
+void PathInsertBead(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
+                    int bead)
+{
+  //Insert a new bead halfway between beads bead-1 and bead
+  stringstream call; //Stream for system calls
+  //Move the checkpoint files of the later beads
+  for (int p=(QMMMOpts.NBeads-1);p>=bead;p--)
+  {
+    if (Gaussian and (QMMMOpts.func != "SemiEmp"))
+    {
+      call.str("");
+      call << "mv LICHM_" << p << ".chk ";
+      call << "LICHM_" << (p+1) << ".chk";
+      call << " 2> LICHM_" << (p+1) << ".trash; ";
+      call << "rm -f LICHM_" << (p+1) << ".trash";
+      globalSys = system(call.str().c_str());
+    }
+    if (PSI4)
+    {
+      call.str("");
+      call << "mv LICHM_" << p << ".180 ";
+      call << "LICHM_" << (p+1) << ".180";
+      call << " 2> LICHM_" << (p+1) << ".trash; ";
+      call << "rm -f LICHM_" << (p+1) << ".trash";
+      globalSys = system(call.str().c_str());
+    }
+  }
+  //Start the new bead from the checkpoint of the previous bead
+  if (Gaussian and (QMMMOpts.func != "SemiEmp"))
+  {
+    call.str("");
+    call << "cp LICHM_" << (bead-1) << ".chk ";
+    call << "LICHM_" << bead << ".chk";
+    call << " 2> LICHM_" << bead << ".trash; ";
+    call << "rm -f LICHM_" << bead << ".trash";
+    globalSys = system(call.str().c_str());
+  }
+  if (PSI4)
+  {
+    call.str("");
+    call << "cp LICHM_" << (bead-1) << ".180 ";
+    call << "LICHM_" << bead << ".180";
+    call << " 2> LICHM_" << bead << ".trash; ";
+    call << "rm -f LICHM_" << bead << ".trash";
+    globalSys = system(call.str().c_str());
+  }
+  //Create the new bead
+  #pragma omp parallel for schedule(dynamic)
+  for (int i=0;i<Natoms;i++)
+  {
+    Coord newPos = QMMMData[i].P[bead-1]; //Midpoint of the segment
+    newPos.x = 0.5*(QMMMData[i].P[bead-1].x+QMMMData[i].P[bead].x);
+    newPos.y = 0.5*(QMMMData[i].P[bead-1].y+QMMMData[i].P[bead].y);
+    newPos.z = 0.5*(QMMMData[i].P[bead-1].z+QMMMData[i].P[bead].z);
+    MPole newMP = QMMMData[i].MP[bead-1]; //Copy of the multipoles
+    OctCharges newPC = QMMMData[i].PC[bead-1]; //Copy of the point-charges
+    QMMMData[i].P.insert(QMMMData[i].P.begin()+bead,newPos);
+    QMMMData[i].MP.insert(QMMMData[i].MP.begin()+bead,newMP);
+    QMMMData[i].PC.insert(QMMMData[i].PC.begin()+bead,newPC);
+  }
+  //Update the path settings
+  QMMMOpts.NBeads += 1;
+  if (QMMMOpts.TSBead >= bead)
+  {
+    QMMMOpts.TSBead += 1;
+  }
+  return;
+};
+
+//Path force and update functions
+int PathForces(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
+               vector<int>& evalBeads, VectorXd& pathE,
+               MatrixXd& pathForces)
+{
+  //Calculates the energies and forces of a list of beads concurrently
+  //NB: The QM and MM gradients run together, so the wall time is
+  //collected as QM time
+  int Neval = evalBeads.size(); //Number of gradient calculations
+  int Ndof = 3*(Nqm+Npseudo); //Number of QM and PB degrees of freedom
+  //Split the processors between the beads
+  int Njobs = Neval; //Number of concurrent gradients
+  if (Njobs > Ncpus)
+  {
+    Njobs = Ncpus;
+  }
+  if (Njobs < 1)
+  {
+    Njobs = 1;
+  }
+  int oldNcpus = Ncpus; //Save the number of processors
+  Ncpus /= Njobs;
+  int tStart = (unsigned)time(0);
+  #pragma omp parallel for schedule(dynamic) num_threads(Njobs)
+  for (int j=0;j<Neval;j++)
+  {
+    int p = evalBeads[j]; //Bead ID
+    VectorXd forces(Ndof); //Forces on the bead
+    pathE(p) = LICHEMForces(QMMMData,forces,QMMMOpts,p,0);
+    pathForces.col(p) = forces;
+  }
+  QMTime += (unsigned)time(0)-tStart;
+  Ncpus = oldNcpus; //Restore the number of processors
+  if (PSI4)
+  {
+    //Delete annoying useless files
+    globalSys = system("rm -f psi.* timer.*");
+  }
+  return Neval;
+};
+
+void PathProjForces(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
+                    VectorXd& pathE, MatrixXd& pathForces,
+                    MatrixXd& projForces, MatrixXd& forceStats,
+                    int pathStart, int pathEnd, bool useSprings)
+{
+  //Locates the climbing image and projects the forces on the path
+  //NB: The parallel forces are removed from the intermediate beads, and
+  //the NEB springs are only added when useSprings is true
+  int Ndof = 3*(Nqm+Npseudo); //Number of QM and PB degrees of freedom
+  int Nbeads = QMMMOpts.NBeads; //Number of beads on the path
+  //Locate the climbing image
+  QMMMOpts.TSBead = 1;
+  for (int p=1;p<(Nbeads-1);p++)
+  {
+    if (pathE(p) > pathE(QMMMOpts.TSBead))
+    {
+      QMMMOpts.TSBead = p;
+    }
+  }
+  //Project the forces
+  projForces.setZero();
+  forceStats.setZero();
+  for (int p=pathStart;p<pathEnd;p++)
+  {
+    if ((p == 0) or (p == (Nbeads-1)))
+    {
+      //End points are minimized
+      projForces.col(p) = pathForces.col(p);
+    }
+    else
+    {
+      VectorXd distp1(Ndof); //Displacement to the next bead
+      VectorXd distm1(Ndof); //Displacement from the previous bead
+      VectorXd tangent(Ndof); //Path tangent
+      PathDisplacements(QMMMData,distp1,distm1,p);
+      if (QMMMOpts.climb and (p == QMMMOpts.TSBead))
+      {
+        //Invert the parallel force on the climbing image
+        tangent = CINEBTangent(distp1,distm1,QMMMOpts,p);
+        double fPar = pathForces.col(p).dot(tangent);
+        projForces.col(p) = pathForces.col(p)-2*fPar*tangent;
+      }
+      else
+      {
+        //Remove the parallel force
+        tangent = NEBTangent(distp1,distm1,pathE,QMMMOpts,p);
+        double fPar = pathForces.col(p).dot(tangent);
+        projForces.col(p) = pathForces.col(p)-fPar*tangent;
+        if (useSprings)
+        {
+          //Add the spring force
+          double fSpring = QMMMOpts.kSpring*(distp1.norm()-distm1.norm());
+          projForces.col(p) += fSpring*tangent;
+        }
+      }
+    }
+    //Save force statistics
+    forceStats(p,0) = projForces.col(p).cwiseAbs().maxCoeff();
+    forceStats(p,1) = sqrt(projForces.col(p).squaredNorm()/Ndof);
+  }
+  return;
+};
+
+void PathFIREStep(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
+                  MatrixXd& projForces, MatrixXd& velocity, FIREState& fire,
+                  int pathStart, int pathEnd)
+{
+  //Moves the beads with one step of the FIRE algorithm
+  //NB: Beads which should not move must have zero forces and velocities
+  if (projForces.norm() == 0)
+  {
+    //Nothing to move
+    return;
+  }
+  //Update velocities
+  double vDotF = 0; //Overlap of the velocities and forces
+  for (int p=pathStart;p<pathEnd;p++)
+  {
+    vDotF += velocity.col(p).dot(projForces.col(p));
+  }
+  if (vDotF > 0)
+  {
+    //Steer the velocities towards the forces
+    double vNorm = velocity.norm();
+    double fNorm = projForces.norm();
+    velocity *= (1-fire.alpha);
+    velocity += fire.alpha*(vNorm/fNorm)*projForces;
+    if (fire.downhillCt > fireMinDownhill)
+    {
+      fire.dt *= fireDtInc;
+      if (fire.dt > fire.dtMax)
+      {
+        fire.dt = fire.dtMax;
+      }
+      fire.alpha *= fireAlphaDec;
+    }
+    fire.downhillCt += 1;
+  }
+  else
+  {
+    //Stop after an uphill step
+    velocity.setZero();
+    fire.alpha = fireAlpha;
+    fire.dt *= fireDtDec;
+    fire.downhillCt = 0;
+  }
+  velocity += fire.dt*projForces;
+  //Check step size
+  MatrixXd pathStep = fire.dt*velocity; //Displacements of all beads
+  double vecMax = 0; //Largest atomic displacement
+  for (int p=pathStart;p<pathEnd;p++)
+  {
+    for (int i=0;i<(Nqm+Npseudo);i++)
+    {
+      double stepLen = pathStep.block(3*i,p,3,1).norm();
+      if (stepLen > vecMax)
+      {
+        vecMax = stepLen;
+      }
+    }
+  }
+  if (vecMax > QMMMOpts.maxStep)
+  {
+    //Scale the step
+    pathStep *= (QMMMOpts.maxStep/vecMax);
+    velocity *= (QMMMOpts.maxStep/vecMax);
+  }
+  //Move the beads
+  #pragma omp parallel for schedule(dynamic)
+  for (int p=pathStart;p<pathEnd;p++)
+  {
+    int ct = 0; //Counter for QM and PB atoms
+    for (int i=0;i<Natoms;i++)
+    {
+      if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+      {
+        QMMMData[i].P[p].x += pathStep(ct,p);
+        QMMMData[i].P[p].y += pathStep(ct+1,p);
+        QMMMData[i].P[p].z += pathStep(ct+2,p);
+        ct += 3;
+      }
+    }
+  }
+  return;
+};
+
+void PathMMFields(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
+                  bool saveFields)
+{
+  //Saves the MM fields of all beads for the QM wrappers, or removes them
+  //when the path optimization is finished
+  //NB: The fields depend on the QM center of mass through the PBC, LREC,
+  //and multipole compression, so they are saved again after the beads move
+  for (int p=0;p<QMMMOpts.NBeads;p++)
+  {
+    if (saveFields and (Nmm > 0))
+    {
+      SaveMMField(QMMMData,QMMMOpts,p);
+    }
+    else
+    {
+      ClearMMField(p);
+    }
+  }
+  return;
+};
+
 //Convergence test functions
 bool PathConverged(vector<QMMMAtom>& QMMMData, vector<QMMMAtom>& oldQMMMData,
                    MatrixXd& forceStats, int stepCt, QMMMSettings& QMMMOpts,
                    bool QMRegion)
 {
   //Check convergence of QMMM optimizations
-  bool pathDone = 1;
-  
+  bool pathDone = 0;
+  double RMSDiff = 0; //Largest RMS deviation on the path
+  double RMSForce = 0; //Largest RMS force on the path
+  double maxForce = 0; //Largest force on the path
+  //Convergence criteria
+  double maxFTol = 20*QMMMOpts.QMOptTol; //Opt. tolerance for max. force
+  double RMSFTol = 10*QMMMOpts.QMOptTol; //Opt. tolerance for RMS force
+  //Set the optimized beads
+  int pathStart = 0; //First bead to optimize
+  int pathEnd = QMMMOpts.NBeads; //Last bead to optimize
+  if (QMMMOpts.frznEnds)
+  {
+    //Change the start and end points
+    pathStart = 1;
+    pathEnd = QMMMOpts.NBeads-1;
+  }
+  //Check progress
+  if (QMRegion)
+  {
+    //Check if the QM part of the path is converged
+    for (int p=pathStart;p<pathEnd;p++)
+    {
+      double beadDiff = ConvRMSDev(QMMMData,oldQMMMData,QMMMOpts,p,1);
+      if (beadDiff > RMSDiff)
+      {
+        RMSDiff = beadDiff;
+      }
+      if (forceStats(p,0) > maxForce)
+      {
+        maxForce = forceStats(p,0);
+      }
+      if (forceStats(p,1) > RMSForce)
+      {
+        RMSForce = forceStats(p,1);
+      }
+    }
+    //Print progress
+    cout << "    QM step: " << stepCt;
+    cout << " | RMS dev: " << LICHEMFormFloat(RMSDiff,12);
+    cout << " \u212B" << '\n';
+    cout << "    Max. force: " << LICHEMFormFloat(maxForce,12);
+    cout << " eV/\u212B | RMS force: " << LICHEMFormFloat(RMSForce,12);
+    cout << " eV/\u212B" << '\n';
+    //Check convergence criteria
+    if ((RMSDiff <= QMMMOpts.QMOptTol) and (RMSForce <= RMSFTol) and
+       (maxForce <= maxFTol))
+    {
+      pathDone = 1;
+      cout << "    QM path optimization complete." << '\n';
+    }
+    cout << '\n';
+    cout.flush();
+  }
+  if (!QMRegion)
+  {
+    //Check energy and convergence of the whole path
+    VectorXd pathE(QMMMOpts.NBeads); //Bead energies
+    pathE.setZero();
+    //Split the processors between the beads
+    int Njobs = QMMMOpts.NBeads; //Number of concurrent energies
+    if (Njobs > Ncpus)
+    {
+      Njobs = Ncpus;
+    }
+    if (Njobs < 1)
+    {
+      Njobs = 1;
+    }
+    int oldNcpus = Ncpus; //Save the number of processors
+    Ncpus /= Njobs;
+    //Calculate the energies of all beads
+    //NB: The QM and MM energies run together, so the wall time is
+    //collected as QM time
+    int tStart = (unsigned)time(0);
+    #pragma omp parallel for schedule(dynamic) num_threads(Njobs)
+    for (int p=0;p<QMMMOpts.NBeads;p++)
+    {
+      double sumE = 0; //Energy of the bead
+      //Calculate QM energy
+      if (Gaussian)
+      {
+        sumE += GaussianEnergy(QMMMData,QMMMOpts,p);
+      }
+      if (PSI4)
+      {
+        sumE += PSI4Energy(QMMMData,QMMMOpts,p);
+      }
+      if (NWChem)
+      {
+        sumE += NWChemEnergy(QMMMData,QMMMOpts,p);
+      }
+      //Calculate MM energy
+      if (TINKER)
+      {
+        sumE += TINKEREnergy(QMMMData,QMMMOpts,p);
+      }
+      if (LAMMPS)
+      {
+        sumE += LAMMPSEnergy(QMMMData,QMMMOpts,p);
+      }
+      pathE(p) = sumE;
+    }
+    QMTime += (unsigned)time(0)-tStart;
+    Ncpus = oldNcpus; //Restore the number of processors
+    if (PSI4)
+    {
+      //Delete annoying useless files
+      globalSys = system("rm -f psi.* timer.*");
+    }
+    //Check if the string grew during the QM optimization
+    bool pathGrew = 0;
+    if (oldQMMMData[0].P.size() != QMMMData[0].P.size())
+    {
+      pathGrew = 1;
+    }
+    //Update the reactant, product, and transition state
+    QMMMOpts.EReact = pathE(0);
+    QMMMOpts.EProd = pathE(QMMMOpts.NBeads-1);
+    QMMMOpts.ETrans = -1*hugeNum;
+    for (int p=0;p<QMMMOpts.NBeads;p++)
+    {
+      if (pathE(p) > QMMMOpts.ETrans)
+      {
+        QMMMOpts.TSBead = p;
+        QMMMOpts.ETrans = pathE(p);
+      }
+      //Calculate RMS displacement
+      if (!pathGrew)
+      {
+        double beadDiff = ConvRMSDev(QMMMData,oldQMMMData,QMMMOpts,p,0);
+        if (beadDiff > RMSDiff)
+        {
+          RMSDiff = beadDiff;
+        }
+      }
+    }
+    //Print progress
+    VectorXd reactCoord = PathReactCoord(QMMMData,QMMMOpts);
+    cout << " | Opt. step: " << stepCt << " | Bead energies:";
+    cout << '\n';
+    for (int p=0;p<QMMMOpts.NBeads;p++)
+    {
+      cout << "   Bead: ";
+      cout << setw(LICHEMCount(QMMMOpts.NBeads)) << p;
+      cout << " | React. coord: ";
+      cout << LICHEMFormFloat(reactCoord(p),5);
+      cout << " | Energy: ";
+      cout << LICHEMFormFloat(pathE(p),16) << " eV";
+      cout << '\n';
+    }
+    if (pathGrew)
+    {
+      //The old path cannot be compared
+      cout << " | Path grew to " << QMMMOpts.NBeads << " beads" << '\n';
+    }
+    else
+    {
+      cout << " | RMS dev: " << LICHEMFormFloat(RMSDiff,12);
+      cout << " \u212B" << '\n';
+    }
+    //Check convergence
+    if ((!pathGrew) and (RMSDiff <= QMMMOpts.MMOptTol))
+    {
+      pathDone = 1;
+      if (QMMM and (stepCt > 1))
+      {
+        cout << "    QMMM relaxation satisfactory.";
+        cout << '\n';
+      }
+    }
+    //Flush output
+    cout.flush();
+  }
   return pathDone;
 };
 
 //Path optimization routines
-void LICHEMNEB(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts, int optCt)
+void LICHEMNEB(vector<QMMMAtom>& QMMMData, MatrixXd& pathForces,
+               QMMMSettings& QMMMOpts, VectorXd& pathE,
+               vector<int>& beadActive, int optCt)
 {
-  //Cartesian NEB optimizer which runs sequentially
-  
+  //Cartesian climbing image NEB optimizer for the QM and PB atoms
+  //NB: The forces on the active beads are calculated concurrently and the
+  //whole path is moved with the FIRE algorithm. Converged beads are frozen,
+  //and their saved gradients are reused until they or their neighbors move
+  //beyond the QM tolerance. On input, beadActive flags the beads which
+  //changed since their forces were saved. On output, it flags the beads
+  //which were moved.
+  int stepCt = 0; //Counter for optimization steps
+  int gradCt = 0; //Counter for bead gradient calculations
+  int Ndof = 3*(Nqm+Npseudo); //Number of QM and PB degrees of freedom
+  int Nbeads = QMMMOpts.NBeads; //Number of beads on the path
+  //Convergence criteria
+  double maxFTol = 20*QMMMOpts.QMOptTol; //Opt. tolerance for max. force
+  double RMSFTol = 10*QMMMOpts.QMOptTol; //Opt. tolerance for RMS force
+  FIREState fire; //FIRE time step and mixing
+  fire.reset(0.1*QMMMOpts.stepScale);
+  //Set the optimized beads
+  int pathStart = 0; //First bead to optimize
+  int pathEnd = Nbeads; //Last bead to optimize
+  if (QMMMOpts.frznEnds)
+  {
+    //Change the start and end points
+    pathStart = 1;
+    pathEnd = Nbeads-1;
+  }
+  //Start climbing after the loose first relaxation of the path
+  if ((!QMMMOpts.climb) and (optCt > 0))
+  {
+    QMMMOpts.climb = 1;
+    cout << "    Starting climbing image NEB.";
+    cout << '\n' << '\n';
+    cout.flush();
+  }
+  //Initialize charges
+  PathMMFields(QMMMData,QMMMOpts,1);
+  //Create arrays
+  MatrixXd NEBForces(Ndof,Nbeads); //Projected NEB forces
+  MatrixXd velocity(Ndof,Nbeads); //FIRE velocities
+  MatrixXd forceStats(Nbeads,2); //Max. and RMS NEB forces
+  MatrixXd startGeom = PathCoords(QMMMData,QMMMOpts); //Initial path
+  MatrixXd evalGeom = startGeom; //Structures of the saved gradients
+  MatrixXd wakeGeomM1(Ndof,Nbeads); //Previous beads when frozen
+  MatrixXd wakeGeomP1(Ndof,Nbeads); //Next beads when frozen
+  vector<int> beadFrozen(Nbeads,0); //Flags for converged beads
+  vector<QMMMAtom> oldQMMMData = QMMMData; //Previous structure
+  //Initialize arrays
+  velocity.setZero();
+  wakeGeomM1.setZero();
+  wakeGeomP1.setZero();
+  //Optimize path
+  bool pathDone = 0;
+  while ((!pathDone) and (stepCt < QMMMOpts.maxOptSteps))
+  {
+    //Select the beads which need new gradients
+    //NB: Frozen end points are only calculated when they change
+    MatrixXd pathGeom = PathCoords(QMMMData,QMMMOpts);
+    vector<int> evalBeads; //Beads to evaluate
+    for (int p=0;p<Nbeads;p++)
+    {
+      if (stepCt == 0)
+      {
+        if (beadActive[p])
+        {
+          evalBeads.push_back(p);
+        }
+      }
+      else if (PathCoordDev(pathGeom,evalGeom,p,p) > 0)
+      {
+        if (beadFrozen[p])
+        {
+          //Wake up the bead if it or its neighbors moved too far
+          if (PathCoordDev(pathGeom,evalGeom,p,p) > QMMMOpts.QMOptTol)
+          {
+            beadFrozen[p] = 0;
+          }
+          if ((p > 0) and (PathCoordDev(pathGeom,wakeGeomM1,(p-1),p) >
+             QMMMOpts.QMOptTol))
+          {
+            beadFrozen[p] = 0;
+          }
+          if ((p < (Nbeads-1)) and (PathCoordDev(pathGeom,wakeGeomP1,(p+1),p)
+             > QMMMOpts.QMOptTol))
+          {
+            beadFrozen[p] = 0;
+          }
+        }
+        if (!beadFrozen[p])
+        {
+          evalBeads.push_back(p);
+        }
+      }
+    }
+    gradCt += PathForces(QMMMData,QMMMOpts,evalBeads,pathE,pathForces);
+    for (unsigned int j=0;j<evalBeads.size();j++)
+    {
+      //Save the structures of the new gradients
+      evalGeom.col(evalBeads[j]) = pathGeom.col(evalBeads[j]);
+    }
+    //Project the forces
+    PathProjForces(QMMMData,QMMMOpts,pathE,pathForces,NEBForces,forceStats,
+                   pathStart,pathEnd,1);
+    //Freeze converged beads
+    for (int p=pathStart;p<pathEnd;p++)
+    {
+      if ((!beadFrozen[p]) and (forceStats(p,0) <= maxFTol) and
+         (forceStats(p,1) <= RMSFTol))
+      {
+        //Save the structures used to wake up the bead
+        beadFrozen[p] = 1;
+        if (p > 0)
+        {
+          wakeGeomM1.col(p) = pathGeom.col(p-1);
+        }
+        if (p < (Nbeads-1))
+        {
+          wakeGeomP1.col(p) = pathGeom.col(p+1);
+        }
+      }
+    }
+    //Check convergence
+    if (stepCt == 0)
+    {
+      //Output initial RMS force
+      cout << "    QM step: 0";
+      cout << " | RMS force: ";
+      cout << LICHEMFormFloat(forceStats.col(1).maxCoeff(),12);
+      cout << " eV/\u212B";
+      cout << '\n' << '\n';
+      cout.flush();
+    }
+    else
+    {
+      pathDone = PathConverged(QMMMData,oldQMMMData,forceStats,stepCt,
+                               QMMMOpts,1);
+    }
+    bool staleForces = 0; //Flag for frozen beads with old gradients
+    if (pathDone)
+    {
+      //Confirm convergence with the gradients of the final path
+      for (int p=pathStart;p<pathEnd;p++)
+      {
+        if (PathCoordDev(pathGeom,evalGeom,p,p) > 0)
+        {
+          beadFrozen[p] = 0;
+          staleForces = 1;
+        }
+      }
+      if (staleForces)
+      {
+        pathDone = 0;
+        stepCt += 1;
+      }
+    }
+    if ((!pathDone) and (!staleForces))
+    {
+      //Frozen beads are not moved
+      for (int p=pathStart;p<pathEnd;p++)
+      {
+        if (beadFrozen[p])
+        {
+          NEBForces.col(p).setZero();
+          velocity.col(p).setZero();
+        }
+      }
+      //Move the beads
+      oldQMMMData = QMMMData;
+      PathFIREStep(QMMMData,QMMMOpts,NEBForces,velocity,fire,pathStart,
+                   pathEnd);
+      //Update charges
+      PathMMFields(QMMMData,QMMMOpts,1);
+      stepCt += 1;
+    }
+  }
+  //Print warnings
+  if (stepCt >= QMMMOpts.maxOptSteps)
+  {
+    //Print a warning if the path did not converge
+    cout << "    Warning: Maximum number of QM path steps reached.";
+    cout << '\n' << '\n';
+    cout.flush();
+  }
+  cout << "    Bead gradient calculations: " << gradCt;
+  cout << '\n' << '\n';
+  cout.flush();
+  //Remove the saved charges
+  PathMMFields(QMMMData,QMMMOpts,0);
+  //Flag the beads which moved
+  MatrixXd pathGeom = PathCoords(QMMMData,QMMMOpts);
+  for (int p=0;p<Nbeads;p++)
+  {
+    beadActive[p] = 0;
+    if (PathCoordDev(pathGeom,startGeom,p,p) > 0)
+    {
+      beadActive[p] = 1;
+    }
+  }
   return;
 };
 
+int LICHEMString(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
+                 int optCt)
+{
+  //Growing climbing image string optimizer for the QM and PB atoms
+  //NB: The beads are moved along the perpendicular forces and then
+  //redistributed along the path. Converged beads are not moved, and their
+  //forces are reused until the reparameterization moves them.
+  int stepCt = 0; //Counter for optimization steps
+  int gradCt = 0; //Counter for bead gradient calculations
+  int Ndof = 3*(Nqm+Npseudo); //Number of QM and PB degrees of freedom
+  int Nbeads = QMMMOpts.NBeads; //Number of beads on the path
+  //Convergence criteria
+  double maxFTol = 20*QMMMOpts.QMOptTol; //Opt. tolerance for max. force
+  double RMSFTol = 10*QMMMOpts.QMOptTol; //Opt. tolerance for RMS force
+  FIREState fire; //FIRE time step and mixing
+  fire.reset(0.1*QMMMOpts.stepScale);
+  //Set the optimized beads
+  int pathStart = 0; //First bead to optimize
+  int pathEnd = Nbeads; //Last bead to optimize
+  if (QMMMOpts.frznEnds)
+  {
+    //Change the start and end points
+    pathStart = 1;
+    pathEnd = Nbeads-1;
+  }
+  //Start climbing after the loose first relaxation of the path
+  if ((!QMMMOpts.climb) and (optCt > 0))
+  {
+    QMMMOpts.climb = 1;
+    cout << "    Starting climbing image string.";
+    cout << '\n' << '\n';
+    cout.flush();
+  }
+  //Initialize charges
+  PathMMFields(QMMMData,QMMMOpts,1);
+  //Create arrays
+  VectorXd pathE(Nbeads); //Bead energies
+  MatrixXd pathForces(Ndof,Nbeads); //Forces on each bead
+  MatrixXd velocity(Ndof,Nbeads); //FIRE velocities
+  MatrixXd evalGeom(Ndof,Nbeads); //Structures of the last gradients
+  vector<int> beadConv(Nbeads,0); //Flags for converged beads
+  vector<QMMMAtom> oldQMMMData = QMMMData; //Previous structure
+  //Keep the current spacing of the beads
+  VectorXd arcFrac(Nbeads); //Target fractions of the arc length
+  arcFrac(0) = 0;
+  for (int p=1;p<Nbeads;p++)
+  {
+    double segLen = 0; //Squared length of the segment
+    for (int i=0;i<Natoms;i++)
+    {
+      //Only include active QM and PB atoms
+      if ((QMMMData[i].QMRegion or QMMMData[i].PBRegion) and
+         QMMMData[i].NEBActive)
+      {
+        double dx = QMMMData[i].P[p].x-QMMMData[i].P[p-1].x;
+        double dy = QMMMData[i].P[p].y-QMMMData[i].P[p-1].y;
+        double dz = QMMMData[i].P[p].z-QMMMData[i].P[p-1].z;
+        segLen += dx*dx+dy*dy+dz*dz;
+      }
+    }
+    arcFrac(p) = arcFrac(p-1)+sqrt(segLen);
+  }
+  if (arcFrac(Nbeads-1) > 0)
+  {
+    arcFrac /= arcFrac(Nbeads-1);
+  }
+  //Initialize arrays
+  pathE.setZero();
+  pathForces.setZero();
+  velocity.setZero();
+  evalGeom.setZero();
+  //Optimize path
+  bool pathDone = 0;
+  while ((!pathDone) and (stepCt < QMMMOpts.maxOptSteps))
+  {
+    //Save the current QM and PB coordinates
+    MatrixXd pathGeom = PathCoords(QMMMData,QMMMOpts);
+    //Select the beads which need new gradients
+    //NB: Frozen end points are only needed once for their energies
+    vector<int> evalBeads; //Beads to evaluate
+    for (int p=0;p<Nbeads;p++)
+    {
+      if (stepCt == 0)
+      {
+        evalBeads.push_back(p);
+      }
+      else if ((p >= pathStart) and (p < pathEnd))
+      {
+        //Check if the bead moved since its last gradient
+        double beadDev = PathCoordDev(pathGeom,evalGeom,p,p);
+        if ((!beadConv[p]) or (beadDev > QMMMOpts.QMOptTol))
+        {
+          evalBeads.push_back(p);
+        }
+      }
+    }
+    gradCt += PathForces(QMMMData,QMMMOpts,evalBeads,pathE,pathForces);
+    for (unsigned int j=0;j<evalBeads.size();j++)
+    {
+      //Save the structures of the new gradients
+      evalGeom.col(evalBeads[j]) = pathGeom.col(evalBeads[j]);
+    }
+    //Project the forces
+    MatrixXd stringForces(Ndof,Nbeads); //Projected string forces
+    MatrixXd forceStats(Nbeads,2); //Max. and RMS string forces
+    PathProjForces(QMMMData,QMMMOpts,pathE,pathForces,stringForces,
+                   forceStats,pathStart,pathEnd,0);
+    for (int p=pathStart;p<pathEnd;p++)
+    {
+      beadConv[p] = 0;
+      if ((forceStats(p,0) <= maxFTol) and (forceStats(p,1) <= RMSFTol))
+      {
+        //Stop moving the bead
+        beadConv[p] = 1;
+      }
+    }
+    //Check convergence
+    if (stepCt == 0)
+    {
+      //Output initial RMS force
+      cout << "    QM step: 0";
+      cout << " | RMS force: ";
+      cout << LICHEMFormFloat(forceStats.col(1).maxCoeff(),12);
+      cout << " eV/\u212B";
+      cout << '\n' << '\n';
+      cout.flush();
+    }
+    else
+    {
+      pathDone = PathConverged(QMMMData,oldQMMMData,forceStats,stepCt,
+                               QMMMOpts,1);
+    }
+    //Grow the string
+    if ((stepCt > 0) and (Nbeads < QMMMOpts.maxBeads))
+    {
+      int newBead = PathGrowthBead(QMMMData,QMMMOpts,pathE);
+      if (newBead > 0)
+      {
+        //Add a bead to the path
+        PathInsertBead(QMMMData,QMMMOpts,newBead);
+        Nbeads = QMMMOpts.NBeads;
+        cout << "    Added bead " << newBead << " to the string | Beads: ";
+        cout << Nbeads;
+        cout << '\n' << '\n';
+        cout.flush();
+        //Update the target spacing
+        VectorXd oldFrac = arcFrac; //Copy of the old spacing
+        arcFrac.resize(Nbeads);
+        for (int p=0;p<Nbeads;p++)
+        {
+          if (p < newBead)
+          {
+            arcFrac(p) = oldFrac(p);
+          }
+          else if (p == newBead)
+          {
+            arcFrac(p) = 0.5*(oldFrac(p-1)+oldFrac(p));
+          }
+          else
+          {
+            arcFrac(p) = oldFrac(p-1);
+          }
+        }
+        //Add storage for the new bead
+        pathE.conservativeResize(Nbeads);
+        pathForces.conservativeResize(Ndof,Nbeads);
+        evalGeom.conservativeResize(Ndof,Nbeads);
+        velocity.conservativeResize(Ndof,Nbeads);
+        for (int p=(Nbeads-1);p>newBead;p--)
+        {
+          pathE(p) = pathE(p-1);
+          pathForces.col(p) = pathForces.col(p-1);
+          evalGeom.col(p) = evalGeom.col(p-1);
+          velocity.col(p) = velocity.col(p-1);
+        }
+        velocity.col(newBead).setZero();
+        beadConv.insert(beadConv.begin()+newBead,0);
+        //Update the optimized beads
+        pathEnd = Nbeads;
+        if (QMMMOpts.frznEnds)
+        {
+          pathEnd = Nbeads-1;
+        }
+        //Update charges for the shifted beads
+        PathMMFields(QMMMData,QMMMOpts,1);
+        oldQMMMData = QMMMData;
+        pathDone = 0; //The new bead has not been optimized
+        continue;
+      }
+    }
+    if (!pathDone)
+    {
+      //Converged beads are not moved
+      for (int p=pathStart;p<pathEnd;p++)
+      {
+        if (beadConv[p])
+        {
+          stringForces.col(p).setZero();
+          velocity.col(p).setZero();
+        }
+      }
+      //Move the beads
+      oldQMMMData = QMMMData;
+      PathFIREStep(QMMMData,QMMMOpts,stringForces,velocity,fire,pathStart,
+                   pathEnd);
+      //Redistribute the beads along the path
+      if (QMMMOpts.climb)
+      {
+        //The climbing image divides the string
+        PathReparam(QMMMData,arcFrac,0,QMMMOpts.TSBead);
+        PathReparam(QMMMData,arcFrac,QMMMOpts.TSBead,(Nbeads-1));
+      }
+      else
+      {
+        PathReparam(QMMMData,arcFrac,0,(Nbeads-1));
+      }
+      //Update charges
+      PathMMFields(QMMMData,QMMMOpts,1);
+      stepCt += 1;
+    }
+  }
+  //Print warnings
+  if (stepCt >= QMMMOpts.maxOptSteps)
+  {
+    //Print a warning if the path did not converge
+    cout << "    Warning: Maximum number of QM path steps reached.";
+    cout << '\n' << '\n';
+    cout.flush();
+  }
+  cout << "    Bead gradient calculations: " << gradCt;
+  cout << '\n' << '\n';
+  cout.flush();
+  //Remove the saved charges
+  PathMMFields(QMMMData,QMMMOpts,0);
+  return gradCt;
+};
+
 //Path ensemble samping routines
-int FBNEBMCMove(vector<QMMMAtom>& QMMMData, vector<VectorXd>& allForces,
-                QMMMSettings& QMMMOpts, VectorXd& Emc)
+double FBNEBSpring(vector<QMMMAtom>& QMMMData, vector<QMMMAtom>& beadData,
+                   VectorXd& sprForces, QMMMSettings& QMMMOpts, int p)
 {
-  //Function to try a force-bias Monte Carlo move
-  
-  return 0;
+  //Calculates the band energy and forces of a bead from the springs to the
+  //neighboring beads
+  //NB: The bead is taken from beadData and its neighbors from QMMMData
+  double Espr = 0; //Spring energy
+  int ct = 0; //Counter for QM and PB atoms
+  sprForces.setZero();
+  for (int i=0;i<Natoms;i++)
+  {
+    if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+    {
+      for (int q=(p-1);q<=(p+1);q+=2)
+      {
+        if ((q < 0) or (q >= QMMMOpts.NBeads))
+        {
+          //The end points only have one spring
+          continue;
+        }
+        double dx = beadData[i].P[p].x-QMMMData[i].P[q].x;
+        double dy = beadData[i].P[p].y-QMMMData[i].P[q].y;
+        double dz = beadData[i].P[p].z-QMMMData[i].P[q].z;
+        Espr += 0.5*QMMMOpts.kSpring*(dx*dx+dy*dy+dz*dz);
+        sprForces(ct) -= QMMMOpts.kSpring*dx;
+        sprForces(ct+1) -= QMMMOpts.kSpring*dy;
+        sprForces(ct+2) -= QMMMOpts.kSpring*dz;
+      }
+      ct += 3;
+    }
+  }
+  return Espr;
 };
 
+int FBNEBMCMove(vector<QMMMAtom>& QMMMData, vector<VectorXd>& allForces,
+                QMMMSettings& QMMMOpts, VectorXd& Emc, VectorXd& beadAcc,
+                VectorXd& beadRej, int& Nrej)
+{
+  //Function to try a force-bias Monte Carlo move on every bead
+  //NB: The beads are coupled to their neighbors by the band springs, so
+  //the even and odd beads are moved in two sweeps. The beads in a sweep
+  //are independent, so their force calculations run concurrently
+  int Nacc = 0; //Number of accepted moves
+  int Ndof = 3*(Nqm+Npseudo); //Number of QM and PB degrees of freedom
+  double biasA = 0.5*mcStep*mcStep; //Width of the biased moves (Ang^2)
+  Nrej = 0; //Number of rejected moves
+  //Set the sampled beads
+  int pathStart = 0; //First bead to move
+  int pathEnd = QMMMOpts.NBeads; //Last bead to move
+  if (QMMMOpts.frznEnds)
+  {
+    //Change the start and end points
+    pathStart = 1;
+    pathEnd = QMMMOpts.NBeads-1;
+  }
+  //Locate QM and PB atoms
+  vector<int> QMIDs; //Atom IDs of the QM and PB atoms
+  for (int i=0;i<Natoms;i++)
+  {
+    if (QMMMData[i].QMRegion or QMMMData[i].PBRegion)
+    {
+      QMIDs.push_back(i);
+    }
+  }
+  //Generate random numbers
+  //NB: rand() is not thread safe, so all numbers are drawn here
+  MatrixXd randDisp(Ndof,QMMMOpts.NBeads); //Gaussian displacements
+  VectorXd randAcc(QMMMOpts.NBeads); //Acceptance tests
+  for (int p=0;p<QMMMOpts.NBeads;p++)
+  {
+    for (int i=0;i<Ndof;i++)
+    {
+      //Box-Muller transform with a variance of 2A
+      double randU1 = (((double)rand())+1.0)/(((double)RAND_MAX)+1.0);
+      double randU2 = (((double)rand())/((double)RAND_MAX));
+      randDisp(i,p) = sqrt(-2*log(randU1))*cos(2*pi*randU2);
+      randDisp(i,p) *= mcStep;
+    }
+    randAcc(p) = (((double)rand())/((double)RAND_MAX));
+  }
+  //Create arrays for the trial moves
+  vector<QMMMAtom> trialData = QMMMData; //Trial structures
+  vector<VectorXd> trialForces = allForces; //Forces on the trial structures
+  VectorXd ETrial = Emc; //Energies of the trial structures
+  MatrixXd beadForces(Ndof,QMMMOpts.NBeads); //Trial forces on the QM atoms
+  MatrixXd dispVec(Ndof,QMMMOpts.NBeads); //Trial displacements
+  MatrixXd sprOld(Ndof,QMMMOpts.NBeads); //Spring forces before the moves
+  VectorXd ESprOld(QMMMOpts.NBeads); //Spring energies before the moves
+  beadForces.setZero();
+  dispVec.setZero();
+  sprOld.setZero();
+  ESprOld.setZero();
+  for (int sweep=0;sweep<2;sweep++)
+  {
+    //Generate the trial structures for the sweep
+    vector<int> sweepBeads; //Beads with a new energy
+    vector<int> trialFlag(QMMMOpts.NBeads,0); //Beads with a trial move
+    for (int p=sweep;p<QMMMOpts.NBeads;p+=2)
+    {
+      //Zero forces make the first move an energy calculation
+      bool firstMove = (allForces[p].squaredNorm() == 0);
+      if ((!firstMove) and ((p < pathStart) or (p >= pathEnd)))
+      {
+        //Frozen end point
+        continue;
+      }
+      sweepBeads.push_back(p);
+      if (!firstMove)
+      {
+        //Calculate the band forces on the current structure
+        VectorXd sprForces(Ndof); //Spring forces
+        ESprOld(p) = FBNEBSpring(QMMMData,QMMMData,sprForces,QMMMOpts,p);
+        sprOld.col(p) = sprForces;
+        //Apply the biased displacement
+        trialFlag[p] = 1;
+        for (unsigned int j=0;j<QMIDs.size();j++)
+        {
+          int i = QMIDs[j]; //Atom ID
+          if (!QMMMData[i].frozen)
+          {
+            for (int k=0;k<3;k++)
+            {
+              dispVec(3*j+k,p) = allForces[p](3*i+k)+sprOld(3*j+k,p);
+              dispVec(3*j+k,p) *= QMMMOpts.beta*biasA;
+              dispVec(3*j+k,p) += randDisp(3*j+k,p);
+            }
+            trialData[i].P[p].x += dispVec(3*j,p);
+            trialData[i].P[p].y += dispVec(3*j+1,p);
+            trialData[i].P[p].z += dispVec(3*j+2,p);
+          }
+        }
+      }
+      if (Nmm > 0)
+      {
+        SaveMMField(trialData,QMMMOpts,p);
+      }
+    }
+    //Calculate the forces on the trial structures
+    PathForces(trialData,QMMMOpts,sweepBeads,ETrial,beadForces);
+    //Accept or reject the moves
+    for (unsigned int n=0;n<sweepBeads.size();n++)
+    {
+      int p = sweepBeads[n]; //Bead ID
+      //Save the forces on the QM and PB atoms
+      trialForces[p].setZero();
+      for (unsigned int j=0;j<QMIDs.size();j++)
+      {
+        int i = QMIDs[j]; //Atom ID
+        for (int k=0;k<3;k++)
+        {
+          trialForces[p](3*i+k) = beadForces(3*j+k,p);
+        }
+      }
+      bool accFlag = 1; //Always accept the initial structure
+      if (trialFlag[p])
+      {
+        //Metropolis-Hastings test for the biased moves on the band
+        VectorXd sprNew(Ndof); //Spring forces on the trial structure
+        double ESprNew = FBNEBSpring(QMMMData,trialData,sprNew,QMMMOpts,p);
+        double logProb = ETrial(p)+ESprNew-Emc(p)-ESprOld(p);
+        logProb *= -1*QMMMOpts.beta;
+        for (unsigned int j=0;j<QMIDs.size();j++)
+        {
+          int i = QMIDs[j]; //Atom ID
+          if (QMMMData[i].frozen)
+          {
+            //Frozen atoms are not moved, so they have no proposal terms
+            continue;
+          }
+          for (int k=0;k<3;k++)
+          {
+            //Compare the forward and reverse move probabilities
+            double fwdDisp = allForces[p](3*i+k)+sprOld(3*j+k,p);
+            fwdDisp = dispVec(3*j+k,p)-QMMMOpts.beta*biasA*fwdDisp;
+            double revDisp = trialForces[p](3*i+k)+sprNew(3*j+k);
+            revDisp = -1*dispVec(3*j+k,p)-QMMMOpts.beta*biasA*revDisp;
+            logProb -= (revDisp*revDisp-fwdDisp*fwdDisp)/(4*biasA);
+          }
+        }
+        accFlag = (log(randAcc(p)) <= logProb);
+      }
+      //Update the bead before the next sweep moves its neighbors
+      if (accFlag)
+      {
+        #pragma omp parallel for schedule(dynamic)
+        for (int i=0;i<Natoms;i++)
+        {
+          QMMMData[i].P[p] = trialData[i].P[p];
+          QMMMData[i].MP[p] = trialData[i].MP[p];
+        }
+        Emc(p) = ETrial(p);
+        allForces[p] = trialForces[p];
+      }
+      //Only count trial moves, not the initial energy calculations
+      if (trialFlag[p] and accFlag)
+      {
+        beadAcc(p) += 1;
+        Nacc += 1;
+      }
+      if (trialFlag[p] and (!accFlag))
+      {
+        beadRej(p) += 1;
+        Nrej += 1;
+      }
+    }
+  }
+  return Nacc;
+};
@@ -20,42 +20,13 @@ void WriteGauInput(vector<QMMMAtom>& QMMMData, string calcTyp,
   //Write Gaussian input files
   stringstream call; //Stream for system calls and reading/writing files
   call.copyfmt(cout); //Copy settings from cout
-  string dummy,chrgfilename; //Generic strings
+  string dummy; //Generic string
   fstream inFile,outFile; //Generic file names
-  //Check units
-  double uConv = 1; //Units conversion constant
-  if (QMMMOpts.unitsQM == "Bohr")
-  {
-    uConv = 1.0/bohrRad;
-  }
-  //Check for a charge file
-  bool useChargeFile = 0;
-  call.str("");
-  call << "MMCharges_" << bead << ".txt";
-  chrgfilename = call.str();
-  useChargeFile = CheckFile(call.str());
-  if (Nmm == 0)
+  //Collect the MM field
+  vector<double> MMField; //Packed MM point-charges (x,y,z,q)
+  if (QMMM and (Nmm > 0))
   {
-    //Skip blank charge files
-    useChargeFile = 0;
-  }
-  //Initialize multipoles and center of mass
-  bool firstCharge = 1; //Always write the first charge
-  Coord QMCOM;
-  if (!useChargeFile)
-  {
-    if (PBCon or QMMMOpts.useLREC)
-    {
-      QMCOM = FindQMCOM(QMMMData,QMMMOpts,bead);
-    }
-    if (AMOEBA)
-    {
-      if (TINKER)
-      {
-        //Set up multipoles
-        RotateTINKCharges(QMMMData,bead);
-      }
-    }
+    GetMMField(QMMMData,QMMMOpts,bead,MMField);
   }
   //Construct g09 input
   call.str("");
@@ -102,183 +73,17 @@ void WriteGauInput(vector<QMMMAtom>& QMMMData, string calcTyp,
   }
   call << '\n'; //Blank line needed
   //Add the MM field
-  if (QMMM and useChargeFile)
+  if (QMMM and (Nmm > 0) and (CHRG or AMOEBA))
   {
-    inFile.open(chrgfilename.c_str(),ios_base::in);
-    if (inFile.good())
+    for (unsigned int j=0;j<MMField.size();j+=4)
     {
-      while (!inFile.eof())
-      {
-        //Copy charge file line by line
-        getline(inFile,dummy);
-        call << dummy << '\n';
-      }
-      inFile.close();
-    }
-  }
-  else if (QMMM)
-  {
-    if (CHRG)
-    {
-      for (int i=0;i<Natoms;i++)
-      {
-        if (QMMMData[i].MMRegion)
-        {
-          //Check PBC (minimum image convention)
-          Coord distCent; //Distance from QM COM
-          double xShft = 0;
-          double yShft = 0;
-          double zShft = 0;
-          if (PBCon or QMMMOpts.useLREC)
-          {
-            //Initialize displacements
-            double dx,dy,dz; //Starting displacements
-            dx = QMMMData[i].P[bead].x-QMCOM.x;
-            dy = QMMMData[i].P[bead].y-QMCOM.y;
-            dz = QMMMData[i].P[bead].z-QMCOM.z;
-            distCent = CoordDist2(QMMMData[i].P[bead],QMCOM);
-            //Calculate the shift in positions
-            //NB: Generally this work out to be +/- {Lx,Ly,Lz}
-            if (PBCon)
-            {
-              xShft = distCent.x-dx;
-              yShft = distCent.y-dy;
-              zShft = distCent.z-dz;
-            }
-          }
-          //Check for long-range corrections
-          double scrq = 1;
-          if (QMMMOpts.useLREC)
-          {
-            //Use the long-range correction
-            scrq = LRECFunction(distCent,QMMMOpts);
-          }
-          if ((scrq > 0) or firstCharge)
-          {
-            //Add charges
-            firstCharge = 0; //Skips writing the remaining zeros
-            double tmpX,tmpY,tmpZ,tmpQ; //Temporary storage
-            tmpX = (QMMMData[i].P[bead].x+xShft)*uConv;
-            tmpY = (QMMMData[i].P[bead].y+yShft)*uConv;
-            tmpZ = (QMMMData[i].P[bead].z+zShft)*uConv;
-            tmpQ = QMMMData[i].MP[bead].q*scrq;
-            call << " ";
-            call << LICHEMFormFloat(tmpX,16);
-            call << " ";
-            call << LICHEMFormFloat(tmpY,16);
-            call << " ";
-            call << LICHEMFormFloat(tmpZ,16);
-            call << " ";
-            call << LICHEMFormFloat(tmpQ,16);
-            call << '\n';
-          }
-        }
-      }
-      if (Nmm > 0)
-      {
-        call << '\n'; //Blank line needed
-      }
-    }
-    if (AMOEBA)
-    {
-      for (int i=0;i<Natoms;i++)
-      {
-        if (QMMMData[i].MMRegion)
-        {
-          //Check PBC (minimum image convention)
-          Coord distCent; //Distance from QM COM
-          double xShft = 0;
-          double yShft = 0;
-          double zShft = 0;
-          if (PBCon or QMMMOpts.useLREC)
-          {
-            //Initialize displacements
-            double dx,dy,dz; //Starting displacements
-            dx = QMMMData[i].P[bead].x-QMCOM.x;
-            dy = QMMMData[i].P[bead].y-QMCOM.y;
-            dz = QMMMData[i].P[bead].z-QMCOM.z;
-            distCent = CoordDist2(QMMMData[i].P[bead],QMCOM);
-            //Calculate the shift in positions
-            //NB: Generally this work out to be +/- {Lx,Ly,Lz}
-            if (PBCon)
-            {
-              xShft = distCent.x-dx;
-              yShft = distCent.y-dy;
-              zShft = distCent.z-dz;
-            }
-          }
-          //Check for long-range corrections
-          double scrq = 1;
-          if (QMMMOpts.useLREC)
-          {
-            //Use the long-range correction
-            scrq = LRECFunction(distCent,QMMMOpts);
-          }
-          if ((scrq > 0) or firstCharge)
-          {
-            firstCharge = 0; //Skips writing the remaining zeros
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].x1+xShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].y1+yShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].z1+zShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].q1*scrq,16);
-            call << '\n';
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].x2+xShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].y2+yShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].z2+zShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].q2*scrq,16);
-            call << '\n';
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].x3+xShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].y3+yShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].z3+zShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].q3*scrq,16);
-            call << '\n';
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].x4+xShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].y4+yShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].z4+zShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].q4*scrq,16);
-            call << '\n';
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].x5+xShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].y5+yShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].z5+zShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].q5*scrq,16);
-            call << '\n';
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].x6+xShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].y6+yShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].z6+zShft,16);
-            call << " ";
-            call << LICHEMFormFloat(QMMMData[i].PC[bead].q6*scrq,16);
-            call << '\n';
-          }
-        }
-      }
-      if (Nmm > 0)
-      {
-        call << '\n'; //Blank line needed
-      }
+      call << " " << LICHEMFormFloat(MMField[j],16);
+      call << " " << LICHEMFormFloat(MMField[j+1],16);
+      call << " " << LICHEMFormFloat(MMField[j+2],16);
+      call << " " << LICHEMFormFloat(MMField[j+3],16);
+      call << '\n';
     }
+    call << '\n'; //Blank line needed
   }
   //Add basis set information from the BASIS file
   inFile.open("BASIS",ios_base::in);
@@ -303,43 +108,14 @@ void WriteNWChemInput(vector<QMMMAtom>& QMMMData, string calcTyp,
 {
   //Write NWChem input files
   fstream outFile,inFile; //Generic file streams
-  string dummy,chrgfilename; //Generic strings
+  string dummy; //Generic string
   stringstream call; //Stream for system calls and reading/writing files
   call.copyfmt(cout); //Copy settings from cout
-  //Check units
-  double uConv = 1; //Units conversion constant
-  if (QMMMOpts.unitsQM == "Bohr")
-  {
-    uConv = 1.0/bohrRad;
-  }
-  //Check for a charge file
-  bool useChargeFile = 0;
-  call.str("");
-  call << "MMCharges_" << bead << ".txt";
-  chrgfilename = call.str();
-  useChargeFile = CheckFile(call.str());
-  if (Nmm == 0)
-  {
-    //Skip blank charge files
-    useChargeFile = 0;
-  }
-  //Initialize multipoles and center of mass
-  bool firstCharge = 1; //Always write the first charge
-  Coord QMCOM;
-  if (!useChargeFile)
+  //Collect the MM field
+  vector<double> MMField; //Packed MM point-charges (x,y,z,q)
+  if (QMMM and (Nmm > 0))
   {
-    if (PBCon or QMMMOpts.useLREC)
-    {
-      QMCOM = FindQMCOM(QMMMData,QMMMOpts,bead);
-    }
-    if (AMOEBA)
-    {
-      if (TINKER)
-      {
-        //Set up multipoles
-        RotateTINKCharges(QMMMData,bead);
-      }
-    }
+    GetMMField(QMMMData,QMMMOpts,bead,MMField);
   }
   //Create NWChem input
   call.str("");
@@ -416,220 +192,26 @@ void WriteNWChemInput(vector<QMMMAtom>& QMMMData, string calcTyp,
     outFile << '\n';
     outFile << "end" << '\n';
   }
-  if (QMMM and useChargeFile and (Nmm > 0))
+  if (QMMM and (Nmm > 0) and (CHRG or AMOEBA))
   {
-    inFile.open(chrgfilename.c_str(),ios_base::in);
-    if (inFile.good())
-    {
-      outFile << "set bq:max_nbq " << (6*(Nmm+Nbound)) << '\n';
-      outFile << "bq mmchrg";
-      while (!inFile.eof())
-      {
-        //Copy charge file line by line
-        outFile << '\n'; //Avoid adding an extra blank line
-        getline(inFile,dummy);
-        outFile << dummy; //Print the line
-      }
-      inFile.close();
-      outFile << "end" << '\n';
-      outFile << "set bq mmchrg" << '\n';
-    }
-  }
-  else if (QMMM and (Nmm > 0))
-  {
-    if (CHRG)
+    //Add the MM field
+    int maxCharges = Nmm+Nbound; //Maximum number of charges
+    if (AMOEBA)
     {
-      outFile << "set bq:max_nbq " << (Nmm+Nbound) << '\n';
-      outFile << "bq mmchrg" << '\n';
-      for (int i=0;i<Natoms;i++)
-      {
-        if (QMMMData[i].MMRegion)
-        {
-          //Check PBC (minimum image convention)
-          Coord distCent; //Distance from QM COM
-          double xShft = 0;
-          double yShft = 0;
-          double zShft = 0;
-          if (PBCon or QMMMOpts.useLREC)
-          {
-            //Initialize displacements
-            double dx,dy,dz; //Starting displacements
-            dx = QMMMData[i].P[bead].x-QMCOM.x;
-            dy = QMMMData[i].P[bead].y-QMCOM.y;
-            dz = QMMMData[i].P[bead].z-QMCOM.z;
-            distCent = CoordDist2(QMMMData[i].P[bead],QMCOM);
-            //Calculate the shift in positions
-            //NB: Generally this work out to be +/- {Lx,Ly,Lz}
-            if (PBCon)
-            {
-              xShft = distCent.x-dx;
-              yShft = distCent.y-dy;
-              zShft = distCent.z-dz;
-            }
-          }
-          //Check for long-range corrections
-          double scrq = 1;
-          if (QMMMOpts.useLREC)
-          {
-            //Use the long-range correction
-            scrq = LRECFunction(distCent,QMMMOpts);
-          }
-          if ((scrq > 0) or firstCharge)
-          {
-            //Add charges
-            firstCharge = 0; //Skips writing the remaining zeros
-            double tmpX,tmpY,tmpZ,tmpQ; //Temporary storage
-            tmpX = (QMMMData[i].P[bead].x+xShft)*uConv;
-            tmpY = (QMMMData[i].P[bead].y+yShft)*uConv;
-            tmpZ = (QMMMData[i].P[bead].z+zShft)*uConv;
-            tmpQ = QMMMData[i].MP[bead].q*scrq;
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpX,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpY,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpZ,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpQ,16);
-            outFile << '\n';
-          }
-        }
-      }
-      outFile << "end" << '\n';
-      outFile << "set bq mmchrg" << '\n';
+      maxCharges *= 6;
     }
-    if (AMOEBA)
+    outFile << "set bq:max_nbq " << maxCharges << '\n';
+    outFile << "bq mmchrg" << '\n';
+    for (unsigned int j=0;j<MMField.size();j+=4)
     {
-      outFile << "set bq:max_nbq " << (6*(Nmm+Nbound)) << '\n';
-      outFile << "bq mmchrg" << '\n';
-      for (int i=0;i<Natoms;i++)
-      {
-        if (QMMMData[i].MMRegion)
-        {
-          //Check PBC (minimum image convention)
-          Coord distCent; //Distance from QM COM
-          double xShft = 0;
-          double yShft = 0;
-          double zShft = 0;
-          if (PBCon or QMMMOpts.useLREC)
-          {
-            //Initialize displacements
-            double dx,dy,dz; //Starting displacements
-            dx = QMMMData[i].P[bead].x-QMCOM.x;
-            dy = QMMMData[i].P[bead].y-QMCOM.y;
-            dz = QMMMData[i].P[bead].z-QMCOM.z;
-            distCent = CoordDist2(QMMMData[i].P[bead],QMCOM);
-            //Calculate the shift in positions
-            //NB: Generally this work out to be +/- {Lx,Ly,Lz}
-            if (PBCon)
-            {
-              xShft = distCent.x-dx;
-              yShft = distCent.y-dy;
-              zShft = distCent.z-dz;
-            }
-          }
-          //Check for long-range corrections
-          double scrq = 1;
-          if (QMMMOpts.useLREC)
-          {
-            //Use the long-range correction
-            scrq = LRECFunction(distCent,QMMMOpts);
-          }
-          if ((scrq > 0) or firstCharge)
-          {
-            //Add multipoles
-            firstCharge = 0; //Skips writing the remaining zeros
-            double tmpX,tmpY,tmpZ,tmpQ; //Temporary storage
-            //Charge 1
-            tmpX = (QMMMData[i].PC[bead].x1+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y1+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z1+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q1*scrq;
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpX,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpY,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpZ,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpQ,16);
-            outFile << '\n';
-            //Charge 2
-            tmpX = (QMMMData[i].PC[bead].x2+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y2+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z2+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q2*scrq;
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpX,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpY,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpZ,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpQ,16);
-            outFile << '\n';
-            //Charge 3
-            tmpX = (QMMMData[i].PC[bead].x3+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y3+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z3+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q3*scrq;
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpX,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpY,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpZ,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpQ,16);
-            outFile << '\n';
-            //Charge 4
-            tmpX = (QMMMData[i].PC[bead].x4+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y4+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z4+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q4*scrq;
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpX,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpY,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpZ,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpQ,16);
-            outFile << '\n';
-            //Charge 5
-            tmpX = (QMMMData[i].PC[bead].x5+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y5+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z5+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q5*scrq;
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpX,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpY,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpZ,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpQ,16);
-            outFile << '\n';
-            //Charge 6
-            tmpX = (QMMMData[i].PC[bead].x6+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y6+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z6+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q6*scrq;
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpX,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpY,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpZ,16);
-            outFile << " ";
-            outFile << LICHEMFormFloat(tmpQ,16);
-            outFile << '\n';
-          }
-        }
-      }
-      outFile << "end" << '\n';
-      outFile << "set bq mmchrg" << '\n';
+      outFile << " " << LICHEMFormFloat(MMField[j],16);
+      outFile << " " << LICHEMFormFloat(MMField[j+1],16);
+      outFile << " " << LICHEMFormFloat(MMField[j+2],16);
+      outFile << " " << LICHEMFormFloat(MMField[j+3],16);
+      outFile << '\n';
     }
+    outFile << "end" << '\n';
+    outFile << "set bq mmchrg" << '\n';
   }
   //Add DFT settings
   outFile << "dft" << '\n';
@@ -664,7 +246,7 @@ void WritePSI4Input(vector<QMMMAtom>& QMMMData, string calcTyp,
   //Write PSI4 input files
   stringstream call; //Stream for system calls and reading/writing files
   call.copyfmt(cout); //Copy settings from cout
-  string dummy,chrgfilename; //Generic string
+  string dummy; //Generic string
   fstream inFile,outFile; //Generic file names
   //Check units
   double uConv = 1; //Units conversion constant
@@ -672,33 +254,11 @@ void WritePSI4Input(vector<QMMMAtom>& QMMMData, string calcTyp,
   {
     uConv = 1.0/bohrRad;
   }
-  //Check for a charge file
-  bool useChargeFile = 0;
-  call.str("");
-  call << "MMCharges_" << bead << ".txt";
-  chrgfilename = call.str();
-  useChargeFile = CheckFile(call.str());
-  if (Nmm == 0)
+  //Collect the MM field
+  vector<double> MMField; //Packed MM point-charges (x,y,z,q)
+  if (QMMM and (Nmm > 0))
   {
-    //Skip blank charge files
-    useChargeFile = 0;
-  }
-  //Initialize multipoles and center of mass
-  Coord QMCOM;
-  if (!useChargeFile)
-  {
-    if (PBCon or QMMMOpts.useLREC)
-    {
-      QMCOM = FindQMCOM(QMMMData,QMMMOpts,bead);
-    }
-    if (AMOEBA)
-    {
-      if (TINKER)
-      {
-        //Set up multipoles
-        RotateTINKCharges(QMMMData,bead);
-      }
-    }
+    GetMMField(QMMMData,QMMMOpts,bead,MMField);
   }
   //Check if there is a checkpoint file
   bool useCheckPoint;
@@ -774,214 +334,41 @@ void WritePSI4Input(vector<QMMMAtom>& QMMMData, string calcTyp,
   call << " no_com" << '\n';
   call << "}" << '\n' << '\n';
   //Set up MM field
-  if (QMMM and useChargeFile and (Nmm > 0))
+  if (QMMM and (Nmm > 0) and (CHRG or AMOEBA))
   {
-    inFile.open(chrgfilename.c_str(),ios_base::in);
-    if (inFile.good())
+    call << "Chrgfield = QMMM()" << '\n';
+    for (unsigned int j=0;j<MMField.size();j+=4)
     {
-      call << "Chrgfield = QMMM()" << '\n';
-      while (!inFile.eof())
-      {
-        //Copy charge file line by line
-        getline(inFile,dummy);
-        call << dummy << '\n';
-      }
-      inFile.close();
-      call << "psi4.set_global_option_python('EXTERN',Chrgfield.extern)";
-      call << '\n' << '\n';
+      call << "Chrgfield.extern.addCharge(";
+      call << LICHEMFormFloat(MMField[j+3],16) << ",";
+      call << LICHEMFormFloat(MMField[j],16) << ",";
+      call << LICHEMFormFloat(MMField[j+1],16) << ",";
+      call << LICHEMFormFloat(MMField[j+2],16) << ")";
+      call << '\n';
     }
+    call << "psi4.set_global_option_python('EXTERN',Chrgfield.extern)";
+    call << '\n';
+    call << '\n';
   }
-  else if (QMMM and (Nmm > 0))
+  if (QMMM and (Nmm > 0) and GEM)
   {
-    if (CHRG)
-    {
-      call << "Chrgfield = QMMM()" << '\n';
-      for (int i=0;i<Natoms;i++)
-      {
-        if (QMMMData[i].MMRegion)
-        {
-          //Check PBC (minimum image convention)
-          Coord distCent; //Distance from QM COM
-          double xShft = 0;
-          double yShft = 0;
-          double zShft = 0;
-          if (PBCon or QMMMOpts.useLREC)
-          {
-            //Initialize displacements
-            double dx,dy,dz; //Starting displacements
-            dx = QMMMData[i].P[bead].x-QMCOM.x;
-            dy = QMMMData[i].P[bead].y-QMCOM.y;
-            dz = QMMMData[i].P[bead].z-QMCOM.z;
-            distCent = CoordDist2(QMMMData[i].P[bead],QMCOM);
-            //Calculate the shift in positions
-            //NB: Generally this work out to be +/- {Lx,Ly,Lz}
-            if (PBCon)
-            {
-              xShft = distCent.x-dx;
-              yShft = distCent.y-dy;
-              zShft = distCent.z-dz;
-            }
-          }
-          //Check for long-range corrections
-          double scrq = 1;
-          if (QMMMOpts.useLREC)
-          {
-            //Use the long-range correction
-            scrq = LRECFunction(distCent,QMMMOpts);
-          }
-          if (scrq > 0)
-          {
-            //Add charge
-            double tmpX,tmpY,tmpZ,tmpQ; //Temporary storage
-            tmpX = (QMMMData[i].P[bead].x+xShft)*uConv;
-            tmpY = (QMMMData[i].P[bead].y+yShft)*uConv;
-            tmpZ = (QMMMData[i].P[bead].z+zShft)*uConv;
-            tmpQ = QMMMData[i].MP[bead].q*scrq;
-            call << "Chrgfield.extern.addCharge(";
-            call << LICHEMFormFloat(tmpQ,16) << ",";
-            call << LICHEMFormFloat(tmpX,16) << ",";
-            call << LICHEMFormFloat(tmpY,16) << ",";
-            call << LICHEMFormFloat(tmpZ,16) << ")";
-            call << '\n';
-          }
-        }
-      }
-      call << "psi4.set_global_option_python('EXTERN',Chrgfield.extern)";
-      call << '\n' << '\n';
-    }
-    if (AMOEBA)
+    //Add generic field field from a file (psithon)
+    if (CheckFile("FIELD"))
     {
-      call << "Chrgfield = QMMM()" << '\n';
-      for (int i=0;i<Natoms;i++)
+      //Read a block of psithon code
+      inFile.open("FIELD",ios_base::in);
+      while ((!inFile.eof()) and inFile.good())
       {
-        if (QMMMData[i].MMRegion)
-        {
-          //Check PBC (minimum image convention)
-          Coord distCent; //Distance from QM COM
-          double xShft = 0;
-          double yShft = 0;
-          double zShft = 0;
-          if (PBCon or QMMMOpts.useLREC)
-          {
-            //Initialize displacements
-            double dx,dy,dz; //Starting displacements
-            dx = QMMMData[i].P[bead].x-QMCOM.x;
-            dy = QMMMData[i].P[bead].y-QMCOM.y;
-            dz = QMMMData[i].P[bead].z-QMCOM.z;
-            distCent = CoordDist2(QMMMData[i].P[bead],QMCOM);
-            //Calculate the shift in positions
-            //NB: Generally this work out to be +/- {Lx,Ly,Lz}
-            if (PBCon)
-            {
-              xShft = distCent.x-dx;
-              yShft = distCent.y-dy;
-              zShft = distCent.z-dz;
-            }
-          }
-          //Check for long-range corrections
-          double scrq = 1;
-          if (QMMMOpts.useLREC)
-          {
-            //Use the long-range correction
-            scrq = LRECFunction(distCent,QMMMOpts);
-          }
-          if (scrq > 0)
-          {
-            //Add multipoles
-            double tmpX,tmpY,tmpZ,tmpQ; //Temporary storage
-            //Charge 1
-            tmpX = (QMMMData[i].PC[bead].x1+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y1+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z1+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q1*scrq;
-            call << "Chrgfield.extern.addCharge(";
-            call << LICHEMFormFloat(tmpQ,16) << ",";
-            call << LICHEMFormFloat(tmpX,16) << ",";
-            call << LICHEMFormFloat(tmpY,16) << ",";
-            call << LICHEMFormFloat(tmpZ,16) << ")";
-            call << '\n';
-            //Charge 2
-            tmpX = (QMMMData[i].PC[bead].x2+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y2+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z2+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q2*scrq;
-            call << "Chrgfield.extern.addCharge(";
-            call << LICHEMFormFloat(tmpQ,16) << ",";
-            call << LICHEMFormFloat(tmpX,16) << ",";
-            call << LICHEMFormFloat(tmpY,16) << ",";
-            call << LICHEMFormFloat(tmpZ,16) << ")";
-            call << '\n';
-            //Charge 3
-            tmpX = (QMMMData[i].PC[bead].x3+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y3+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z3+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q3*scrq;
-            call << "Chrgfield.extern.addCharge(";
-            call << LICHEMFormFloat(tmpQ,16) << ",";
-            call << LICHEMFormFloat(tmpX,16) << ",";
-            call << LICHEMFormFloat(tmpY,16) << ",";
-            call << LICHEMFormFloat(tmpZ,16) << ")";
-            call << '\n';
-            //Charge 4
-            tmpX = (QMMMData[i].PC[bead].x4+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y4+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z4+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q4*scrq;
-            call << "Chrgfield.extern.addCharge(";
-            call << LICHEMFormFloat(tmpQ,16) << ",";
-            call << LICHEMFormFloat(tmpX,16) << ",";
-            call << LICHEMFormFloat(tmpY,16) << ",";
-            call << LICHEMFormFloat(tmpZ,16) << ")";
-            call << '\n';
-            //Charge 5
-            tmpX = (QMMMData[i].PC[bead].x5+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y5+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z5+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q5*scrq;
-            call << "Chrgfield.extern.addCharge(";
-            call << LICHEMFormFloat(tmpQ,16) << ",";
-            call << LICHEMFormFloat(tmpX,16) << ",";
-            call << LICHEMFormFloat(tmpY,16) << ",";
-            call << LICHEMFormFloat(tmpZ,16) << ")";
-            call << '\n';
-            //Charge 6
-            tmpX = (QMMMData[i].PC[bead].x6+xShft)*uConv;
-            tmpY = (QMMMData[i].PC[bead].y6+yShft)*uConv;
-            tmpZ = (QMMMData[i].PC[bead].z6+zShft)*uConv;
-            tmpQ = QMMMData[i].PC[bead].q6*scrq;
-            call << "Chrgfield.extern.addCharge(";
-            call << LICHEMFormFloat(tmpQ,16) << ",";
-            call << LICHEMFormFloat(tmpX,16) << ",";
-            call << LICHEMFormFloat(tmpY,16) << ",";
-            call << LICHEMFormFloat(tmpZ,16) << ")";
-            call << '\n';
-          }
-        }
+        getline(inFile,dummy);
+        call << dummy << '\n';
       }
+      //Save the field
       call << "psi4.set_global_option_python('EXTERN',Chrgfield.extern)";
       call << '\n';
+      //Make sure the QM region is active
+      call << "activate(LICHM_" << bead << ")" << '\n';
       call << '\n';
-    }
-    if (GEM)
-    {
-      //Add generic field field from a file (psithon)
-      if (CheckFile("FIELD"))
-      {
-        //Read a block of psithon code
-        inFile.open("FIELD",ios_base::in);
-        while ((!inFile.eof()) and inFile.good())
-        {
-          getline(inFile,dummy);
-          call << dummy << '\n';
-        }
-        //Save the field
-        call << "psi4.set_global_option_python('EXTERN',Chrgfield.extern)";
-        call << '\n';
-        //Make sure the QM region is active
-        call << "activate(LICHM_" << bead << ")" << '\n';
-        call << '\n';
-        inFile.close();
-      }
+      inFile.close();
     }
   }
   //Add calculation type
@@ -243,8 +243,15 @@ void TINK2LICHEM(int& argc, char**& argv)
     //Grab whole line
     getline(tinkXYZ,dummy);
     stringstream line(dummy);
-    //Read box lengths
+    //Read box lengths and angles
     line >> Lx >> Ly >> Lz;
+    if (!(line >> boxAlpha >> boxBeta >> boxGamma))
+    {
+      //Older files only list the lengths
+      boxAlpha = 90;
+      boxBeta = 90;
+      boxGamma = 90;
+    }
   }
   //Write region file
   regFile << fixed;
@@ -256,6 +263,14 @@ void TINK2LICHEM(int& argc, char**& argv)
     regFile << Lx << " ";
     regFile << Ly << " ";
     regFile << Lz << '\n';
+    if ((boxAlpha != 90) or (boxBeta != 90) or (boxGamma != 90))
+    {
+      //Print the angles of a triclinic cell
+      regFile << "Box_angles: ";
+      regFile << boxAlpha << " ";
+      regFile << boxBeta << " ";
+      regFile << boxGamma << '\n';
+    }
   }
   regFile << "QM_atoms: ";
   regFile << Nqm << '\n';
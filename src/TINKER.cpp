@@ -17,12 +17,11 @@
 */
 
 //MM utility functions
-void FindTINKERClasses(vector<QMMMAtom>& QMMMData)
+string FindTINKERParams()
 {
-  //Parses TINKER parameter files to find atom classes
+  //Finds the name of the TINKER parameter file in the key file
   fstream inFile; //Generic file stream
   string dummy; //Generic string
-  int ct; //Generic counter
   //Open generic key file
   inFile.open("tinker.key",ios_base::in);
   if (!inFile.good())
@@ -46,9 +45,7 @@ void FindTINKERClasses(vector<QMMMAtom>& QMMMData)
       fileFound = 1;
     }
   }
-  //Open the parameters
   inFile.close();
-  inFile.open(dummy.c_str(),ios_base::in);
   if (!fileFound)
   {
     //Exit if parameter file is not found
@@ -57,6 +54,18 @@ void FindTINKERClasses(vector<QMMMAtom>& QMMMData)
     cout.flush();
     exit(0);
   }
+  return dummy;
+};
+
+void FindTINKERClasses(vector<QMMMAtom>& QMMMData)
+{
+  //Parses TINKER parameter files to find atom classes
+  fstream inFile; //Generic file stream
+  string dummy; //Generic string
+  int ct; //Generic counter
+  //Open the parameters
+  dummy = FindTINKERParams();
+  inFile.open(dummy.c_str(),ios_base::in);
   if (!inFile.good())
   {
     //Exit if parameter file does not exist
@@ -124,7 +133,9 @@ void TINKERInduced(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
     outFile << LICHEMFormFloat(Lx,12) << " ";
     outFile << LICHEMFormFloat(Ly,12) << " ";
     outFile << LICHEMFormFloat(Lz,12) << " ";
-    outFile << "90.0 90.0 90.0";
+    outFile << LICHEMFormFloat(boxAlpha,12) << " ";
+    outFile << LICHEMFormFloat(boxBeta,12) << " ";
+    outFile << LICHEMFormFloat(boxGamma,12);
     outFile << '\n';
   }
   ct = 0; //Counter for QM atoms
@@ -195,9 +206,9 @@ void TINKERInduced(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
     outFile << "a-axis " << LICHEMFormFloat(Lx,12) << '\n';
     outFile << "b-axis " << LICHEMFormFloat(Ly,12) << '\n';
     outFile << "c-axis " << LICHEMFormFloat(Lz,12) << '\n';
-    outFile << "alpha 90.0" << '\n';
-    outFile << "beta 90.0" << '\n';
-    outFile << "gamma 90.0" << '\n';
+    outFile << "alpha " << LICHEMFormFloat(boxAlpha,12) << '\n';
+    outFile << "beta " << LICHEMFormFloat(boxBeta,12) << '\n';
+    outFile << "gamma " << LICHEMFormFloat(boxGamma,12) << '\n';
   }
   outFile << "save-induced" << '\n'; //Save induced dipoles
   outFile << "thermostat berendsen" << '\n';
@@ -339,7 +350,9 @@ double TINKERPolEnergy(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
     outFile << LICHEMFormFloat(Lx,12) << " ";
     outFile << LICHEMFormFloat(Ly,12) << " ";
     outFile << LICHEMFormFloat(Lz,12) << " ";
-    outFile << "90.0 90.0 90.0";
+    outFile << LICHEMFormFloat(boxAlpha,12) << " ";
+    outFile << LICHEMFormFloat(boxBeta,12) << " ";
+    outFile << LICHEMFormFloat(boxGamma,12);
     outFile << '\n';
   }
   ct = 0; //Counter for QM atoms
@@ -410,9 +423,9 @@ double TINKERPolEnergy(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
     outFile << "a-axis " << LICHEMFormFloat(Lx,12) << '\n';
     outFile << "b-axis " << LICHEMFormFloat(Ly,12) << '\n';
     outFile << "c-axis " << LICHEMFormFloat(Lz,12) << '\n';
-    outFile << "alpha 90.0" << '\n';
-    outFile << "beta 90.0" << '\n';
-    outFile << "gamma 90.0" << '\n';
+    outFile << "alpha " << LICHEMFormFloat(boxAlpha,12) << '\n';
+    outFile << "beta " << LICHEMFormFloat(boxBeta,12) << '\n';
+    outFile << "gamma " << LICHEMFormFloat(boxGamma,12) << '\n';
   }
   if (AMOEBA)
   {
@@ -611,9 +624,9 @@ double TINKERForces(vector<QMMMAtom>& QMMMData, VectorXd& forces,
     outFile << "a-axis " << LICHEMFormFloat(Lx,12) << '\n';
     outFile << "b-axis " << LICHEMFormFloat(Ly,12) << '\n';
     outFile << "c-axis " << LICHEMFormFloat(Lz,12) << '\n';
-    outFile << "alpha 90.0" << '\n';
-    outFile << "beta 90.0" << '\n';
-    outFile << "gamma 90.0" << '\n';
+    outFile << "alpha " << LICHEMFormFloat(boxAlpha,12) << '\n';
+    outFile << "beta " << LICHEMFormFloat(boxBeta,12) << '\n';
+    outFile << "gamma " << LICHEMFormFloat(boxGamma,12) << '\n';
   }
   ct = 0; //Generic counter
   for (int i=0;i<Natoms;i++)
@@ -724,7 +737,9 @@ double TINKERForces(vector<QMMMAtom>& QMMMData, VectorXd& forces,
     outFile << LICHEMFormFloat(Lx,12) << " ";
     outFile << LICHEMFormFloat(Ly,12) << " ";
     outFile << LICHEMFormFloat(Lz,12) << " ";
-    outFile << "90.0 90.0 90.0";
+    outFile << LICHEMFormFloat(boxAlpha,12) << " ";
+    outFile << LICHEMFormFloat(boxBeta,12) << " ";
+    outFile << LICHEMFormFloat(boxGamma,12);
     outFile << '\n';
   }
   ct = 0; //Counter for QM atoms
@@ -880,9 +895,9 @@ double TINKERMMForces(vector<QMMMAtom>& QMMMData, VectorXd& forces,
     outFile << "a-axis " << LICHEMFormFloat(Lx,12) << '\n';
     outFile << "b-axis " << LICHEMFormFloat(Ly,12) << '\n';
     outFile << "c-axis " << LICHEMFormFloat(Lz,12) << '\n';
-    outFile << "alpha 90.0" << '\n';
-    outFile << "beta 90.0" << '\n';
-    outFile << "gamma 90.0" << '\n';
+    outFile << "alpha " << LICHEMFormFloat(boxAlpha,12) << '\n';
+    outFile << "beta " << LICHEMFormFloat(boxBeta,12) << '\n';
+    outFile << "gamma " << LICHEMFormFloat(boxGamma,12) << '\n';
   }
   if (QMMMOpts.useImpSolv)
   {
@@ -975,7 +990,9 @@ double TINKERMMForces(vector<QMMMAtom>& QMMMData, VectorXd& forces,
     outFile << LICHEMFormFloat(Lx,12) << " ";
     outFile << LICHEMFormFloat(Ly,12) << " ";
     outFile << LICHEMFormFloat(Lz,12) << " ";
-    outFile << "90.0 90.0 90.0";
+    outFile << LICHEMFormFloat(boxAlpha,12) << " ";
+    outFile << LICHEMFormFloat(boxBeta,12) << " ";
+    outFile << LICHEMFormFloat(boxGamma,12);
     outFile << '\n';
   }
   for (int i=0;i<Natoms;i++)
@@ -1133,9 +1150,9 @@ double TINKERPolForces(vector<QMMMAtom>& QMMMData, VectorXd& forces,
     outFile << "a-axis " << LICHEMFormFloat(Lx,12) << '\n';
     outFile << "b-axis " << LICHEMFormFloat(Ly,12) << '\n';
     outFile << "c-axis " << LICHEMFormFloat(Lz,12) << '\n';
-    outFile << "alpha 90.0" << '\n';
-    outFile << "beta 90.0" << '\n';
-    outFile << "gamma 90.0" << '\n';
+    outFile << "alpha " << LICHEMFormFloat(boxAlpha,12) << '\n';
+    outFile << "beta " << LICHEMFormFloat(boxBeta,12) << '\n';
+    outFile << "gamma " << LICHEMFormFloat(boxGamma,12) << '\n';
   }
   if (AMOEBA)
   {
@@ -1230,7 +1247,9 @@ double TINKERPolForces(vector<QMMMAtom>& QMMMData, VectorXd& forces,
     outFile << LICHEMFormFloat(Lx,12) << " ";
     outFile << LICHEMFormFloat(Ly,12) << " ";
     outFile << LICHEMFormFloat(Lz,12) << " ";
-    outFile << "90.0 90.0 90.0";
+    outFile << LICHEMFormFloat(boxAlpha,12) << " ";
+    outFile << LICHEMFormFloat(boxBeta,12) << " ";
+    outFile << LICHEMFormFloat(boxGamma,12);
     outFile << '\n';
   }
   ct = 0; //Counter for QM atoms
@@ -1386,9 +1405,9 @@ double TINKEREnergy(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
     outFile << "a-axis " << LICHEMFormFloat(Lx,12) << '\n';
     outFile << "b-axis " << LICHEMFormFloat(Ly,12) << '\n';
     outFile << "c-axis " << LICHEMFormFloat(Lz,12) << '\n';
-    outFile << "alpha 90.0" << '\n';
-    outFile << "beta 90.0" << '\n';
-    outFile << "gamma 90.0" << '\n';
+    outFile << "alpha " << LICHEMFormFloat(boxAlpha,12) << '\n';
+    outFile << "beta " << LICHEMFormFloat(boxBeta,12) << '\n';
+    outFile << "gamma " << LICHEMFormFloat(boxGamma,12) << '\n';
   }
   if (QMMM)
   {
@@ -1482,7 +1501,9 @@ double TINKEREnergy(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
     outFile << LICHEMFormFloat(Lx,12) << " ";
     outFile << LICHEMFormFloat(Ly,12) << " ";
     outFile << LICHEMFormFloat(Lz,12) << " ";
-    outFile << "90.0 90.0 90.0";
+    outFile << LICHEMFormFloat(boxAlpha,12) << " ";
+    outFile << LICHEMFormFloat(boxBeta,12) << " ";
+    outFile << LICHEMFormFloat(boxGamma,12);
     outFile << '\n';
   }
   ct = 0; //Counter for QM atoms
@@ -1619,9 +1640,9 @@ MatrixXd TINKERHessian(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
     outFile << "a-axis " << LICHEMFormFloat(Lx,12) << '\n';
     outFile << "b-axis " << LICHEMFormFloat(Ly,12) << '\n';
     outFile << "c-axis " << LICHEMFormFloat(Lz,12) << '\n';
-    outFile << "alpha 90.0" << '\n';
-    outFile << "beta 90.0" << '\n';
-    outFile << "gamma 90.0" << '\n';
+    outFile << "alpha " << LICHEMFormFloat(boxAlpha,12) << '\n';
+    outFile << "beta " << LICHEMFormFloat(boxBeta,12) << '\n';
+    outFile << "gamma " << LICHEMFormFloat(boxGamma,12) << '\n';
   }
   ct = 0; //Generic counter
   for (int i=0;i<Natoms;i++)
@@ -1732,7 +1753,9 @@ MatrixXd TINKERHessian(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts,
     outFile << LICHEMFormFloat(Lx,12) << " ";
     outFile << LICHEMFormFloat(Ly,12) << " ";
     outFile << LICHEMFormFloat(Lz,12) << " ";
-    outFile << "90.0 90.0 90.0";
+    outFile << LICHEMFormFloat(boxAlpha,12) << " ";
+    outFile << LICHEMFormFloat(boxBeta,12) << " ";
+    outFile << LICHEMFormFloat(boxGamma,12);
     outFile << '\n';
   }
   ct = 0; //Counter for QM atoms
@@ -1920,9 +1943,9 @@ double TINKEROpt(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts, int bead)
     outFile << "a-axis " << LICHEMFormFloat(Lx,12) << '\n';
     outFile << "b-axis " << LICHEMFormFloat(Ly,12) << '\n';
     outFile << "c-axis " << LICHEMFormFloat(Lz,12) << '\n';
-    outFile << "alpha 90.0" << '\n';
-    outFile << "beta 90.0" << '\n';
-    outFile << "gamma 90.0" << '\n';
+    outFile << "alpha " << LICHEMFormFloat(boxAlpha,12) << '\n';
+    outFile << "beta " << LICHEMFormFloat(boxBeta,12) << '\n';
+    outFile << "gamma " << LICHEMFormFloat(boxGamma,12) << '\n';
   }
   ct = 0; //Generic counter
   if (QMMM or (Nfreeze > 0))
@@ -2041,7 +2064,9 @@ double TINKEROpt(vector<QMMMAtom>& QMMMData, QMMMSettings& QMMMOpts, int bead)
     outFile << LICHEMFormFloat(Lx,12) << " ";
     outFile << LICHEMFormFloat(Ly,12) << " ";
     outFile << LICHEMFormFloat(Lz,12) << " ";
-    outFile << "90.0 90.0 90.0";
+    outFile << LICHEMFormFloat(boxAlpha,12) << " ";
+    outFile << LICHEMFormFloat(boxBeta,12) << " ";
+    outFile << LICHEMFormFloat(boxGamma,12);
     outFile << '\n';
   }
   ct = 0; //Counter for QM atoms